@@ -0,0 +1,327 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/*
+ * Native Python extension of Harry. The extension uses the library
+ * interface of Harry to compare strings in-process with released GIL and
+ * returns a numpy array that owns the matrix buffer. It is used by
+ * harry.py if available.
+ */
+
+#include <Python.h>
+#define NPY_NO_DEPRECATED_API NPY_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "harryapi.h"
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+/* Number of rows computed at once for symmetric matrices */
+#define TILE_ROWS       64
+
+/**
+ * Strings converted from Python
+ */
+typedef struct
+{
+    const char **strs;          /**< Pointers to strings */
+    size_t *lens;               /**< Lengths of strings */
+    PyObject **refs;            /**< Objects owning the strings */
+    int num;                    /**< Number of strings */
+} strings_t;
+
+/**
+ * Add strings of a Python sequence. Strings, bytes and objects supporting
+ * the buffer protocol, such as numpy byte strings, are accepted. The data
+ * is referenced and only copied when the strings are prepared.
+ * @param s Converted strings
+ * @param list Python sequence
+ * @return true on success, false otherwise
+ */
+static int strings_add(strings_t *s, PyObject *list)
+{
+    PyObject *seq, *o;
+    Py_buffer view;
+    int i, n;
+
+    seq = PySequence_Fast(list, "Strings must be a sequence");
+    if (!seq)
+        return FALSE;
+
+    n = PySequence_Fast_GET_SIZE(seq);
+    s->strs = realloc(s->strs, (s->num + n + 1) * sizeof(char *));
+    s->lens = realloc(s->lens, (s->num + n + 1) * sizeof(size_t));
+    s->refs = realloc(s->refs, (s->num + n + 1) * sizeof(PyObject *));
+    if (!s->strs || !s->lens || !s->refs) {
+        Py_DECREF(seq);
+        PyErr_NoMemory();
+        return FALSE;
+    }
+
+    for (i = 0; i < n; i++) {
+        o = PySequence_Fast_GET_ITEM(seq, i);
+        if (PyUnicode_Check(o)) {
+            o = PyUnicode_AsUTF8String(o);
+            if (!o)
+                break;
+        } else {
+            Py_INCREF(o);
+        }
+
+        if (PyObject_GetBuffer(o, &view, PyBUF_SIMPLE) < 0) {
+            Py_DECREF(o);
+            PyErr_SetString(PyExc_TypeError,
+                            "Strings must be str, bytes or byte arrays");
+            break;
+        }
+
+        /* The data stays valid as long as the object is referenced */
+        s->strs[s->num] = view.buf;
+        s->lens[s->num] = view.len;
+        s->refs[s->num++] = o;
+        PyBuffer_Release(&view);
+    }
+
+    Py_DECREF(seq);
+    return i == n;
+}
+
+/**
+ * Release converted strings
+ * @param s Converted strings
+ */
+static void strings_free(strings_t *s)
+{
+    int i;
+
+    for (i = 0; i < s->num; i++)
+        Py_DECREF(s->refs[i]);
+    free(s->strs);
+    free(s->lens);
+    free(s->refs);
+}
+
+/**
+ * Convert a Python object to a bytes object for a setting
+ * @param o Python object
+ * @return new reference to bytes object or NULL on error
+ */
+static PyObject *to_bytes(PyObject *o)
+{
+    PyObject *s, *b;
+
+    if (PyBool_Check(o))
+        return PyBytes_FromString(o == Py_True ? "true" : "false");
+    if (PyBytes_Check(o)) {
+        Py_INCREF(o);
+        return o;
+    }
+    if (PyUnicode_Check(o))
+        return PyUnicode_AsUTF8String(o);
+
+    s = PyObject_Str(o);
+    if (!s)
+        return NULL;
+    b = to_bytes(s);
+    Py_DECREF(s);
+    return b;
+}
+
+/**
+ * Apply a dictionary of configuration settings to a context
+ * @param ctx Context
+ * @param d Dictionary mapping paths to values
+ * @return true on success, false otherwise
+ */
+static int apply_options(harry_ctx_t *ctx, PyObject *d)
+{
+    PyObject *key, *val, *k, *v;
+    Py_ssize_t pos = 0;
+    int r;
+
+    while (PyDict_Next(d, &pos, &key, &val)) {
+        k = to_bytes(key);
+        v = to_bytes(val);
+        r = k && v &&
+            harry_ctx_set(ctx, PyBytes_AsString(k), PyBytes_AsString(v));
+        Py_XDECREF(k);
+        Py_XDECREF(v);
+
+        if (!r) {
+            if (!PyErr_Occurred())
+                PyErr_SetString(PyExc_ValueError,
+                                "Invalid configuration setting");
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Compute a matrix of similarity values. If no second set of strings is
+ * given, the symmetric matrix is computed in tiles of rows and mirrored.
+ * @param ctx Context
+ * @param nx Number of strings in first set
+ * @param ny Number of strings in second set or -1
+ * @param buf Matrix in row-major order
+ * @return true on success, false otherwise
+ */
+static int compute(harry_ctx_t *ctx, int nx, int ny, float *buf)
+{
+    int r, c, r0, r1;
+    float *tile;
+
+    if (ny >= 0)
+        return harry_compare_block(ctx, 0, nx, nx, nx + ny, buf) >= 0;
+
+    for (r0 = 0; r0 < nx; r0 = r1) {
+        r1 = r0 + TILE_ROWS < nx ? r0 + TILE_ROWS : nx;
+
+        /* Compute right part of the tile as one block */
+        tile = malloc(sizeof(float) * (r1 - r0) * (nx - r0));
+        if (!tile || harry_compare_block(ctx, r0, r1, r0, nx, tile) < 0) {
+            free(tile);
+            return FALSE;
+        }
+
+        for (r = r0; r < r1; r++) {
+            for (c = r; c < nx; c++) {
+                float f = tile[(long) (r - r0) * (nx - r0) + (c - r0)];
+                buf[(long) r * nx + c] = f;
+                buf[(long) c * nx + r] = f;
+            }
+        }
+        free(tile);
+    }
+
+    return TRUE;
+}
+
+/**
+ * Free the matrix buffer owned by a numpy array
+ * @param c Capsule holding the buffer
+ */
+static void free_buffer(PyObject *c)
+{
+    free(PyCapsule_GetPointer(c, NULL));
+}
+
+/**
+ * Python function: compare(x, y, options, config_file=None)
+ * @param self Module
+ * @param args Arguments
+ * @return numpy array or NULL on error
+ */
+static PyObject *py_compare(PyObject *self, PyObject *args)
+{
+    PyObject *x, *y, *dict, *capsule, *array = NULL;
+    const char *file = NULL;
+    strings_t s = { NULL, NULL, NULL, 0 };
+    harry_ctx_t *ctx = NULL;
+    int nx, ny = -1, ok;
+    npy_intp dims[2];
+    float *buf = NULL;
+
+    if (!PyArg_ParseTuple(args, "OOO!|z", &x, &y, &PyDict_Type, &dict,
+                          &file))
+        return NULL;
+
+    /* Convert strings and options while holding the GIL */
+    if (!strings_add(&s, x))
+        goto out;
+    nx = s.num;
+    if (y != Py_None) {
+        if (!strings_add(&s, y))
+            goto out;
+        ny = s.num - nx;
+    }
+
+    ctx = harry_ctx_new(file);
+    if (!ctx) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not create context");
+        goto out;
+    }
+    if (!apply_options(ctx, dict))
+        goto out;
+
+    dims[0] = nx;
+    dims[1] = ny >= 0 ? ny : nx;
+    buf = malloc(sizeof(float) * (dims[0] * dims[1] + 1));
+    if (!buf) {
+        PyErr_NoMemory();
+        goto out;
+    }
+
+    /* Compute matrix without GIL */
+    Py_BEGIN_ALLOW_THREADS;
+    ok = harry_prepare(ctx, s.strs, s.lens, s.num) &&
+        compute(ctx, nx, ny, buf);
+    Py_END_ALLOW_THREADS;
+
+    if (!ok) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not compute matrix");
+        goto out;
+    }
+
+    /* Wrap buffer without copying */
+    array = PyArray_SimpleNewFromData(2, dims, NPY_FLOAT32, buf);
+    if (!array)
+        goto out;
+    capsule = PyCapsule_New(buf, NULL, free_buffer);
+    if (!capsule) {
+        Py_CLEAR(array);
+        goto out;
+    }
+
+    /* The array steals the capsule which owns the buffer */
+    buf = NULL;
+    if (PyArray_SetBaseObject((PyArrayObject *) array, capsule) < 0)
+        Py_CLEAR(array);
+
+  out:
+    free(buf);
+    harry_ctx_free(ctx);
+    strings_free(&s);
+    return array;
+}
+
+static PyMethodDef methods[] = {
+    {"compare", py_compare, METH_VARARGS,
+     "compare(x, y, options, config_file=None) -> ndarray\n\n"
+     "Compare the strings in x with the strings in y or, if y is None,\n"
+     "with themselves using the configuration settings in options."},
+    {NULL, NULL, 0, NULL}
+};
+
+#if PY_MAJOR_VERSION >= 3
+static struct PyModuleDef module = {
+    PyModuleDef_HEAD_INIT, "_harry", NULL, -1, methods
+};
+
+PyMODINIT_FUNC PyInit__harry(void)
+{
+    import_array();
+    return PyModule_Create(&module);
+}
+#else
+PyMODINIT_FUNC init_harry(void)
+{
+    import_array();
+    Py_InitModule("_harry", methods);
+}
+#endif
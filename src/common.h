@@ -32,6 +32,7 @@
 #include <stddef.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <math.h>
 #include <float.h>
@@ -0,0 +1,185 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/*
+ * Small tool for extracting rows and submatrices from chunked files
+ * written by the output module "chunk" of Harry.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "hchunk.h"
+
+/* Global variables */
+int verbose = 0;
+int log_line = 0;
+config_t cfg;
+
+static int print_info = 0;
+static char *rows = "";
+static char *cols = "";
+static char *separator = ",";
+
+/* Option string */
+static char *short_opts = "ir:c:s:hV";
+
+/**
+ * Array of options of getopt_long()
+ */
+static struct option long_opts[] = {
+    {"info", 0, NULL, 'i'},
+    {"rows", 1, NULL, 'r'},
+    {"cols", 1, NULL, 'c'},
+    {"separator", 1, NULL, 's'},
+    {"help", 0, NULL, 'h'},
+    {"version", 0, NULL, 'V'},
+    {NULL, 0, NULL, 0}
+};
+
+/**
+ * Print usage of tool
+ */
+static void print_usage(void)
+{
+    printf("Usage: harry-chunk [options] <file>\n"
+           "\nOptions:\n"
+           "  -i,  --info                   Print header and band index.\n"
+           "  -r,  --rows <start>:<end>     Set range of rows to extract.\n"
+           "  -c,  --cols <start>:<end>     Set range of columns to extract.\n"
+           "  -s,  --separator <str>        Set separator of values.\n"
+           "  -h,  --help                   Print this help screen.\n"
+           "  -V,  --version                Print version.\n\n");
+}
+
+/**
+ * Parse a range string of the form start:end. Missing values are
+ * replaced by the defaults.
+ * @param s Range string
+ * @param n Maximum size
+ * @param start Return pointer to start of range
+ * @param end Return pointer to end of range
+ */
+static void parse_range(char *s, int n, int *start, int *end)
+{
+    char *ptr = strchr(s, ':');
+
+    *start = 0;
+    *end = n;
+
+    if (strlen(s) == 0)
+        return;
+
+    if (!ptr)
+        fatal("Invalid range string '%s'.", s);
+
+    if (ptr != s)
+        *start = atoi(s);
+    if (*(ptr + 1) != '\0')
+        *end = atoi(ptr + 1);
+}
+
+/**
+ * Print header and band index of a chunked file
+ * @param c Chunked file
+ */
+static void chunk_info(hchunk_t *c)
+{
+    hchunk_header_t *h = &c->hdr;
+    int b;
+
+    printf("# version %u, %u x %u, %s, %s\n", h->version, h->rows, h->cols,
+           h->flags & HCHUNK_TRIANGULAR ? "triangular" : "rectangular",
+           h->flags & HCHUNK_ZLIB ? "zlib" : "uncompressed");
+    printf("# rows %u:%u, cols %u:%u, %u bands of %u rows\n",
+           h->row_start, h->row_start + h->rows, h->col_start,
+           h->col_start + h->cols, h->num_bands, h->band_rows);
+
+    for (b = 0; b < (int) h->num_bands; b++)
+        printf("%d %llu %llu %llu\n", b,
+               (unsigned long long) c->index[b].offset,
+               (unsigned long long) c->index[b].size,
+               (unsigned long long) c->index[b].length);
+}
+
+/**
+ * Main function
+ * @param argc Number of arguments
+ * @param argv Argument values
+ * @return Exit code
+ */
+int main(int argc, char **argv)
+{
+    int ch, r0, r1, c0, c1, i, j;
+    hchunk_t *c;
+    float *out;
+
+    while ((ch = getopt_long(argc, argv, short_opts, long_opts, NULL)) != -1) {
+        switch (ch) {
+        case 'i':
+            print_info = 1;
+            break;
+        case 'r':
+            rows = optarg;
+            break;
+        case 'c':
+            cols = optarg;
+            break;
+        case 's':
+            separator = optarg;
+            break;
+        case 'V':
+            printf("Harry %s - Chunked file reader\n", PACKAGE_VERSION);
+            exit(EXIT_SUCCESS);
+        case 'h':
+            print_usage();
+            exit(EXIT_SUCCESS);
+        default:
+            print_usage();
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (argc - optind != 1) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    c = hchunk_open(argv[optind]);
+    if (!c)
+        exit(EXIT_FAILURE);
+
+    if (print_info) {
+        chunk_info(c);
+        hchunk_close(c);
+        return EXIT_SUCCESS;
+    }
+
+    parse_range(rows, c->hdr.rows, &r0, &r1);
+    parse_range(cols, c->hdr.cols, &c0, &c1);
+
+    out = malloc(sizeof(float) * MAX((long) (r1 - r0) * (c1 - c0), 1));
+    if (!out)
+        fatal("Could not allocate memory for submatrix");
+
+    if (hchunk_read(c, r0, r1, c0, c1, out) < 0)
+        exit(EXIT_FAILURE);
+
+    for (i = 0; i < r1 - r0; i++) {
+        for (j = 0; j < c1 - c0; j++)
+            printf("%g%s", out[(long) i * (c1 - c0) + j],
+                   j < c1 - c0 - 1 ? separator : "\n");
+    }
+
+    free(out);
+    hchunk_close(c);
+    return EXIT_SUCCESS;
+}
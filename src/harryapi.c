@@ -0,0 +1,319 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/**
+ * @defgroup api Library interface
+ * Interface for embedding Harry in other programs. A context holds the
+ * configuration, the prepared strings, the value cache, the settings of
+ * preprocessing and an instance of the configured measure, such that
+ * several measures can be used in one process.
+ *
+ * The measure is configured when a context is created or changed, and
+ * the comparison functions only read the context. Different contexts can
+ * thus be used concurrently from multiple threads, and one context can be
+ * compared from several threads at once. A context must not be changed
+ * using harry_ctx_set() or harry_prepare() while another call uses it.
+ * A block of values is computed using the number of threads configured
+ * for the context. The scratch memory and the compression engines are
+ * kept per thread by OpenMP; without OpenMP, the interface must not be
+ * called concurrently.
+ * @{
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "hconfig.h"
+#include "hstring.h"
+#include "vcache.h"
+#include "hmatrix.h"
+#include "measures.h"
+#include "harryapi.h"
+
+/* Global variables used by the modules of Harry */
+int verbose = 0;
+int log_line = 0;
+config_t cfg;
+
+/**
+ * Context of the library interface
+ */
+struct harry_ctx
+{
+    config_t cfg;               /**< Configuration */
+    vcache_t cache;             /**< Value cache */
+    hprep_t prep;               /**< Settings of preprocessing */
+    hmeasure_t measure;         /**< Instance of measure */
+    int configured;             /**< Flag for configured context */
+    int threads;                /**< Number of threads */
+    hstring_t *strs;            /**< Prepared strings */
+    int num;                    /**< Number of strings */
+};
+
+/**
+ * Configure a context. The value cache is cleared and the measure is
+ * configured from the settings of the context.
+ * @param ctx Context
+ */
+static void ctx_config(harry_ctx_t *ctx)
+{
+    const char *str;
+    cfg_int threads = 0;
+
+    if (ctx->configured) {
+        measure_destroy_r(&ctx->measure);
+        vcache_destroy_r(&ctx->cache);
+    }
+
+    vcache_init_r(&ctx->cache, &ctx->cfg);
+    hstring_prep_init(&ctx->prep, &ctx->cfg);
+    measure_init_r(&ctx->measure, &ctx->cfg, &ctx->cache, &ctx->prep);
+
+    config_lookup_string(&ctx->cfg, "measures.measure", &str);
+    measure_config_r(&ctx->measure, str);
+
+    config_lookup_int(&ctx->cfg, "measures.num_threads", &threads);
+#ifdef HAVE_OPENMP
+    if (threads <= 0)
+        threads = omp_get_num_procs();
+#endif
+    ctx->threads = MAX(threads, 1);
+    ctx->configured = TRUE;
+}
+
+/**
+ * Create a new context
+ * @param file Configuration file or NULL for the default configuration
+ * @return context or NULL on error
+ */
+harry_ctx_t *harry_ctx_new(const char *file)
+{
+    harry_ctx_t *ctx = calloc(1, sizeof(harry_ctx_t));
+    if (!ctx) {
+        error("Could not allocate context");
+        return NULL;
+    }
+
+    config_init(&ctx->cfg);
+    if (file && config_read_file(&ctx->cfg, file) != CONFIG_TRUE) {
+        error("Could not read configuration (%s in line %d)",
+              config_error_text(&ctx->cfg), config_error_line(&ctx->cfg));
+        goto err;
+    }
+
+    if (!config_check(&ctx->cfg))
+        goto err;
+
+    ctx_config(ctx);
+    return ctx;
+
+  err:
+    config_destroy(&ctx->cfg);
+    free(ctx);
+    return NULL;
+}
+
+/**
+ * Change a configuration setting of a context. The value is converted
+ * according to the type of the setting and the measure is configured
+ * again. Changes of the input settings take effect at the next call of
+ * harry_prepare().
+ * @param ctx Context
+ * @param path Path of setting, e.g. "measures.measure"
+ * @param value Value of setting
+ * @return true on success, false otherwise
+ */
+int harry_ctx_set(harry_ctx_t *ctx, const char *path, const char *value)
+{
+    config_setting_t *s;
+    int ret = TRUE;
+
+    s = config_lookup(&ctx->cfg, path);
+    if (!s) {
+        error("Unknown configuration setting '%s'", path);
+        return FALSE;
+    }
+
+    switch (config_setting_type(s)) {
+    case CONFIG_TYPE_STRING:
+        config_setting_set_string(s, value);
+        break;
+    case CONFIG_TYPE_INT:
+        config_setting_set_int(s, atoi(value));
+        break;
+    case CONFIG_TYPE_FLOAT:
+        config_setting_set_float(s, atof(value));
+        break;
+    case CONFIG_TYPE_BOOL:
+        config_setting_set_bool(s, !strcasecmp(value, "true") ||
+                                !strcmp(value, "1"));
+        break;
+    default:
+        error("Unsupported type of setting '%s'", path);
+        ret = FALSE;
+        break;
+    }
+
+    ctx_config(ctx);
+    return ret;
+}
+
+/**
+ * Destroy the prepared strings of a context
+ * @param ctx Context
+ */
+static void ctx_strings_free(harry_ctx_t *ctx)
+{
+    for (int i = 0; i < ctx->num; i++)
+        hstring_destroy(&ctx->strs[i]);
+    free(ctx->strs);
+    ctx->strs = NULL;
+    ctx->num = 0;
+}
+
+/**
+ * Destroy a context
+ * @param ctx Context
+ */
+void harry_ctx_free(harry_ctx_t *ctx)
+{
+    if (!ctx)
+        return;
+
+    if (ctx->configured) {
+        measure_destroy_r(&ctx->measure);
+        vcache_destroy_r(&ctx->cache);
+    }
+
+    ctx_strings_free(ctx);
+    config_destroy(&ctx->cfg);
+    free(ctx);
+}
+
+/**
+ * Prepare strings for comparison. The strings are copied and preprocessed
+ * according to the configuration of the context. Previously prepared
+ * strings are released.
+ * @param ctx Context
+ * @param strs Array of strings
+ * @param lens Array of lengths or NULL for null-terminated strings
+ * @param num Number of strings
+ * @return true on success, false otherwise
+ */
+int harry_prepare(harry_ctx_t *ctx, const char **strs, const size_t *lens,
+                  int num)
+{
+    const char *file;
+    int i;
+
+    ctx_strings_free(ctx);
+
+    ctx->strs = calloc(MAX(num, 1), sizeof(hstring_t));
+    if (!ctx->strs) {
+        error("Could not allocate strings");
+        return FALSE;
+    }
+
+    config_lookup_string(&ctx->cfg, "input.stoptoken_file", &file);
+    if (strlen(file) > 0)
+        stoptokens_load_r(&ctx->prep, file);
+
+    for (i = 0; i < num; i++) {
+        size_t len = lens ? lens[i] : strlen(strs[i]);
+        hstring_t *x = &ctx->strs[i];
+
+        x->str.c = malloc(len + 1);
+        if (!x->str.c) {
+            error("Could not allocate string");
+            break;
+        }
+        memcpy(x->str.c, strs[i], len);
+        x->str.c[len] = 0;
+        x->len = len;
+        x->type = TYPE_BYTE;
+        *x = hstring_preproc_r(&ctx->prep, *x);
+        ctx->num++;
+    }
+
+    if (strlen(file) > 0)
+        stoptokens_destroy_r(&ctx->prep);
+
+    return ctx->num == num;
+}
+
+/**
+ * Return the number of prepared strings
+ * @param ctx Context
+ * @return number of strings
+ */
+int harry_num_strings(harry_ctx_t *ctx)
+{
+    return ctx->num;
+}
+
+/**
+ * Compare two prepared strings
+ * @param ctx Context
+ * @param i Index of first string
+ * @param j Index of second string
+ * @return similarity/dissimilarity value or NAN on error
+ */
+float harry_compare(harry_ctx_t *ctx, int i, int j)
+{
+    if (i < 0 || j < 0 || i >= ctx->num || j >= ctx->num)
+        return NAN;
+
+    return measure_compare_r(&ctx->measure, ctx->strs[i], ctx->strs[j]);
+}
+
+/**
+ * Compare a block of prepared strings. The values are computed in
+ * parallel using the threads of the context and stored in row-major
+ * order, that is, out[(r - r0) * (c1 - c0) + (c - c0)].
+ * @param ctx Context
+ * @param r0 Start of rows (inclusive)
+ * @param r1 End of rows (exclusive)
+ * @param c0 Start of columns (inclusive)
+ * @param c1 End of columns (exclusive)
+ * @param out Array of (r1 - r0) * (c1 - c0) floats
+ * @return number of computed values or -1 on error
+ */
+int harry_compare_block(harry_ctx_t *ctx, int r0, int r1, int c0, int c1,
+                        float *out)
+{
+    long k, n, tiles, cols = c1 - c0;
+
+    if (r0 < 0 || c0 < 0 || r1 < r0 || c1 < c0 || r1 > ctx->num ||
+        c1 > ctx->num) {
+        error("Invalid block %d:%d x %d:%d", r0, r1, c0, c1);
+        return -1;
+    }
+
+    /* Each row is compared in tiles of columns */
+    tiles = (cols + HMATRIX_TILE - 1) / HMATRIX_TILE;
+    n = (long) (r1 - r0) * tiles;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(ctx->threads)
+#endif
+    for (k = 0; k < n; k++) {
+        long r = r0 + k / tiles;
+        long c = c0 + (k % tiles) * HMATRIX_TILE;
+        long num = MIN(HMATRIX_TILE, c1 - c);
+
+        measure_compare_batch_r(&ctx->measure, ctx->strs[r], ctx->strs + c,
+                                num, out + (r - r0) * cols + (c - c0));
+    }
+
+    return (r1 - r0) * cols;
+}
+
+/** @} */
@@ -0,0 +1,36 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef HARRYAPI_H
+#define HARRYAPI_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Opaque context holding configuration, strings and cache */
+typedef struct harry_ctx harry_ctx_t;
+
+harry_ctx_t *harry_ctx_new(const char *);
+int harry_ctx_set(harry_ctx_t *, const char *, const char *);
+void harry_ctx_free(harry_ctx_t *);
+int harry_prepare(harry_ctx_t *, const char **, const size_t *, int);
+int harry_num_strings(harry_ctx_t *);
+float harry_compare(harry_ctx_t *, int, int);
+int harry_compare_block(harry_ctx_t *, int, int, int, int, float *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARRYAPI_H */
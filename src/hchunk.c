@@ -0,0 +1,243 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/**
+ * @defgroup chunk Chunked matrix files
+ * Functions for reading matrices stored in the chunked format. A chunked
+ * file consists of a header, a sequence of row bands and an index of the
+ * bands at the end of the file. Each band is optionally compressed using
+ * zlib, such that rows and submatrices can be extracted without reading
+ * the whole file.
+ * <pre>
+ * | header | band 0 | band 1 | ... | index (offset, size, length) ... |
+ * </pre>
+ * Symmetric matrices are stored as packed upper triangle, where row i
+ * holds the values from column i to the last column.
+ * @{
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "hchunk.h"
+
+/**
+ * Return the offset of a band in the layout of the matrix values
+ * @param h Header of chunked file
+ * @param b Index of band
+ * @return offset in number of values
+ */
+uint64_t hchunk_band_offset(hchunk_header_t *h, int b)
+{
+    uint64_t i = (uint64_t) b * h->band_rows;
+
+    if (h->flags & HCHUNK_TRIANGULAR)
+        return i * h->cols - i * (i - 1) / 2;
+    return i * h->cols;
+}
+
+/**
+ * Return the length of a band in number of values
+ * @param h Header of chunked file
+ * @param b Index of band
+ * @return length in number of values
+ */
+uint64_t hchunk_band_length(hchunk_header_t *h, int b)
+{
+    uint64_t end;
+
+    if (b + 1 >= (int) h->num_bands) {
+        if (h->flags & HCHUNK_TRIANGULAR)
+            end = (uint64_t) h->cols * (h->cols + 1) / 2;
+        else
+            end = (uint64_t) h->rows * h->cols;
+    } else {
+        end = hchunk_band_offset(h, b + 1);
+    }
+
+    return end - hchunk_band_offset(h, b);
+}
+
+/**
+ * Open a chunked file for reading. Only the header and the index of
+ * bands are read.
+ * @param fn File name
+ * @return chunked file or NULL on error
+ */
+hchunk_t *hchunk_open(const char *fn)
+{
+    hchunk_t *c;
+    size_t len;
+
+    c = calloc(1, sizeof(hchunk_t));
+    if (!c) {
+        error("Could not allocate chunked file");
+        return NULL;
+    }
+
+    c->fd = open(fn, O_RDONLY);
+    if (c->fd < 0) {
+        error("Could not open chunked file '%s'", fn);
+        free(c);
+        return NULL;
+    }
+
+    if (pread(c->fd, &c->hdr, sizeof(c->hdr), 0) != sizeof(c->hdr) ||
+        memcmp(c->hdr.magic, HCHUNK_MAGIC, 8) ||
+        c->hdr.version != HCHUNK_VERSION ||
+        c->hdr.dtype != HCHUNK_FLOAT32 || c->hdr.index == 0) {
+        error("Invalid or incomplete chunked file '%s'", fn);
+        hchunk_close(c);
+        return NULL;
+    }
+
+    len = sizeof(hchunk_entry_t) * c->hdr.num_bands;
+    c->index = malloc(MAX(len, 1));
+    if (!c->index ||
+        pread(c->fd, c->index, len, c->hdr.index) != (ssize_t) len) {
+        error("Could not read index of chunked file '%s'", fn);
+        hchunk_close(c);
+        return NULL;
+    }
+
+    return c;
+}
+
+/**
+ * Read and decompress a band of a chunked file
+ * @param c Chunked file
+ * @param b Index of band
+ * @return array of values (to be freed) or NULL on error
+ */
+float *hchunk_read_band(hchunk_t *c, int b)
+{
+    hchunk_entry_t *e;
+    uLongf len;
+    char *buf;
+    float *v;
+
+    assert(c && b >= 0 && b < (int) c->hdr.num_bands);
+    e = &c->index[b];
+
+    v = malloc(MAX(e->length, 1));
+    buf = e->size == e->length ? (char *) v : malloc(MAX(e->size, 1));
+    if (!v || !buf) {
+        error("Could not allocate memory for band %d", b);
+        goto err;
+    }
+
+    if (pread(c->fd, buf, e->size, e->offset) != (ssize_t) e->size) {
+        error("Could not read band %d", b);
+        goto err;
+    }
+
+    if (buf != (char *) v) {
+        len = e->length;
+        if (uncompress((Bytef *) v, &len, (Bytef *) buf, e->size) != Z_OK
+            || len != e->length) {
+            error("Could not decompress band %d", b);
+            goto err;
+        }
+        free(buf);
+    }
+
+    return v;
+
+  err:
+    if (buf != (char *) v)
+        free(buf);
+    free(v);
+    return NULL;
+}
+
+/**
+ * Extract a submatrix from a chunked file. Only bands containing values
+ * of the submatrix are read. The indices are relative to the first row
+ * and column of the stored matrix.
+ * @param c Chunked file
+ * @param r0 First row (inclusive)
+ * @param r1 Last row (exclusive)
+ * @param c0 First column (inclusive)
+ * @param c1 Last column (exclusive)
+ * @param out Array of (r1 - r0) * (c1 - c0) values in row-major order
+ * @return number of extracted values or -1 on error
+ */
+long hchunk_read(hchunk_t *c, int r0, int r1, int c0, int c1, float *out)
+{
+    hchunk_header_t *h = &c->hdr;
+    long w = c1 - c0, b0, b1, i, j, k, off;
+    int b, tri = h->flags & HCHUNK_TRIANGULAR;
+    float *v, *row;
+
+    if (r0 < 0 || r1 > (int) h->rows || r0 > r1 ||
+        c0 < 0 || c1 > (int) h->cols || c0 > c1) {
+        error("Invalid submatrix [%d:%d, %d:%d]", r0, r1, c0, c1);
+        return -1;
+    }
+
+    for (b = 0; b < (int) h->num_bands; b++) {
+        b0 = (long) b * h->band_rows;
+        b1 = MIN(b0 + h->band_rows, (long) h->rows);
+
+        /* Skip bands without requested values */
+        if ((b1 <= r0 || b0 >= r1) &&
+            (!tri || b1 <= c0 || b0 >= c1 || b0 >= r1))
+            continue;
+
+        v = hchunk_read_band(c, b);
+        if (!v)
+            return -1;
+
+        for (k = b0, off = 0; k < b1; k++) {
+            row = v + off;
+
+            if (!tri) {
+                if (k >= r0 && k < r1)
+                    memcpy(out + (k - r0) * w, row + c0, w * sizeof(float));
+                off += h->cols;
+                continue;
+            }
+
+            /* Row k holds the values of columns k to cols - 1 */
+            if (k >= r0 && k < r1)
+                for (j = MAX(k, c0); j < c1; j++)
+                    out[(k - r0) * w + j - c0] = row[j - k];
+
+            /* ... which are also the values of column k below row k */
+            if (k >= c0 && k < c1)
+                for (i = MAX(k + 1, r0); i < r1; i++)
+                    out[(i - r0) * w + k - c0] = row[i - k];
+
+            off += h->cols - k;
+        }
+
+        free(v);
+    }
+
+    return (long) (r1 - r0) * w;
+}
+
+/**
+ * Close a chunked file
+ * @param c Chunked file
+ */
+void hchunk_close(hchunk_t *c)
+{
+    if (!c)
+        return;
+
+    if (c->fd >= 0)
+        close(c->fd);
+    free(c->index);
+    free(c);
+}
+
+/** @} */
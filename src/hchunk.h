@@ -0,0 +1,78 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef HCHUNK_H
+#define HCHUNK_H
+
+#include <stdint.h>
+
+/** Magic string of chunked files */
+#define HCHUNK_MAGIC        "HARRYCHK"
+/** Version of chunked format */
+#define HCHUNK_VERSION      1
+
+/* Data types */
+#define HCHUNK_FLOAT32      1
+
+/* Flags */
+#define HCHUNK_TRIANGULAR   0x01        /* Packed upper triangle */
+#define HCHUNK_ZLIB         0x02        /* Bands may be zlib-compressed */
+
+/**
+ * Header of chunked file
+ */
+typedef struct
+{
+    char magic[8];              /**< Magic string */
+    uint32_t version;           /**< Version of format */
+    uint32_t dtype;             /**< Data type of values */
+    uint32_t flags;             /**< Flags of matrix */
+    uint32_t rows;              /**< Number of rows */
+    uint32_t cols;              /**< Number of columns */
+    uint32_t row_start;         /**< Index of first row */
+    uint32_t col_start;         /**< Index of first column */
+    uint32_t band_rows;         /**< Number of rows per band */
+    uint32_t num_bands;         /**< Number of bands */
+    uint32_t reserved;          /**< Reserved, zero */
+    uint64_t index;             /**< Offset of band index */
+} hchunk_header_t;
+
+/**
+ * Entry of band index
+ */
+typedef struct
+{
+    uint64_t offset;            /**< Offset of band in file */
+    uint64_t size;              /**< Stored size of band */
+    uint64_t length;            /**< Uncompressed size of band */
+} hchunk_entry_t;
+
+/**
+ * Chunked file opened for reading
+ */
+typedef struct
+{
+    int fd;                     /**< File descriptor */
+    hchunk_header_t hdr;        /**< Header of file */
+    hchunk_entry_t *index;      /**< Band index */
+} hchunk_t;
+
+/* Layout functions */
+uint64_t hchunk_band_offset(hchunk_header_t *, int);
+uint64_t hchunk_band_length(hchunk_header_t *, int);
+
+/* Reader functions */
+hchunk_t *hchunk_open(const char *);
+float *hchunk_read_band(hchunk_t *, int);
+long hchunk_read(hchunk_t *, int, int, int, int, float *);
+void hchunk_close(hchunk_t *);
+
+#endif /* HCHUNK_H */
@@ -42,9 +42,24 @@ static default_t defaults[] = {
     {M "", "num_threads", CONFIG_TYPE_INT, {.num = 0}},
     {M "", "cache_size", CONFIG_TYPE_INT, {.num = 256}},
     {M "", "global_cache", CONFIG_TYPE_BOOL, {.num = CONFIG_FALSE}},
+    {M "", "signature", CONFIG_TYPE_INT, {.num = 0}},
     {M "", "col_range", CONFIG_TYPE_STRING, {.str = ""}},
     {M "", "row_range", CONFIG_TYPE_STRING, {.str = ""}},
     {M "", "split", CONFIG_TYPE_STRING, {.str = ""}},
+    {M "", "sweep", CONFIG_TYPE_STRING, {.str = ""}},
+    {M ".join", "method", CONFIG_TYPE_STRING, {.str = "none"}},
+    {M ".join", "threshold", CONFIG_TYPE_FLOAT, {.flt = 0.0}},
+    {M ".join", "neighbors", CONFIG_TYPE_INT, {.num = 0}},
+    {M ".join.minhash", "hashes", CONFIG_TYPE_INT, {.num = 128}},
+    {M ".join.minhash", "bands", CONFIG_TYPE_INT, {.num = 32}},
+    {M ".join.minhash", "verify", CONFIG_TYPE_BOOL, {.num = CONFIG_TRUE}},
+    {M ".join.minhash", "signatures", CONFIG_TYPE_STRING, {.str = ""}},
+    {M ".join.mih", "substrings", CONFIG_TYPE_INT, {.num = 0}},
+    {M ".join.tree", "type", CONFIG_TYPE_STRING, {.str = "auto"}},
+    {M ".join.tree", "file", CONFIG_TYPE_STRING, {.str = ""}},
+    {M ".join.pivot", "pivots", CONFIG_TYPE_INT, {.num = 16}},
+    {M ".join.nndescent", "iterations", CONFIG_TYPE_INT, {.num = 10}},
+    {M ".join.nndescent", "delta", CONFIG_TYPE_FLOAT, {.flt = 0.001}},
     {M ".dist_hamming", "norm", CONFIG_TYPE_STRING, {.str = "none"}},
     {M ".dist_levenshtein", "norm", CONFIG_TYPE_STRING, {.str = "none"}},
     {M ".dist_levenshtein", "cost_ins", CONFIG_TYPE_FLOAT, {.flt = 1.0}},
@@ -64,6 +79,7 @@ static default_t defaults[] = {
     {M ".dist_lee", "min_sym", CONFIG_TYPE_INT, {.num = 0}},
     {M ".dist_lee", "max_sym", CONFIG_TYPE_INT, {.num = 255}},
     {M ".dist_compression", "level", CONFIG_TYPE_INT, {.num = 9}},
+    {M ".dist_compression", "compressor", CONFIG_TYPE_STRING, {.str = "zlib"}},
     {M ".dist_bag", "norm", CONFIG_TYPE_STRING, {.str = "none"}},
     {M ".dist_kernel", "kern", CONFIG_TYPE_STRING, {.str = "kern_wdegree"}},
     {M ".dist_kernel", "norm", CONFIG_TYPE_STRING, {.str = "none"}},
@@ -89,6 +105,8 @@ static default_t defaults[] = {
     {O "", "save_labels", CONFIG_TYPE_BOOL, {.num = CONFIG_FALSE}},
     {O "", "save_sources", CONFIG_TYPE_BOOL, {.num = CONFIG_FALSE}},
     {O "", "compress", CONFIG_TYPE_BOOL, {.num = CONFIG_FALSE}},
+    {O "", "compress_level", CONFIG_TYPE_INT, {.num = 9}},
+    {O "", "compressor", CONFIG_TYPE_STRING, {.str = "gzip"}},
     {NULL}
 };
 
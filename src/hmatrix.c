@@ -435,37 +435,57 @@ float hmatrix_get(hmatrix_t *m, int c, int r)
 }
 
 /**
- * Compute similarity measure and fill matrix
+ * Compute similarity measure and fill matrix. The matrix is processed in
+ * tiles of rows, such that the measure compares one string with up to
+ * HMATRIX_TILE strings per call and can prepare this string only once.
  * @param m Matrix object
  * @param s Array of string objects
- * @param measure Similarity measure
+ * @param measure Batch comparison of similarity measure
  */
 void hmatrix_compute(hmatrix_t *m, hstring_t *s,
-                     double (*measure) (hstring_t, hstring_t))
+                     void (*measure) (hstring_t, hstring_t *, int, float *))
 {
     assert(m);
 
-    int cnt = 0, n;
-    double ts, ts1 = time_stamp(), ts2 = ts1;
-    float f;
+    int cnt = 0, n, tiles;
+    double ts1 = time_stamp(), ts2 = ts1;
 
-    n = (m->col.end - m->col.start) * (m->row.end - m->row.start);
+    tiles = (m->row.end - m->row.start + HMATRIX_TILE - 1) / HMATRIX_TILE;
+    n = (m->col.end - m->col.start) * tiles;
 
 #ifdef HAVE_OPENMP
-#pragma omp parallel for private(ts)
+#pragma omp parallel for schedule(dynamic)
 #endif
     for (int k = 0; k < n; k++) {
-        int c = k / (m->row.end - m->row.start) + m->col.start;
-        int r = k % (m->row.end - m->row.start) + m->row.start;
+        hstring_t ys[HMATRIX_TILE];
+        float out[HMATRIX_TILE];
+        int rs[HMATRIX_TILE], num = 0;
+        double ts;
+
+        int c = k / tiles + m->col.start;
+        int r0 = (k % tiles) * HMATRIX_TILE + m->row.start;
+        int r1 = MIN(r0 + HMATRIX_TILE, m->row.end);
+
+        for (int r = r0; r < r1; r++) {
+            /* Lower triangle is stored with the upper triangle */
+            if (m->triangular && r < c)
+                continue;
+
+            /* Skip values that have been computed earlier */
+            if (!isnan(hmatrix_get(m, c, r)))
+                continue;
+
+            ys[num] = s[r];
+            rs[num++] = r;
+        }
 
-        /* Skip values that have been computed earlier */
-        f = hmatrix_get(m, c, r);
-        if (!isnan(f))
+        if (num == 0)
             continue;
 
-        /* Set value in matrix */
-        f = measure(s[c], s[r]);
-        hmatrix_set(m, c, r, f);
+        /* Set values in matrix */
+        measure(s[c], ys, num, out);
+        for (int i = 0; i < num; i++)
+            hmatrix_set(m, c, rs[i], out[i]);
 
         if (verbose || log_line) {
             /*
@@ -474,8 +494,7 @@ void hmatrix_compute(hmatrix_t *m, hstring_t *s,
              * Moreover, this update is not thread-safe and the progress
              * bar might not be correct.
              */
-            if (cnt < m->calcs)
-                cnt++;
+            cnt = MIN(cnt + num, m->calcs);
 
             /* Continue if less than 100ms have passed */
             ts = time_stamp();
@@ -25,6 +25,9 @@ typedef struct
 
 #define RANGE_LENGTH(r) (r.end -r.start)
 
+/** Number of rows compared with one string at once */
+#define HMATRIX_TILE    256
+
 /**
  * Structure for a matrix
  */
@@ -138,7 +141,7 @@ float *hmatrix_alloc(hmatrix_t *);
 float hmatrix_get(hmatrix_t *, int, int);
 void hmatrix_set(hmatrix_t *, int, int, float);
 void hmatrix_compute(hmatrix_t *, hstring_t *,
-                     double (*measure) (hstring_t, hstring_t));
+                     void (*measure) (hstring_t, hstring_t *, int, float *));
 void hmatrix_destroy(hmatrix_t *);
 float hmatrix_benchmark(hmatrix_t *, hstring_t *,
                         double (*measure) (hstring_t, hstring_t), double);
@@ -0,0 +1,144 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/**
+ * @defgroup pairs Sparse pairs
+ * Sparse list of similarity values. Joins do not compute a full matrix
+ * but only the pairs of strings that pass a threshold. The pairs are
+ * collected per thread, merged and finally sorted by index, such that the
+ * output does not depend on the scheduling of the threads.
+ * @{
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "hpairs.h"
+
+/**
+ * Create an empty list of pairs
+ * @return list of pairs or NULL on error
+ */
+hpairs_t *hpairs_init()
+{
+    hpairs_t *p = calloc(1, sizeof(hpairs_t));
+    if (!p)
+        error("Could not allocate list of pairs");
+    return p;
+}
+
+/**
+ * Make room for additional pairs
+ * @param p List of pairs
+ * @param n Number of additional pairs
+ * @return true on success, false otherwise
+ */
+static int hpairs_grow(hpairs_t *p, long n)
+{
+    long size = MAX(p->size, 256);
+    hpair_t *ptr;
+
+    if (p->num + n <= p->size)
+        return TRUE;
+
+    while (size < p->num + n)
+        size *= 2;
+
+    ptr = realloc(p->pairs, size * sizeof(hpair_t));
+    if (!ptr) {
+        error("Could not allocate memory for pairs");
+        return FALSE;
+    }
+
+    p->pairs = ptr;
+    p->size = size;
+    return TRUE;
+}
+
+/**
+ * Add a pair to a list. The list is not locked.
+ * @param p List of pairs
+ * @param x Index of column string
+ * @param y Index of row string
+ * @param v Similarity value
+ * @return true on success, false otherwise
+ */
+int hpairs_add(hpairs_t *p, int x, int y, float v)
+{
+    if (!hpairs_grow(p, 1))
+        return FALSE;
+
+    p->pairs[p->num].x = x;
+    p->pairs[p->num].y = y;
+    p->pairs[p->num].v = v;
+    p->num++;
+    return TRUE;
+}
+
+/**
+ * Move the pairs of one list to another list. The source list is emptied.
+ * @param p Destination list
+ * @param q Source list
+ * @return true on success, false otherwise
+ */
+int hpairs_merge(hpairs_t *p, hpairs_t *q)
+{
+    if (!hpairs_grow(p, q->num))
+        return FALSE;
+
+    if (q->num > 0)
+        memcpy(p->pairs + p->num, q->pairs, q->num * sizeof(hpair_t));
+    p->num += q->num;
+    p->cands += q->cands;
+    q->num = q->cands = 0;
+    return TRUE;
+}
+
+/**
+ * Compare two pairs by their indices
+ * @param a First pair
+ * @param b Second pair
+ * @return order of pairs
+ */
+static int pair_cmp(const void *a, const void *b)
+{
+    const hpair_t *x = a, *y = b;
+
+    if (x->x != y->x)
+        return x->x < y->x ? -1 : 1;
+    if (x->y != y->y)
+        return x->y < y->y ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Sort a list of pairs by column and row index
+ * @param p List of pairs
+ */
+void hpairs_sort(hpairs_t *p)
+{
+    qsort(p->pairs, p->num, sizeof(hpair_t), pair_cmp);
+}
+
+/**
+ * Destroy a list of pairs and free its memory
+ * @param p List of pairs
+ */
+void hpairs_destroy(hpairs_t *p)
+{
+    if (!p)
+        return;
+
+    free(p->pairs);
+    free(p);
+}
+
+/** @} */
@@ -0,0 +1,42 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef HPAIRS_H
+#define HPAIRS_H
+
+/**
+ * Pair of strings with similarity value
+ */
+typedef struct
+{
+    int x;                      /**< Index of column string */
+    int y;                      /**< Index of row string */
+    float v;                    /**< Similarity value */
+} hpair_t;
+
+/**
+ * Sparse list of similarity values
+ */
+typedef struct
+{
+    hpair_t *pairs;             /**< Array of pairs */
+    long num;                   /**< Number of pairs */
+    long size;                  /**< Size of array */
+    long cands;                 /**< Number of verified candidates */
+} hpairs_t;
+
+hpairs_t *hpairs_init();
+int hpairs_add(hpairs_t *, int, int, float);
+int hpairs_merge(hpairs_t *, hpairs_t *);
+void hpairs_sort(hpairs_t *);
+void hpairs_destroy(hpairs_t *);
+
+#endif /* HPAIRS_H */
@@ -26,18 +26,38 @@
 /* External variable */
 extern config_t cfg;
 
-/* Global delimiter table */
-char delim[256] = { DELIM_NOT_INIT };
-
 /**
  * Structure for stop tokens (irrelevant tokens)
  */
-typedef struct
+typedef struct stoptoken
 {
     sym_t sym;                  /* Hash of stop token */
     UT_hash_handle hh;          /* uthash handle */
 } stoptoken_t;
-static stoptoken_t *stoptokens = NULL;
+
+/* Default settings: delimiters, stop tokens and signatures */
+static hprep_t prep = { &cfg, {DELIM_NOT_INIT}, NULL, 0, 0 };
+
+static hstring_t sign(hprep_t *, hstring_t);
+
+/**
+ * Statistics of signature tests for one thread
+ */
+typedef struct sig_stats
+{
+    long tests;                 /* Number of tested pairs */
+    long skips;                 /* Number of skipped pairs */
+    int listed;                 /* Flag for listed statistics */
+    struct sig_stats *next;     /* Next statistics */
+} sig_stats_t;
+
+static sig_stats_t sig_stats;
+#ifdef HAVE_OPENMP
+#pragma omp threadprivate(sig_stats)
+#endif
+
+/* List of statistics of all threads */
+static sig_stats_t *sig_list = NULL;
 
 /**
  * Free memory of the string object
@@ -59,11 +79,14 @@ void hstring_destroy(hstring_t *x)
 
     if (x->src)
         free(x->src);
+    if (x->sig)
+        free(x->sig);
 
     /* Make sure everything is null */
     x->str.c = NULL;
     x->str.s = NULL;
     x->src = NULL;
+    x->sig = NULL;
     x->len = 0;
 }
 
@@ -73,7 +96,31 @@ void hstring_destroy(hstring_t *x)
  */
 int hstring_has_delim()
 {
-    return (delim[0] != DELIM_NOT_INIT);
+    return (prep.delim[0] != DELIM_NOT_INIT);
+}
+
+/**
+ * Return the default settings for preprocessing
+ * @return default settings
+ */
+hprep_t *hstring_prep_default()
+{
+    return &prep;
+}
+
+/**
+ * Initialize settings for preprocessing. Delimiters, stop tokens and
+ * signatures are unset.
+ * @param p Settings
+ * @param c Configuration
+ */
+void hstring_prep_init(hprep_t *p, config_t *c)
+{
+    p->cfg = c;
+    p->delim[0] = DELIM_NOT_INIT;
+    p->stoptokens = NULL;
+    p->sig_bits = 0;
+    p->sig_len = 0;
 }
 
 /**
@@ -136,23 +183,25 @@ void hstring_print(hstring_t x)
 }
 
 /**
- * Decodes a string containing delimiters to a lookup table
+ * Decodes a string containing delimiters to a lookup table. An empty
+ * string resets the table.
+ * @param p Settings
  * @param s String containing delimiters
  */
-void hstring_delim_set(const char *s)
+void hstring_delim_set_r(hprep_t *p, const char *s)
 {
     char buf[5] = "0x00";
     unsigned int i, j;
 
     if (strlen(s) == 0) {
-        hstring_delim_reset();
+        p->delim[0] = DELIM_NOT_INIT;
         return;
     }
 
-    memset(delim, 0, 256);
+    memset(p->delim, 0, 256);
     for (i = 0; i < strlen(s); i++) {
         if (s[i] != '%') {
-            delim[(unsigned int) s[i]] = 1;
+            p->delim[(unsigned int) s[i]] = 1;
             continue;
         }
 
@@ -163,10 +212,19 @@ void hstring_delim_set(const char *s)
         buf[2] = s[++i];
         buf[3] = s[++i];
         sscanf(buf, "%x", (unsigned int *) &j);
-        delim[j] = 1;
+        p->delim[j] = 1;
     }
 }
 
+/**
+ * Decodes a string containing delimiters to the default lookup table
+ * @param s String containing delimiters
+ */
+void hstring_delim_set(const char *s)
+{
+    hstring_delim_set_r(&prep, s);
+}
+
 /**
  * Resets delimiters table. There is a global table of delimiter
  * symbols which is only initialized once the first sequence is
@@ -174,7 +232,7 @@ void hstring_delim_set(const char *s)
  */
 void hstring_delim_reset()
 {
-    delim[0] = DELIM_NOT_INIT;
+    prep.delim[0] = DELIM_NOT_INIT;
 }
 
 
@@ -183,9 +241,10 @@ void hstring_delim_reset()
  * Converts a string into a sequence of tokens using delimiter characters.
  * The original character string is lost.
  * @param x character string
+ * @param delim table of delimiters
  * @return string of tokens
  */
-hstring_t hstring_tokenify(hstring_t x)
+static hstring_t tokenify(hstring_t x, const char *delim)
 {
     int i = 0, j = 0, k = 0, dlm = 0;
     int wstart = 0;
@@ -233,6 +292,17 @@ hstring_t hstring_tokenify(hstring_t x)
     return x;
 }
 
+/**
+ * Converts a string into a sequence of tokens using the default
+ * delimiter characters. The original character string is lost.
+ * @param x character string
+ * @return string of tokens
+ */
+hstring_t hstring_tokenify(hstring_t x)
+{
+    return tokenify(x, prep.delim);
+}
+
 /**
  * Converts a string into a sequence of bits. Well, actually there is no
  * conversion except for that the counting now happens on the level of bits
@@ -260,6 +330,7 @@ hstring_t hstring_init(hstring_t x, char *s)
     x.type = TYPE_BYTE;
     x.len = strlen(s);
     x.src = NULL;
+    x.sig = NULL;
 
     return x;
 }
@@ -276,6 +347,7 @@ hstring_t hstring_empty(hstring_t x, int t)
     x.label = 1.0;
     x.len = 0;
     x.src = NULL;
+    x.sig = NULL;
 
     return x;
 }
@@ -379,9 +451,10 @@ uint64_t hstring_hash2(hstring_t x, hstring_t y)
 
 /**
  * Read in and hash stop tokens
+ * @param p Settings
  * @param file stop token file
  */
-void stoptokens_load(const char *file)
+void stoptokens_load_r(hprep_t *p, const char *file)
 {
     char buf[1024];
     FILE *f;
@@ -402,16 +475,26 @@ void stoptokens_load(const char *file)
         /* Add stop token to hash table */
         stoptoken_t *token = malloc(sizeof(stoptoken_t));
         token->sym = (sym_t) hash_str(buf, len);
-        HASH_ADD(hh, stoptokens, sym, sizeof(sym_t), token);
+        HASH_ADD(hh, p->stoptokens, sym, sizeof(sym_t), token);
     }
     fclose(f);
 }
 
+/**
+ * Read in and hash stop tokens for the default settings
+ * @param file stop token file
+ */
+void stoptokens_load(const char *file)
+{
+    stoptokens_load_r(&prep, file);
+}
+
 /**
  * Filter stop tokens from symbols
  * @param x Symbolized string
+ * @param stoptokens Table of stop tokens
  */
-hstring_t stoptokens_filter(hstring_t x)
+hstring_t stoptokens_filter(hstring_t x, stoptoken_t *stoptokens)
 {
     assert(x.type == TYPE_TOKEN);
     stoptoken_t *stoptoken;
@@ -436,19 +519,20 @@ hstring_t stoptokens_filter(hstring_t x)
 
 /**
  * Preprocess a given string
+ * @param p Settings
  * @param x character string
  * @return preprocessed string
  */
-hstring_t hstring_preproc(hstring_t x)
+hstring_t hstring_preproc_r(hprep_t *p, hstring_t x)
 {
     assert(x.type == TYPE_BYTE);
     int decode, reverse, soundex, c, i, k;
     const char *gran;
 
-    config_lookup_string(&cfg, "measures.granularity", &gran);
-    config_lookup_bool(&cfg, "input.decode_str", &decode);
-    config_lookup_bool(&cfg, "input.reverse_str", &reverse);
-    config_lookup_bool(&cfg, "input.soundex", &soundex);
+    config_lookup_string(p->cfg, "measures.granularity", &gran);
+    config_lookup_bool(p->cfg, "input.decode_str", &decode);
+    config_lookup_bool(p->cfg, "input.reverse_str", &reverse);
+    config_lookup_bool(p->cfg, "input.soundex", &soundex);
 
     if (decode) {
         x.len = decode_str(x.str.c);
@@ -469,34 +553,53 @@ hstring_t hstring_preproc(hstring_t x)
     if (!strcasecmp(gran, "bytes")) {
         /* nothing */
     } else if (!strcasecmp(gran, "tokens")) {
-        assert(hstring_has_delim());
-        x = hstring_tokenify(x);
+        assert(p->delim[0] != DELIM_NOT_INIT);
+        x = tokenify(x, p->delim);
     } else if (!strcasecmp(gran, "bits")) {
         x = hstring_bitify(x);
     } else {
         error("Unknown granularity '%s'. Using 'bytes' instead.", gran);
     }
 
-    if (stoptokens)
-        x = stoptokens_filter(x);
+    if (p->stoptokens)
+        x = stoptokens_filter(x, p->stoptokens);
 
-    return x;
+    return sign(p, x);
+}
+
+/**
+ * Preprocess a given string with the default settings
+ * @param x character string
+ * @return preprocessed string
+ */
+hstring_t hstring_preproc(hstring_t x)
+{
+    return hstring_preproc_r(&prep, x);
 }
 
 /**
  * Destroy stop tokens table
+ * @param p Settings
  */
-void stoptokens_destroy()
+void stoptokens_destroy_r(hprep_t *p)
 {
     stoptoken_t *s;
 
-    while (stoptokens) {
-        s = stoptokens;
-        HASH_DEL(stoptokens, s);
+    while (p->stoptokens) {
+        s = p->stoptokens;
+        HASH_DEL(p->stoptokens, s);
         free(s);
     }
 }
 
+/**
+ * Destroy stop tokens table of the default settings
+ */
+void stoptokens_destroy()
+{
+    stoptokens_destroy_r(&prep);
+}
+
 /**
  * Soundex code as implemented by Kevin Setter, 8/27/97 with some
  * slight modifications. Known bugs: Consonants separated by a vowel
@@ -645,4 +748,152 @@ hstring_t hstring_soundex(hstring_t x)
     return x;
 }
 
+/**
+ * Configure the signatures of strings. A signature is a bit vector of the
+ * k-mers of a string that is computed during preprocessing if the
+ * parameter "measures.signature" is non-zero. Measures call this function
+ * with the length of the k-mers they compare.
+ * @param p Settings
+ * @param len Length of k-mers or 0 to disable signatures
+ */
+void hstring_sig_config_r(hprep_t *p, int len)
+{
+    cfg_int bits = 0;
+
+    p->sig_bits = 0;
+    p->sig_len = 0;
+
+    config_lookup_int(p->cfg, "measures.signature", &bits);
+    if (len <= 0 || bits <= 0)
+        return;
+
+    if (bits % 64 != 0 || bits > 4096) {
+        bits = MIN((bits + 63) / 64 * 64, 4096);
+        warning("Signatures need a multiple of 64 bits. Using %d bits.",
+                (int) bits);
+    }
+
+    p->sig_bits = bits;
+    p->sig_len = len;
+}
+
+/**
+ * Configure the signatures of strings for the default settings
+ * @param len Length of k-mers or 0 to disable signatures
+ */
+void hstring_sig_config(int len)
+{
+    hstring_sig_config_r(&prep, len);
+}
+
+/**
+ * Compute the signature of a string. Each k-mer of the string is hashed
+ * to one bit of the signature, such that strings with disjoint
+ * signatures share no k-mers. The first word of the signature holds the
+ * length of the k-mers and the number of words.
+ * @param p Settings
+ * @param x string object
+ * @return string object with signature
+ */
+static hstring_t sign(hprep_t *p, hstring_t x)
+{
+    int i, words = p->sig_bits / 64;
+    uint64_t h;
+    sym_t s;
+
+    x.sig = NULL;
+    if (p->sig_bits == 0 || (p->sig_len > 1 && x.type == TYPE_BIT))
+        return x;
+
+    x.sig = calloc(words + 1, sizeof(uint64_t));
+    if (!x.sig) {
+        error("Could not allocate signature of string");
+        return x;
+    }
+
+    x.sig[0] = (uint64_t) p->sig_len << 32 | words;
+    for (i = 0; i < x.len - p->sig_len + 1; i++) {
+        if (p->sig_len == 1) {
+            s = hstring_get(x, i);
+            h = MurmurHash64B(&s, sizeof(sym_t), 0xc0ffee);
+        } else {
+            h = hstring_hash_sub(x, i, p->sig_len);
+        }
+        h %= p->sig_bits;
+        x.sig[1 + h / 64] |= 1ULL << (h % 64);
+    }
+
+    return x;
+}
+
+/**
+ * Compute the signature of a string with the default settings
+ * @param x string object
+ * @return string object with signature
+ */
+hstring_t hstring_sign(hstring_t x)
+{
+    return sign(&prep, x);
+}
+
+/**
+ * Test whether two strings share no k-mers using their signatures. The
+ * test is conservative: if a signature is missing or has been computed
+ * for other k-mers, the strings are considered overlapping.
+ * @param x first string
+ * @param y second string
+ * @param len Length of k-mers
+ * @return true if the strings are disjoint, false otherwise
+ */
+int hstring_sig_disjoint(hstring_t x, hstring_t y, int len)
+{
+    uint64_t any = 0;
+    int i, words;
+
+    if (!x.sig || !y.sig || x.sig[0] != y.sig[0] ||
+        (int) (x.sig[0] >> 32) != len)
+        return FALSE;
+
+    words = x.sig[0] & 0xffffffff;
+    for (i = 1; i <= words; i++)
+        any |= x.sig[i] & y.sig[i];
+
+    if (!sig_stats.listed) {
+        sig_stats.listed = TRUE;
+#ifdef HAVE_OPENMP
+#pragma omp critical (signature)
+#endif
+        {
+            sig_stats.next = sig_list;
+            sig_list = &sig_stats;
+        }
+    }
+
+    sig_stats.tests++;
+    if (!any)
+        sig_stats.skips++;
+
+    return !any;
+}
+
+/**
+ * Display statistics of the signature tests
+ */
+void hstring_sig_info()
+{
+    long tests = 0, skips = 0;
+    sig_stats_t *s;
+
+    for (s = sig_list; s; s = s->next) {
+        tests += s->tests;
+        skips += s->skips;
+    }
+
+    if (tests == 0)
+        return;
+
+    info_msg(1, "Signature stats: %ld of %ld comparisons skipped (%.1f%%).",
+             skips, tests, 100.0 * skips / tests);
+}
+
 /** @} */
@@ -42,8 +42,22 @@ typedef struct
 
     char *src;                /**< Optional source of string */
     float label;              /**< Optional label of string */
+    uint64_t *sig;            /**< Optional signature of string */
 } hstring_t;
 
+/**
+ * Settings for preprocessing strings. The functions without suffix use
+ * default settings that follow the global configuration.
+ */
+typedef struct
+{
+    config_t *cfg;            /**< Configuration */
+    char delim[256];          /**< Table of delimiters */
+    struct stoptoken *stoptokens;       /**< Table of stop tokens */
+    int sig_bits;             /**< Bits of signatures (0 = disabled) */
+    int sig_len;              /**< Length of k-mers of signatures */
+} hprep_t;
+
 void hstring_print(hstring_t);
 void hstring_delim_set(const char *);
 void hstring_delim_reset();
@@ -64,6 +78,21 @@ hstring_t hstring_soundex(hstring_t);
 void stoptokens_load(const char *f);
 void stoptokens_destroy();
 
+/* Signatures of strings */
+void hstring_sig_config(int);
+hstring_t hstring_sign(hstring_t);
+int hstring_sig_disjoint(hstring_t, hstring_t, int);
+void hstring_sig_info();
+
+/* Reentrant versions */
+hprep_t *hstring_prep_default();
+void hstring_prep_init(hprep_t *, config_t *);
+void hstring_delim_set_r(hprep_t *, const char *);
+hstring_t hstring_preproc_r(hprep_t *, hstring_t);
+void stoptokens_load_r(hprep_t *, const char *f);
+void stoptokens_destroy_r(hprep_t *);
+void hstring_sig_config_r(hprep_t *, int);
+
 /* Inline functions */
 
 /** 
@@ -45,8 +45,6 @@ typedef struct
 } input_t;
 static input_t func;
 
-/**< Delimiter table */
-extern char delim[256];
 /** External variables */
 extern config_t cfg;
 
@@ -0,0 +1,662 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/**
+ * @defgroup join Join interface
+ * Threshold joins over the strings of a matrix. Instead of computing all
+ * similarity values, a join only determines the pairs of strings whose
+ * value passes a threshold: distances at most the threshold and
+ * similarities at least the threshold. The join algorithms generate
+ * candidate pairs using an index and verify them with the measure. The
+ * exhaustive algorithm compares all pairs and serves as reference.
+ *
+ * The pairs are drawn from the column and row range of the matrix. Every
+ * unordered pair of different strings is reported once, where pairs
+ * within the overlap of both ranges are reported with x < y.
+ *
+ * If a number of neighbors k is configured, the threshold is ignored and
+ * the k nearest row strings of each column string are reported instead,
+ * that is, the strings with the smallest distances or largest similarity
+ * values. Ties are broken by the index of the row string, such that all
+ * methods report the same neighbors.
+ * @{
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "measures.h"
+#include "join.h"
+
+/* Join algorithms */
+#include "join_passjoin.h"
+#include "join_prefix.h"
+#include "join_minhash.h"
+#include "join_mih.h"
+#include "join_jaro.h"
+#include "join_tree.h"
+#include "join_pivot.h"
+#include "join_nndescent.h"
+
+/* External variables */
+extern config_t cfg;
+
+/* Forward declarations */
+static void exhaustive_run(hmatrix_t *, hstring_t *, hpairs_t *);
+
+/* Available join algorithms */
+static join_t joins[] = {
+    {"exhaustive", NULL, exhaustive_run, TRUE},
+    {"passjoin", join_passjoin_config, join_passjoin_run, FALSE},
+    {"prefix", join_prefix_config, join_prefix_run, FALSE},
+    {"minhash", join_minhash_config, join_minhash_run, FALSE},
+    {"mih", join_mih_config, join_mih_run, FALSE},
+    {"jaro", join_jaro_config, join_jaro_run, FALSE},
+    {"tree", join_tree_config, join_tree_run, TRUE},
+    {"pivot", join_pivot_config, join_pivot_run, TRUE},
+    {"nndescent", join_nndescent_config, join_nndescent_run, TRUE},
+    {NULL}
+};
+
+/* Local variables */
+static join_t *algo = NULL;
+static double threshold = 0;
+static int distance = TRUE;
+static int neighbors = 0;
+
+/**
+ * Configure the join. The algorithm and the threshold are read from the
+ * group "join" of the measures.
+ * @param measure Name of similarity measure
+ * @return true if a join is enabled, false if not and -1 on error
+ */
+int join_config(const char *measure)
+{
+    const char *str;
+    cfg_int k;
+    int i;
+
+    algo = NULL;
+    config_lookup_string(&cfg, "measures.join.method", &str);
+    if (strlen(str) == 0 || !strcasecmp(str, "none"))
+        return FALSE;
+
+    for (i = 0; joins[i].name; i++)
+        if (!strcasecmp(joins[i].name, str))
+            break;
+
+    if (!joins[i].name) {
+        error("Unknown join method '%s'.", str);
+        return -1;
+    }
+
+    config_lookup_string(&cfg, "measures.sweep", &str);
+    if (strlen(str) > 0) {
+        error("Sweeps can not be combined with joins.");
+        return -1;
+    }
+
+    config_lookup_float(&cfg, "measures.join.threshold", &threshold);
+    config_lookup_int(&cfg, "measures.join.neighbors", &k);
+    distance = !strncmp(measure, "dist_", 5);
+
+    if (k < 0) {
+        error("Number of neighbors (%d) needs to be non-negative.", (int) k);
+        return -1;
+    }
+    if (k > 0 && !joins[i].neighbors) {
+        error("Join '%s' does not support nearest neighbors.",
+              joins[i].name);
+        return -1;
+    }
+    neighbors = k;
+
+    if (joins[i].join_config && !joins[i].join_config(measure))
+        return -1;
+
+    algo = joins + i;
+    return TRUE;
+}
+
+/**
+ * Return the threshold of the join
+ * @return threshold
+ */
+double join_threshold()
+{
+    return threshold;
+}
+
+/**
+ * Check whether a similarity value passes the threshold. Distances need
+ * to be at most the threshold, while similarities and kernel values need
+ * to be at least the threshold.
+ * @param v Similarity value
+ * @return true if the value passes, false otherwise
+ */
+int join_match(float v)
+{
+    return distance ? v <= threshold : v >= threshold;
+}
+
+/**
+ * Check whether the matrix is symmetric, that is, the column and row
+ * range are equal.
+ * @param m Matrix object
+ * @return true if symmetric, false otherwise
+ */
+int join_triangular(hmatrix_t *m)
+{
+    return m->col.start == m->row.start && m->col.end == m->row.end;
+}
+
+/**
+ * Check whether a pair of strings is reported by the join. Pairs of a
+ * string with itself are skipped and pairs that appear twice due to
+ * overlapping ranges are only reported with x < y. Nearest neighbors are
+ * determined for each column string, such that only the pairs of a string
+ * with itself are skipped.
+ * @param m Matrix object
+ * @param x Index of column string
+ * @param y Index of row string
+ * @return true if the pair is reported, false otherwise
+ */
+int join_pair(hmatrix_t *m, int x, int y)
+{
+    if (x == y)
+        return FALSE;
+    if (neighbors > 0)
+        return TRUE;
+    if (y >= m->col.start && y < m->col.end &&
+        x >= m->row.start && x < m->row.end)
+        return x < y;
+    return TRUE;
+}
+
+/**
+ * Check whether a string is part of the column or row range
+ * @param m Matrix object
+ * @param i Index of string
+ * @return true if part of a range, false otherwise
+ */
+int join_used(hmatrix_t *m, int i)
+{
+    return (i >= m->col.start && i < m->col.end) ||
+        (i >= m->row.start && i < m->row.end);
+}
+
+/**
+ * Check whether the costs of an edit distance are symmetric and
+ * optionally integers.
+ * @param measure Name of similarity measure
+ * @param integer Flag for integer costs (output)
+ * @return true if symmetric, false otherwise
+ */
+static int costs_check(const char *measure, int *integer)
+{
+    const char *names[] = { "cost_ins", "cost_del", "cost_sub", "cost_tra" };
+    double c[4] = { 1, 1, 1, 1 };
+    char path[256];
+
+    for (int i = 0; i < 4; i++) {
+        snprintf(path, sizeof(path), "measures.%s.%s", measure, names[i]);
+        config_lookup_float(&cfg, path, &c[i]);
+        if (c[i] != floor(c[i]))
+            *integer = FALSE;
+    }
+
+    return c[0] == c[1];
+}
+
+/**
+ * Check whether a measure is a metric as configured. Joins pruning pairs
+ * with the triangle inequality would otherwise miss pairs.
+ * @param method Name of join method
+ * @param measure Name of similarity measure
+ * @param integer Flag for integer distances (output)
+ * @return true if metric, false otherwise
+ */
+int join_metric(const char *method, const char *measure, int *integer)
+{
+    const char *str, *metrics[] = {
+        "dist_levenshtein", "dist_damerau", "dist_hamming", "dist_lee",
+        "dist_bag", "dist_kernel", NULL
+    };
+    char path[256];
+    int i;
+
+    *integer = TRUE;
+    for (i = 0; metrics[i] && strcmp(metrics[i], measure); i++);
+    if (!metrics[i]) {
+        error("Join '%s' is not supported for measure '%s'.", method,
+              measure);
+        return FALSE;
+    }
+
+    snprintf(path, sizeof(path), "measures.%s.norm", measure);
+    if (config_lookup_string(&cfg, path, &str) && strcasecmp(str, "none")) {
+        error("Join '%s' does not support normalization.", method);
+        return FALSE;
+    }
+
+    if (!strcmp(measure, "dist_kernel")) {
+        config_lookup_bool(&cfg, "measures.dist_kernel.squared", &i);
+        config_lookup_string(&cfg, "measures.dist_kernel.kern", &str);
+        if (i || !strcmp(str, "kern_distance")) {
+            error("Join '%s' requires a non-squared distance of a "
+                  "positive semi-definite kernel.", method);
+            return FALSE;
+        }
+        *integer = FALSE;
+    }
+
+    if (!strcmp(measure, "dist_levenshtein") ||
+        !strcmp(measure, "dist_damerau")) {
+        if (!costs_check(measure, integer)) {
+            error("Join '%s' requires equal costs of insertions and "
+                  "deletions.", method);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Return the number of nearest neighbors
+ * @return number of neighbors or 0 for a threshold join
+ */
+int join_neighbors()
+{
+    return neighbors;
+}
+
+/**
+ * Check whether a neighbor is worse than another one. Larger distances
+ * and smaller similarity values are worse; ties are broken by index.
+ * @param a First neighbor
+ * @param b Second neighbor
+ * @return true if the first neighbor is worse, false otherwise
+ */
+static int knn_worse(const hpair_t *a, const hpair_t *b)
+{
+    if (a->v != b->v)
+        return distance ? a->v > b->v : a->v < b->v;
+    return a->y > b->y;
+}
+
+/**
+ * Create an empty list of nearest neighbors
+ * @return list of neighbors
+ */
+join_knn_t *join_knn_init()
+{
+    join_knn_t *n = calloc(1, sizeof(join_knn_t));
+    if (!n)
+        return NULL;
+
+    n->k = neighbors;
+    n->heap = malloc(MAX(n->k, 1) * sizeof(hpair_t));
+    if (!n->heap) {
+        free(n);
+        return NULL;
+    }
+
+    return n;
+}
+
+/**
+ * Add a neighbor to the list. If the list is full, the worst neighbor
+ * is replaced if the new one is better. Neighbors already in the list
+ * are ignored.
+ * @param n List of neighbors
+ * @param x Index of column string
+ * @param y Index of row string
+ * @param v Similarity value
+ */
+void join_knn_add(join_knn_t *n, int x, int y, float v)
+{
+    hpair_t e = { x, y, v };
+    int i, j;
+
+    if (isnan(v))
+        return;
+
+    if (n->num < n->k) {
+        for (i = 0; i < n->num; i++)
+            if (n->heap[i].y == y)
+                return;
+
+        /* Sift up */
+        for (i = n->num++; i > 0; i = j) {
+            j = (i - 1) / 2;
+            if (!knn_worse(&e, n->heap + j))
+                break;
+            n->heap[i] = n->heap[j];
+        }
+        n->heap[i] = e;
+        return;
+    }
+
+    if (n->k == 0 || !knn_worse(n->heap, &e))
+        return;
+
+    /* Neighbors may be found twice */
+    for (i = 0; i < n->num; i++)
+        if (n->heap[i].y == y)
+            return;
+
+    /* Sift down */
+    for (i = 0; (j = 2 * i + 1) < n->num; i = j) {
+        if (j + 1 < n->num && knn_worse(n->heap + j + 1, n->heap + j))
+            j++;
+        if (!knn_worse(n->heap + j, &e))
+            break;
+        n->heap[i] = n->heap[j];
+    }
+    n->heap[i] = e;
+}
+
+/**
+ * Return the value of the worst neighbor if the list is full. A new
+ * neighbor needs to reach this value to enter the list.
+ * @param n List of neighbors
+ * @return value of worst neighbor or infinity
+ */
+double join_knn_bound(join_knn_t *n)
+{
+    if (n->num < n->k)
+        return distance ? INFINITY : -INFINITY;
+    return n->heap[0].v;
+}
+
+/**
+ * Add the neighbors to a list of pairs and empty the list
+ * @param n List of neighbors
+ * @param p List of pairs
+ */
+void join_knn_flush(join_knn_t *n, hpairs_t *p)
+{
+    for (int i = 0; i < n->num; i++)
+        hpairs_add(p, n->heap[i].x, n->heap[i].y, n->heap[i].v);
+    n->num = 0;
+}
+
+/**
+ * Destroy a list of nearest neighbors
+ * @param n List of neighbors
+ */
+void join_knn_destroy(join_knn_t *n)
+{
+    if (!n)
+        return;
+    free(n->heap);
+    free(n);
+}
+
+/**
+ * Verify candidates of a column string using the batch interface of the
+ * measure. The values are added to the neighbors if given and otherwise
+ * the pairs passing the threshold are reported.
+ * @param x Column string
+ * @param c Index of column string
+ * @param ys Row strings (at most HMATRIX_TILE)
+ * @param rs Indices of row strings
+ * @param num Number of candidates
+ * @param p List of pairs
+ * @param knn Neighbors or NULL
+ */
+void join_verify(hstring_t x, int c, hstring_t *ys, int *rs, int num,
+                 hpairs_t *p, join_knn_t *knn)
+{
+    float out[HMATRIX_TILE];
+
+    if (num == 0)
+        return;
+
+    measure_compare_batch(x, ys, num, out);
+    p->cands += num;
+    for (int i = 0; i < num; i++) {
+        if (knn)
+            join_knn_add(knn, c, rs[i], out[i]);
+        else if (join_match(out[i]))
+            hpairs_add(p, c, rs[i], out[i]);
+    }
+}
+
+/**
+ * Mix a 64-bit value (finalizer of SplitMix64). The join algorithms use
+ * it for hashing and as random number generator.
+ * @param x Value
+ * @return mixed value
+ */
+uint64_t join_mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Compare two integers
+ * @param a First integer
+ * @param b Second integer
+ * @return order of integers
+ */
+int join_int_cmp(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+/**
+ * Compare two entries of a key index by key and index of string
+ * @param a First entry
+ * @param b Second entry
+ * @return order of entries
+ */
+int join_entry_cmp(const void *a, const void *b)
+{
+    const join_entry_t *x = a, *y = b;
+
+    if (x->key != y->key)
+        return x->key < y->key ? -1 : 1;
+    return x->id - y->id;
+}
+
+/**
+ * Find the first entry of a key in a key index sorted by join_entry_cmp
+ * @param idx Sorted index
+ * @param n Number of entries
+ * @param key Key to look up
+ * @return position of first entry or n if not found
+ */
+long join_index_find(join_entry_t *idx, long n, uint64_t key)
+{
+    long lo = 0, hi = n;
+
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (idx[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo < n && idx[lo].key == key ? lo : n;
+}
+
+/**
+ * Compare two pairs by column index and rank of the neighbor
+ * @param a First pair
+ * @param b Second pair
+ * @return order of pairs
+ */
+static int knn_cmp(const void *a, const void *b)
+{
+    const hpair_t *x = a, *y = b;
+
+    if (x->x != y->x)
+        return x->x < y->x ? -1 : 1;
+    if (knn_worse(x, y))
+        return 1;
+    return knn_worse(y, x) ? -1 : 0;
+}
+
+/**
+ * Exhaustive nearest neighbors. Each column string is compared with all
+ * row strings in tiles using the batch interface of the measure.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+static void exhaustive_knn(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        join_knn_t *knn = join_knn_init();
+        if (!local || !knn)
+            fatal("Could not allocate list of pairs");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int c = m->col.start; c < m->col.end; c++) {
+            hstring_t ys[HMATRIX_TILE];
+            int rs[HMATRIX_TILE];
+
+            for (int r0 = m->row.start; r0 < m->row.end;
+                 r0 += HMATRIX_TILE) {
+                int r1 = MIN(r0 + HMATRIX_TILE, m->row.end), num = 0;
+
+                for (int r = r0; r < r1; r++) {
+                    if (!join_pair(m, c, r))
+                        continue;
+                    ys[num] = s[r];
+                    rs[num++] = r;
+                }
+
+                join_verify(s[c], c, ys, rs, num, local, knn);
+            }
+            join_knn_flush(knn, local);
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+        join_knn_destroy(knn);
+    }
+}
+
+/**
+ * Exhaustive join. All pairs are compared in tiles of rows using the
+ * batch interface of the measure.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+static void exhaustive_run(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+    int n, tiles;
+
+    if (neighbors > 0) {
+        exhaustive_knn(m, s, p);
+        return;
+    }
+
+    tiles = (m->row.end - m->row.start + HMATRIX_TILE - 1) / HMATRIX_TILE;
+    n = (m->col.end - m->col.start) * tiles;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        if (!local)
+            fatal("Could not allocate list of pairs");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int k = 0; k < n; k++) {
+            hstring_t ys[HMATRIX_TILE];
+            int rs[HMATRIX_TILE], num = 0;
+
+            int c = k / tiles + m->col.start;
+            int r0 = (k % tiles) * HMATRIX_TILE + m->row.start;
+            int r1 = MIN(r0 + HMATRIX_TILE, m->row.end);
+
+            for (int r = r0; r < r1; r++) {
+                if (!join_pair(m, c, r))
+                    continue;
+                ys[num] = s[r];
+                rs[num++] = r;
+            }
+
+            join_verify(s[c], c, ys, rs, num, local, NULL);
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+    }
+}
+
+/**
+ * Run the join over the column and row range of a matrix. The values of
+ * the matrix are not used.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @return list of pairs sorted by index or by rank of the neighbors
+ */
+hpairs_t *join_compute(hmatrix_t *m, hstring_t *s)
+{
+    double total, o, cl, rl;
+    hpairs_t *p;
+
+    assert(algo);
+    p = hpairs_init();
+    if (!p)
+        fatal("Could not allocate list of pairs");
+
+#ifdef HAVE_OPENMP
+    info_msg(1, "Joining strings using '%s' with %d threads.", algo->name,
+             omp_get_max_threads());
+#else
+    info_msg(1, "Joining strings using '%s'.", algo->name);
+#endif
+    algo->join_run(m, s, p);
+    if (neighbors > 0)
+        qsort(p->pairs, p->num, sizeof(hpair_t), knn_cmp);
+    else
+        hpairs_sort(p);
+
+    /* Number of pairs without duplicates */
+    cl = m->col.end - m->col.start;
+    rl = m->row.end - m->row.start;
+    o = MAX(0, MIN(m->col.end, m->row.end) -
+            MAX(m->col.start, m->row.start));
+    total = cl * rl - o - (neighbors > 0 ? 0 : o * (o - 1) / 2);
+
+    info_msg(1, "Verified %ld candidates (%.4f%% of %.0f pairs); "
+             "%ld pairs found.", p->cands,
+             total > 0 ? 100 * p->cands / total : 0.0, total, p->num);
+
+    return p;
+}
+
+/** @} */
@@ -0,0 +1,81 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef JOIN_H
+#define JOIN_H
+
+#include "hstring.h"
+#include "hmatrix.h"
+#include "hpairs.h"
+
+/* Relative tolerance of bounds for rounding of float values */
+#define JOIN_TOLERANCE  1e-5
+
+/**
+ * Interface of a join algorithm
+ */
+typedef struct
+{
+    const char *name;           /**< Name of algorithm */
+    int (*join_config) (const char *);  /**< Check and configure */
+    void (*join_run) (hmatrix_t *, hstring_t *, hpairs_t *);    /**< Run */
+    int neighbors;              /**< Support for nearest neighbors */
+} join_t;
+
+/**
+ * Nearest neighbors of one string
+ */
+typedef struct
+{
+    hpair_t *heap;              /**< Heap with worst neighbor on top */
+    int num;                    /**< Number of neighbors */
+    int k;                      /**< Maximum number of neighbors */
+} join_knn_t;
+
+/**
+ * Entry of a key index. The entries are sorted by key, such that the
+ * strings of a key are found by binary search.
+ */
+typedef struct
+{
+    uint64_t key;               /**< Key, e.g. hash of a substring */
+    int id;                     /**< Index of string */
+} join_entry_t;
+
+/* Join interface */
+int join_config(const char *);
+hpairs_t *join_compute(hmatrix_t *, hstring_t *);
+
+/* Functions for join algorithms */
+double join_threshold();
+int join_match(float);
+int join_pair(hmatrix_t *, int, int);
+int join_triangular(hmatrix_t *);
+int join_metric(const char *, const char *, int *);
+int join_used(hmatrix_t *, int);
+
+/* Nearest neighbors */
+int join_neighbors();
+join_knn_t *join_knn_init();
+void join_knn_add(join_knn_t *, int, int, float);
+double join_knn_bound(join_knn_t *);
+void join_knn_flush(join_knn_t *, hpairs_t *);
+void join_knn_destroy(join_knn_t *);
+void join_verify(hstring_t, int, hstring_t *, int *, int, hpairs_t *,
+                 join_knn_t *);
+
+/* Hashing and key indices */
+uint64_t join_mix(uint64_t);
+int join_int_cmp(const void *, const void *);
+int join_entry_cmp(const void *, const void *);
+long join_index_find(join_entry_t *, long, uint64_t);
+
+#endif /* JOIN_H */
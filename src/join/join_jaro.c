@@ -0,0 +1,299 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "measures.h"
+#include "join_jaro.h"
+
+/**
+ * @addtogroup join
+ * <hr>
+ * <em>jaro</em>: Filtered join for the Jaro and Jaro-Winkler distance.
+ *
+ * The Jaro similarity of two strings with m matching symbols is
+ * (m / |x| + m / |y| + (m - t) / m) / 3, where the number of matches is
+ * at most the length of the shorter string and at most the overlap of
+ * the symbol counts. The Winkler bonus scales the distance by
+ * 1 - l * p, where l is the common prefix of at most 4 symbols. Both
+ * bounds yield a lower bound of the distance. The indexed strings are
+ * grouped by length and a probed string only visits the lengths whose
+ * bound passes the threshold. The remaining pairs are filtered using the
+ * exact prefix and the overlap of hashed symbol counts before the
+ * distance is computed.
+ * @{
+ */
+
+/* External variables */
+extern config_t cfg;
+
+
+/* Number of buckets for symbol counts */
+#define BUCKETS         256
+
+/* Local variables */
+static double scaling = 0.0;
+
+/**
+ * Configure the join. The Winkler scaling is only used for the
+ * Jaro-Winkler distance and needs to be at most 0.25.
+ * @param measure Name of similarity measure
+ * @return true on success, false otherwise
+ */
+int join_jaro_config(const char *measure)
+{
+    if (strcmp(measure, "dist_jaro") && strcmp(measure, "dist_jarowinkler")) {
+        error("Join 'jaro' is not supported for measure '%s'.", measure);
+        return FALSE;
+    }
+
+    scaling = 0.0;
+    if (!strcmp(measure, "dist_jarowinkler"))
+        config_lookup_float(&cfg, "measures.dist_jarowinkler.scaling",
+                            &scaling);
+
+    if (scaling < 0 || scaling > 0.25) {
+        error("Join 'jaro' requires a scaling between 0 and 0.25.");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Lower bound of the distance given an upper bound of the matches
+ * @param m Maximum number of matches
+ * @param xl Length of first string
+ * @param yl Length of second string
+ * @param l Length of common prefix
+ * @return lower bound of distance
+ */
+static double bound(int m, int xl, int yl, int l)
+{
+    if (xl == 0 && yl == 0)
+        return 0;
+    if (m == 0)
+        return 1;
+
+    double j = ((double) m / xl + (double) m / yl + 1) / 3;
+    return (1 - j) * (1 - l * scaling);
+}
+
+/**
+ * Check whether strings of two lengths can pass the threshold. The
+ * matches are bounded by the shorter string and the prefix by 4 symbols.
+ * @param xl Length of first string
+ * @param yl Length of second string
+ * @return true if feasible, false otherwise
+ */
+static int feasible(int xl, int yl)
+{
+    int m = MIN(xl, yl);
+    return bound(m, xl, yl, MIN(m, 4)) <= join_threshold() + JOIN_TOLERANCE;
+}
+
+/**
+ * Return the bucket of a symbol. Tokens are hashed to buckets, such that
+ * symbols of equal buckets may differ.
+ * @param x String
+ * @param i Position
+ * @return bucket
+ */
+static uint8_t bucket(hstring_t x, int i)
+{
+    uint64_t s = hstring_get(x, i);
+
+    if (x.type == TYPE_TOKEN) {
+        s = (s ^ (s >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        s = s ^ (s >> 27);
+    }
+
+    return s % BUCKETS;
+}
+
+/**
+ * Compute the overlap of the symbol counts of a string with a histogram.
+ * The overlap of the buckets is an upper bound for the number of matching
+ * symbols. The histogram is restored afterwards.
+ * @param b Buckets of string
+ * @param len Length of string
+ * @param hist Histogram of buckets of second string
+ * @return overlap
+ */
+static int overlap(const uint8_t *b, int len, int *hist)
+{
+    int i, o = 0;
+
+    for (i = 0; i < len; i++)
+        if (hist[b[i]]-- > 0)
+            o++;
+    for (i = 0; i < len; i++)
+        hist[b[i]]++;
+
+    return o;
+}
+
+/**
+ * Return the common prefix of two strings up to 4 symbols
+ * @param x First string
+ * @param y Second string
+ * @return length of prefix
+ */
+static int prefix(hstring_t x, hstring_t y)
+{
+    int l, n = MIN(MIN(x.len, y.len), 4);
+
+    for (l = 0; l < n; l++)
+        if (hstring_compare(x, l, y, l))
+            break;
+
+    return l;
+}
+
+/**
+ * Run the filtered join. The strings of the row range are grouped by
+ * length and the strings of the column range are probed in parallel.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+void join_jaro_run(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+    int lo = MIN(m->col.start, m->row.start);
+    int hi = MAX(m->col.end, m->row.end);
+    int *ids, *first, maxlen = 0;
+    long *off, visited = 0;
+    uint8_t *bkt;
+
+    if (hi <= lo)
+        return;
+
+    /* Buckets of symbols of all strings */
+    off = malloc((hi - lo + 1) * sizeof(long));
+    if (!off)
+        fatal("Could not allocate memory for buckets");
+    off[0] = 0;
+    for (int i = lo; i < hi; i++)
+        off[i - lo + 1] = off[i - lo] + s[i].len;
+    bkt = malloc(MAX(off[hi - lo], 1));
+    if (!bkt)
+        fatal("Could not allocate memory for buckets");
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+    for (int i = lo; i < hi; i++)
+        for (int j = 0; j < s[i].len; j++)
+            bkt[off[i - lo] + j] = bucket(s[i], j);
+
+    /* Group indexed strings by length (counting sort) */
+    for (int r = m->row.start; r < m->row.end; r++)
+        maxlen = MAX(maxlen, s[r].len);
+
+    first = calloc(maxlen + 2, sizeof(int));
+    ids = malloc(MAX(m->row.end - m->row.start, 1) * sizeof(int));
+    if (!first || !ids)
+        fatal("Could not allocate memory for length index");
+
+    for (int r = m->row.start; r < m->row.end; r++)
+        first[s[r].len + 1]++;
+    for (int l = 0; l <= maxlen; l++)
+        first[l + 1] += first[l];
+    for (int r = m->row.start; r < m->row.end; r++)
+        ids[first[s[r].len]++] = r;
+    for (int l = maxlen; l >= 0; l--)
+        first[l + 1] = first[l];
+    first[0] = 0;
+
+    info_msg(1, "Grouped %d strings by %d lengths (scaling = %g).",
+             m->row.end - m->row.start, maxlen + 1, scaling);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel reduction(+:visited)
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        hstring_t ys[HMATRIX_TILE];
+        int rs[HMATRIX_TILE], hist[BUCKETS];
+        if (!local)
+            fatal("Could not allocate list of pairs");
+
+        memset(hist, 0, sizeof(hist));
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+        for (int c = m->col.start; c < m->col.end; c++) {
+            hstring_t x = s[c];
+            const uint8_t *b = bkt + off[c - lo];
+            int l0, l1, num = 0;
+
+            /* The bound decreases towards the length of the string */
+            for (l0 = MIN(x.len, maxlen + 1); l0 > 0; l0--)
+                if (!feasible(l0 - 1, x.len))
+                    break;
+            for (l1 = x.len; l1 <= maxlen; l1++)
+                if (!feasible(l1, x.len))
+                    break;
+            l1 = MIN(l1, maxlen + 1);
+            if (l0 >= l1)
+                continue;
+
+            for (int i = 0; i < x.len; i++)
+                hist[b[i]]++;
+
+            for (int e = first[l0]; e < first[l1]; e++) {
+                int r = ids[e], l;
+                double t = join_threshold() + JOIN_TOLERANCE;
+
+                if (!join_pair(m, c, r))
+                    continue;
+
+                /* Bounds by prefix and by overlap of symbol counts */
+                visited++;
+                l = prefix(x, s[r]);
+                if (bound(MIN(x.len, s[r].len), x.len, s[r].len, l) > t)
+                    continue;
+                if (bound(overlap(bkt + off[r - lo], s[r].len, hist),
+                          x.len, s[r].len, l) > t)
+                    continue;
+
+                ys[num] = s[r];
+                rs[num++] = r;
+                if (num == HMATRIX_TILE) {
+                    join_verify(x, c, ys, rs, num, local, NULL);
+                    num = 0;
+                }
+            }
+            if (num > 0)
+                join_verify(x, c, ys, rs, num, local, NULL);
+
+            for (int i = 0; i < x.len; i++)
+                hist[b[i]]--;
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+    }
+
+    info_msg(1, "Filtered %ld pairs of compatible length.", visited);
+
+    free(ids);
+    free(first);
+    free(bkt);
+    free(off);
+}
+
+/** @} */
@@ -0,0 +1,360 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "scratch.h"
+#include "dist_hamming.h"
+#include "join_mih.h"
+
+/**
+ * @addtogroup join
+ * <hr>
+ * <em>mih</em>: Multi-index hashing for the Hamming distance.
+ *
+ * The positions of the strings are split into m substrings and each
+ * substring of the indexed strings is stored in a hash index. By the
+ * pigeonhole principle, two strings within radius r agree in at least
+ * one substring up to floor(r / m) mismatches. A probed string thus looks
+ * up its substrings and, for bit strings, all variants of the substrings
+ * within this radius. The candidates are verified with the Hamming
+ * distance. Strings are padded with a symbol matching no other symbol to
+ * the maximum length, such that the remaining symbols of longer strings
+ * count as mismatches as in the Hamming distance.
+ *
+ * The key of a substring is the XOR of hashes of its positions and
+ * symbols, such that the key of a variant is derived by updating the
+ * changed positions only. If the radius reaches the maximum length, all
+ * pairs are within the radius and no index is built.
+ *
+ * Norouzi, Punjani, and Fleet. Fast search in Hamming space with
+ * multi-index hashing. Proceedings of the IEEE Conference on Computer
+ * Vision and Pattern Recognition (CVPR), 3108-3115, 2012.
+ * @{
+ */
+
+/* External variables */
+extern config_t cfg;
+
+/* Symbol of padded positions */
+#define MIH_PAD         UINT64_MAX
+
+/**
+ * Probe of one string
+ */
+typedef struct
+{
+    hstring_t y;                /**< Probed string */
+    int end;                    /**< End of substring */
+    int *cands;                 /**< Candidates */
+    int num;                    /**< Number of candidates */
+    int size;                   /**< Size of candidate array */
+} probe_t;
+
+/* Local variables */
+static int radius = 0;
+static int subs = 0;
+
+/* Index of substrings */
+static join_entry_t *idx = NULL;
+static long nidx = 0;
+static int maxlen = 0;
+static int uniform = TRUE;
+
+/**
+ * Configure the join. The Hamming distance may not be normalized, such
+ * that the threshold is a number of mismatches.
+ * @param measure Name of similarity measure
+ * @return true on success, false otherwise
+ */
+int join_mih_config(const char *measure)
+{
+    const char *str;
+    cfg_int m;
+
+    if (strcmp(measure, "dist_hamming")) {
+        error("Join 'mih' is not supported for measure '%s'.", measure);
+        return FALSE;
+    }
+
+    config_lookup_string(&cfg, "measures.dist_hamming.norm", &str);
+    if (strcasecmp(str, "none")) {
+        error("Join 'mih' does not support normalization.");
+        return FALSE;
+    }
+    if (join_threshold() < 0) {
+        error("Join 'mih' requires a non-negative threshold.");
+        return FALSE;
+    }
+
+    config_lookup_int(&cfg, "measures.join.mih.substrings", &m);
+    if (m < 0) {
+        error("Number of substrings (%d) needs to be non-negative.",
+              (int) m);
+        return FALSE;
+    }
+
+    radius = (int) floor(join_threshold() + 1e-6);
+    subs = m;
+    return TRUE;
+}
+
+/**
+ * Hash a symbol at a position
+ * @param i Position
+ * @param s Symbol
+ * @return hash value
+ */
+static uint64_t cell(int i, sym_t s)
+{
+    return join_mix(join_mix(i + 0x9e3779b97f4a7c15ULL) ^ s);
+}
+
+/**
+ * Return the symbol of a padded string
+ * @param x String
+ * @param i Position
+ * @return symbol or padding
+ */
+static sym_t symbol(hstring_t x, int i)
+{
+    return i < x.len ? hstring_get(x, i) : MIH_PAD;
+}
+
+/**
+ * Return the start of a substring. The maximum length is split into m
+ * substrings of nearly equal length.
+ * @param m Number of substrings
+ * @param i Index of substring
+ * @return start of substring
+ */
+static int sub_start(int m, int i)
+{
+    return (int) ((long) i * maxlen / m);
+}
+
+/**
+ * Compute the key of a substring
+ * @param x String
+ * @param m Number of substrings
+ * @param i Index of substring
+ * @return key of substring
+ */
+static uint64_t sub_key(hstring_t x, int m, int i)
+{
+    uint64_t key = join_mix(i + 1);
+
+    for (int j = sub_start(m, i); j < sub_start(m, i + 1); j++)
+        key ^= cell(j, symbol(x, j));
+
+    return key;
+}
+
+/**
+ * Add a string to the candidates
+ * @param p Probe
+ * @param id Index of string
+ */
+static void add(probe_t *p, int id)
+{
+    if (p->num == p->size) {
+        p->size = MAX(2 * p->size, 256);
+        p->cands = realloc(p->cands, p->size * sizeof(int));
+        if (!p->cands)
+            fatal("Could not allocate candidates");
+    }
+    p->cands[p->num++] = id;
+}
+
+/**
+ * Add the strings of a key in the index to the candidates
+ * @param p Probe
+ * @param key Key of substring
+ */
+static void lookup(probe_t *p, uint64_t key)
+{
+    long e = join_index_find(idx, nidx, key);
+
+    for (; e < nidx && idx[e].key == key; e++)
+        add(p, idx[e].id);
+}
+
+/**
+ * Look up a substring and its variants with up to the remaining number
+ * of mismatches at the positions from i on. Bits are replaced by the
+ * other bit and, if the strings differ in length, by the padding.
+ * @param p Probe
+ * @param key Key of substring
+ * @param i First position to change
+ * @param left Remaining mismatches
+ */
+static void variants(probe_t *p, uint64_t key, int i, int left)
+{
+    static const sym_t alts[] = { 0, 1, MIH_PAD };
+
+    lookup(p, key);
+    if (left == 0)
+        return;
+
+    for (; i < p->end; i++) {
+        sym_t s = symbol(p->y, i);
+        uint64_t k = key ^ cell(i, s);
+
+        for (int a = 0; a < (uniform ? 2 : 3); a++) {
+            if (alts[a] == s)
+                continue;
+            variants(p, k ^ cell(i, alts[a]), i + 1, left - 1);
+        }
+    }
+}
+
+/**
+ * Determine the number of substrings. Bit strings are split into
+ * substrings of about log2(n) bits, such that each key is shared by few
+ * strings. Other strings need to match a substring exactly and are split
+ * into r + 1 substrings. If the radius reaches the maximum length, no
+ * substrings are indexed, as the distance of two padded strings is at
+ * most their length.
+ * @param type Type of strings
+ * @param n Number of indexed strings
+ * @return number of substrings
+ */
+static int sub_count(int type, int n)
+{
+    int m = subs;
+
+    if (radius >= maxlen)
+        return 0;
+    if (m == 0 && type == TYPE_BIT)
+        m = (int) ceil(maxlen / MAX(log2(n), 1.0));
+    if (type != TYPE_BIT) {
+        if (m > 0 && m < radius + 1)
+            warning("Join 'mih' requires %d substrings for this type of "
+                    "strings.", radius + 1);
+        m = MAX(m, radius + 1);
+    }
+
+    return MAX(MIN(m, maxlen), 1);
+}
+
+/**
+ * Run the multi-index hashing join. The strings of the column range are
+ * indexed and the strings of the row range are probed in parallel.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+void join_mih_run(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+    int cn = m->col.end - m->col.start, type, k, rs, minlen = -1;
+    int lo = MIN(m->col.start, m->row.start);
+    int hi = MAX(m->col.end, m->row.end);
+
+    if (cn <= 0 || m->row.end <= m->row.start)
+        return;
+
+    /* Strings are padded to the maximum length of both ranges */
+    maxlen = 0;
+    for (int i = lo; i < hi; i++) {
+        if (!join_used(m, i))
+            continue;
+        maxlen = MAX(maxlen, s[i].len);
+        minlen = minlen < 0 ? s[i].len : MIN(minlen, s[i].len);
+    }
+    uniform = minlen == maxlen;
+    type = s[m->col.start].type;
+
+    /* Mismatches per substring by the pigeonhole principle */
+    k = sub_count(type, cn);
+    rs = type == TYPE_BIT && k > 0 ? radius / k : 0;
+    nidx = (long) cn * k;
+    idx = malloc(MAX(nidx, 1) * sizeof(join_entry_t));
+    if (!idx)
+        fatal("Could not allocate memory for substring index");
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (int c = m->col.start; c < m->col.end; c++) {
+        for (int i = 0; i < k; i++) {
+            long e = (long) (c - m->col.start) * k + i;
+            idx[e].key = sub_key(s[c], k, i);
+            idx[e].id = c;
+        }
+    }
+    qsort(idx, nidx, sizeof(join_entry_t), join_entry_cmp);
+
+    if (k > 0)
+        info_msg(1, "Indexed %ld substrings of %d strings (m = %d, r = %d).",
+                 nidx, cn, k, rs);
+    else
+        info_msg(1, "Radius %d reaches length %d; verifying all pairs.",
+                 radius, maxlen);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        probe_t pr;
+        if (!local)
+            fatal("Could not allocate list of pairs");
+
+        memset(&pr, 0, sizeof(pr));
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+        for (int r = m->row.start; r < m->row.end; r++) {
+            scratch_mark_t mark;
+
+            pr.y = s[r];
+            pr.num = 0;
+            for (int c = m->col.start; k == 0 && c < m->col.end; c++)
+                add(&pr, c);
+            for (int i = 0; i < k; i++) {
+                pr.end = sub_start(k, i + 1);
+                variants(&pr, sub_key(s[r], k, i), sub_start(k, i), rs);
+            }
+
+            /* Verify unique candidates */
+            qsort(pr.cands, pr.num, sizeof(int), join_int_cmp);
+            mark = scratch_mark();
+            for (int j = 0; j < pr.num; j++) {
+                int c = pr.cands[j];
+                float v;
+
+                if ((j > 0 && pr.cands[j - 1] == c) || !join_pair(m, c, r))
+                    continue;
+
+                local->cands++;
+                v = dist_hamming_compare(measure_default(), s[c], s[r]);
+                if (join_match(v))
+                    hpairs_add(local, c, r, v);
+            }
+            scratch_release(mark);
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+        free(pr.cands);
+    }
+
+    free(idx);
+    idx = NULL;
+    nidx = 0;
+}
+
+/** @} */
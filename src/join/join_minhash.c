@@ -0,0 +1,398 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "murmur.h"
+#include "measures.h"
+#include "sim_coefficient.h"
+#include "join_minhash.h"
+
+/**
+ * @addtogroup join
+ * <hr>
+ * <em>minhash</em>: Approximate join for the Jaccard coefficient.
+ *
+ * Each string is mapped to a MinHash signature of its set of symbols
+ * using one permutation hashing: the hash values of the symbols are
+ * distributed over k bins and the minimum of each bin is kept. Empty bins
+ * are filled by copying from other bins along a fixed random sequence
+ * (densification), such that the probability of two equal bins is the
+ * Jaccard coefficient of the sets. The signatures are split into bands
+ * and strings sharing a band in a hash index become candidates (locality
+ * sensitive hashing). The candidates are reported with the fraction of
+ * equal bins as estimate or verified with the coefficient.
+ *
+ * Li, Owen, and Zhang. One permutation hashing. Advances in Neural
+ * Information Processing Systems, 25:3113-3121, 2012.
+ *
+ * Shrivastava. Optimal densification for fast and accurate minwise
+ * hashing. Proceedings of the 34th International Conference on Machine
+ * Learning, 3154-3163, 2017.
+ * @{
+ */
+
+/* External variables */
+extern config_t cfg;
+
+/* Local variables */
+static int hashes = 128;
+static int bands = 32;
+static int verify = TRUE;
+static const char *file = "";
+
+/* Magic of signature files */
+#define MINHASH_MAGIC   0x32534d48
+/* Empty bin and signature of empty sets */
+#define MINHASH_EMPTY   UINT32_MAX
+
+/**
+ * Configure the join. The number of hashes, the number of bands and the
+ * verification of candidates are read from the group "minhash".
+ * @param measure Name of similarity measure
+ * @return true on success, false otherwise
+ */
+int join_minhash_config(const char *measure)
+{
+    cfg_int k, b;
+
+    if (strcmp(measure, "sim_jaccard")) {
+        error("Join 'minhash' is not supported for measure '%s'.", measure);
+        return FALSE;
+    }
+
+    config_lookup_int(&cfg, "measures.join.minhash.hashes", &k);
+    config_lookup_int(&cfg, "measures.join.minhash.bands", &b);
+    config_lookup_bool(&cfg, "measures.join.minhash.verify", &verify);
+    config_lookup_string(&cfg, "measures.join.minhash.signatures", &file);
+
+    if (k <= 0 || b <= 0 || k % b != 0) {
+        error("Number of hashes (%d) needs to be a multiple of the bands "
+              "(%d).", (int) k, (int) b);
+        return FALSE;
+    }
+    if (!verify && !sim_coefficient_binary(measure_default())) {
+        error("Estimates of join 'minhash' require binary matching.");
+        return FALSE;
+    }
+
+    hashes = k;
+    bands = b;
+    return TRUE;
+}
+
+/**
+ * Compute the MinHash signature of a string using one permutation
+ * hashing with densification.
+ * @param x String
+ * @param sig Signature of k values (output)
+ * @param bins Buffer of k values
+ */
+static void signature(hstring_t x, uint32_t *sig, uint32_t *bins)
+{
+    int i, j, full = 0;
+
+    for (i = 0; i < hashes; i++)
+        bins[i] = MINHASH_EMPTY;
+
+    for (i = 0; i < x.len; i++) {
+        sym_t s = hstring_get(x, i);
+        uint64_t h = MurmurHash64B(&s, sizeof(sym_t), 0x51ed27);
+        uint32_t v = MIN((uint32_t) h, MINHASH_EMPTY - 1);
+        j = (h >> 32) % hashes;
+        bins[j] = MIN(bins[j], v);
+    }
+
+    for (i = 0; i < hashes; i++)
+        full += bins[i] != MINHASH_EMPTY;
+
+    /* Empty bins are filled from a random sequence of non-empty bins */
+    for (i = 0; i < hashes; i++) {
+        uint64_t a = 0;
+
+        j = i;
+        while (full > 0 && bins[j] == MINHASH_EMPTY)
+            j = join_mix(((uint64_t) i << 32) + a++) % hashes;
+        sig[i] = bins[j];
+    }
+}
+
+/**
+ * Compute a digest of the strings and the number of hashes. The bands
+ * and the verification do not change the signatures and are left out.
+ * Stored signatures are only used if the digest matches.
+ * @param s Array of strings
+ * @param n Number of strings
+ * @return digest
+ */
+static uint64_t digest(hstring_t *s, int n)
+{
+    uint64_t h = join_mix(MINHASH_MAGIC ^ (uint64_t) hashes << 32);
+
+    for (int i = 0; i < n; i++) {
+        h = join_mix(h ^ ((uint64_t) s[i].type << 32 | s[i].len));
+        if (s[i].len > 0)
+            h = join_mix(h ^ hstring_hash1(s[i]));
+    }
+
+    return h;
+}
+
+/**
+ * Load signatures from a file. The file needs to match the number of
+ * strings, the number of hashes, the granularity and the digest.
+ * @param sigs Signatures (output)
+ * @param n Number of strings
+ * @param type Granularity of strings
+ * @param dg Digest of strings and configuration
+ * @return true on success, false otherwise
+ */
+static int signatures_load(uint32_t *sigs, int n, int type, uint64_t dg)
+{
+    uint32_t hdr[4];
+    size_t len = (size_t) n * hashes;
+    uint64_t d;
+    int ret = FALSE;
+    FILE *f;
+
+    f = fopen(file, "r");
+    if (!f)
+        return FALSE;
+
+    if (fread(hdr, sizeof(hdr), 1, f) != 1 || fread(&d, sizeof(d), 1, f) != 1
+        || hdr[0] != MINHASH_MAGIC || hdr[1] != (uint32_t) n ||
+        hdr[2] != (uint32_t) hashes || hdr[3] != (uint32_t) type ||
+        d != dg) {
+        warning("Signatures in '%s' do not match. Recomputing.", file);
+    } else if (fread(sigs, sizeof(uint32_t), len, f) != len) {
+        warning("Could not read signatures from '%s'.", file);
+    } else {
+        ret = TRUE;
+    }
+
+    fclose(f);
+    return ret;
+}
+
+/**
+ * Save signatures to a file. The file has the form
+ * <pre>
+ * | magic (uint32) | num (uint32) | hashes (uint32) | type (uint32) |
+ * | digest (uint64) | signatures (uint32) ... |
+ * </pre>
+ * @param sigs Signatures
+ * @param n Number of strings
+ * @param type Granularity of strings
+ * @param dg Digest of strings and configuration
+ */
+static void signatures_save(uint32_t *sigs, int n, int type, uint64_t dg)
+{
+    uint32_t hdr[4] = { MINHASH_MAGIC, n, hashes, type };
+    size_t len = (size_t) n * hashes;
+    FILE *f;
+
+    f = fopen(file, "w");
+    if (!f) {
+        error("Could not open signature file '%s'.", file);
+        return;
+    }
+
+    if (fwrite(hdr, sizeof(hdr), 1, f) != 1 ||
+        fwrite(&dg, sizeof(dg), 1, f) != 1 ||
+        fwrite(sigs, sizeof(uint32_t), len, f) != len)
+        error("Could not write signatures to '%s'.", file);
+
+    fclose(f);
+}
+
+/**
+ * Compute the signatures of the strings in parallel. If a signature file
+ * is configured, the signatures of all strings are loaded from it or
+ * computed and saved for later runs.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @return signatures of all strings (to be freed)
+ */
+static uint32_t *signatures_create(hmatrix_t *m, hstring_t *s)
+{
+    int n = m->num, type = n > 0 ? s[0].type : 0;
+    int save = strlen(file) > 0;
+    uint64_t dg = 0;
+    uint32_t *sigs;
+
+    sigs = malloc(MAX((size_t) n * hashes, 1) * sizeof(uint32_t));
+    if (!sigs)
+        fatal("Could not allocate memory for signatures");
+
+    if (save)
+        dg = digest(s, n);
+
+    if (save && signatures_load(sigs, n, type, dg)) {
+        info_msg(1, "Loaded signatures of %d strings from '%s'.", n, file);
+        return sigs;
+    }
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        uint32_t *bins = malloc(hashes * sizeof(uint32_t));
+        if (!bins)
+            fatal("Could not allocate memory for signatures");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 256)
+#endif
+        for (int i = 0; i < n; i++) {
+            /* Only strings of the ranges are needed without saving */
+            if (!save && !join_used(m, i))
+                continue;
+            signature(s[i], sigs + (size_t) i * hashes, bins);
+        }
+        free(bins);
+    }
+
+    if (save) {
+        signatures_save(sigs, n, type, dg);
+        info_msg(1, "Saved signatures of %d strings to '%s'.", n, file);
+    }
+
+    return sigs;
+}
+
+/**
+ * Compute the hash of a band of a signature
+ * @param sig Signature
+ * @param b Index of band
+ * @return hash of band
+ */
+static uint64_t band_key(uint32_t *sig, int b)
+{
+    int rows = hashes / bands;
+    return MurmurHash64B(sig + b * rows, rows * sizeof(uint32_t), b);
+}
+
+/**
+ * Estimate the Jaccard coefficient from two signatures
+ * @param x First signature
+ * @param y Second signature
+ * @return fraction of equal values
+ */
+static float estimate(uint32_t *x, uint32_t *y)
+{
+    int i, eq = 0;
+
+    for (i = 0; i < hashes; i++)
+        eq += x[i] == y[i];
+
+    return eq / (float) hashes;
+}
+
+/**
+ * Run the MinHash join. The bands of the column strings are indexed and
+ * the row strings are probed in parallel.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+void join_minhash_run(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+    int cn = m->col.end - m->col.start;
+    uint32_t *sigs;
+    join_entry_t *idx;
+
+    sigs = signatures_create(m, s);
+    idx = malloc(MAX((size_t) bands * cn, 1) * sizeof(join_entry_t));
+    if (!idx)
+        fatal("Could not allocate memory for band index");
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int b = 0; b < bands; b++) {
+        join_entry_t *e = idx + (size_t) b * cn;
+        for (int c = m->col.start; c < m->col.end; c++, e++) {
+            e->key = band_key(sigs + (size_t) c * hashes, b);
+            e->id = c;
+        }
+        qsort(idx + (size_t) b * cn, cn, sizeof(join_entry_t), join_entry_cmp);
+    }
+
+    info_msg(1, "Indexed %d bands of %d strings (%d hashes).", bands, cn,
+             hashes);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        int *cands = NULL, num, size = 0;
+        if (!local)
+            fatal("Could not allocate list of pairs");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+        for (int r = m->row.start; r < m->row.end; r++) {
+            uint32_t *y = sigs + (size_t) r * hashes;
+
+            num = 0;
+            for (int b = 0; b < bands; b++) {
+                join_entry_t *band = idx + (size_t) b * cn;
+                uint64_t key = band_key(y, b);
+                long e = join_index_find(band, cn, key);
+
+                for (; e < cn && band[e].key == key; e++) {
+                    if (!join_pair(m, band[e].id, r))
+                        continue;
+                    if (num == size) {
+                        size = MAX(2 * size, 256);
+                        cands = realloc(cands, size * sizeof(int));
+                        if (!cands)
+                            fatal("Could not allocate candidates");
+                    }
+                    cands[num++] = band[e].id;
+                }
+            }
+
+            /* Estimate or verify unique candidates */
+            qsort(cands, num, sizeof(int), join_int_cmp);
+            for (int j = 0; j < num; j++) {
+                int c = cands[j];
+                float v;
+
+                if (j > 0 && cands[j - 1] == c)
+                    continue;
+
+                local->cands++;
+                if (verify)
+                    v = measure_compare(s[c], s[r]);
+                else
+                    v = estimate(sigs + (size_t) c * hashes, y);
+                if (join_match(v))
+                    hpairs_add(local, c, r, v);
+            }
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+        free(cands);
+    }
+
+    free(idx);
+    free(sigs);
+}
+
+/** @} */
@@ -0,0 +1,484 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "measures.h"
+#include "join_nndescent.h"
+
+/**
+ * @addtogroup join
+ * <hr>
+ * <em>nndescent</em>: Approximate nearest neighbors by NN-descent.
+ *
+ * Each string starts with k random row strings as neighbors. In every
+ * iteration, the neighbors and reverse neighbors of a string are compared
+ * with each other, since a neighbor of a neighbor is likely a neighbor as
+ * well. Only pairs involving a neighbor added in the previous iteration
+ * are compared. The lists of neighbors are updated in parallel, where each
+ * list is protected by a lock. The search stops if at most delta * n * k
+ * neighbors have changed in an iteration. The search hardly proceeds over
+ * few neighbors, such that at least 10 neighbors are kept and the best k
+ * are reported. The method works with any measure, yet assumes that the
+ * measure is symmetric, and compares about n * k^2 pairs per iteration
+ * instead of all pairs.
+ *
+ * Dong, Moses, and Li. Efficient k-nearest neighbor graph construction
+ * for generic similarity measures. Proceedings of the International
+ * Conference on World Wide Web (WWW), 577-586, 2011.
+ * @{
+ */
+
+/* External variables */
+extern config_t cfg;
+
+/* Minimum number of neighbors in the graph */
+#define MIN_DEGREE      10
+
+/**
+ * Neighbor in the graph
+ */
+typedef struct
+{
+    int id;                     /**< Index of row string */
+    float v;                    /**< Similarity value */
+    int fresh;                  /**< Flag for neighbor not yet joined */
+} nbr_t;
+
+/**
+ * Candidates of one string for the local join
+ */
+typedef struct
+{
+    int *ids;                   /**< Indices of strings */
+    int num;                    /**< Number of strings */
+    int seen;                   /**< Number of offered strings */
+} cands_t;
+
+/* Local variables */
+static int iterations = 10;
+static double delta = 0.001;
+static int distance = TRUE;
+
+/* Graph of all strings */
+static nbr_t *graph = NULL;
+static int *degree = NULL;
+static int base = 0;
+static int k = 0;
+#ifdef HAVE_OPENMP
+static omp_lock_t *locks = NULL;
+#endif
+
+/**
+ * Configure the join. The method requires a number of neighbors.
+ * @param measure Name of similarity measure
+ * @return true on success, false otherwise
+ */
+int join_nndescent_config(const char *measure)
+{
+    cfg_int i;
+
+    if (!join_neighbors()) {
+        error("Join 'nndescent' requires a number of neighbors.");
+        return FALSE;
+    }
+
+    config_lookup_int(&cfg, "measures.join.nndescent.iterations", &i);
+    config_lookup_float(&cfg, "measures.join.nndescent.delta", &delta);
+    if (i < 1) {
+        error("Number of iterations (%d) needs to be positive.", (int) i);
+        return FALSE;
+    }
+    if (delta < 0) {
+        error("Convergence threshold (%g) needs to be non-negative.", delta);
+        return FALSE;
+    }
+
+    iterations = i;
+    distance = !strncmp(measure, "dist_", 5);
+    return TRUE;
+}
+
+/**
+ * Return the next random number of a generator (SplitMix64)
+ * @param state State of generator
+ * @return random number
+ */
+static uint64_t rand_next(uint64_t *state)
+{
+    *state += 0x9e3779b97f4a7c15ULL;
+    return join_mix(*state);
+}
+
+/**
+ * Check whether a neighbor is worse than another one. Larger distances
+ * and smaller similarity values are worse; ties are broken by index.
+ * @param a First neighbor
+ * @param b Second neighbor
+ * @return true if the first neighbor is worse, false otherwise
+ */
+static int worse(const nbr_t *a, const nbr_t *b)
+{
+    if (a->v != b->v)
+        return distance ? a->v > b->v : a->v < b->v;
+    return a->id > b->id;
+}
+
+/**
+ * Insert a neighbor into the list of a string. The list is a heap with
+ * the worst neighbor on top and is locked during the update.
+ * @param x Index of string
+ * @param y Index of row string
+ * @param v Similarity value
+ * @return true if the list has changed, false otherwise
+ */
+static int insert(int x, int y, float v)
+{
+    nbr_t *h = graph + (long) (x - base) * k, e = { y, v, TRUE };
+    int *n = degree + x - base, i, j, ret = FALSE;
+
+    if (isnan(v))
+        return FALSE;
+
+#ifdef HAVE_OPENMP
+    omp_set_lock(locks + x - base);
+#endif
+    if (*n == k && !worse(h, &e))
+        goto out;
+    for (i = 0; i < *n; i++)
+        if (h[i].id == y)
+            goto out;
+
+    if (*n < k) {
+        /* Sift up */
+        for (i = (*n)++; i > 0; i = j) {
+            j = (i - 1) / 2;
+            if (!worse(&e, h + j))
+                break;
+            h[i] = h[j];
+        }
+    } else {
+        /* Sift down */
+        for (i = 0; (j = 2 * i + 1) < *n; i = j) {
+            if (j + 1 < *n && worse(h + j + 1, h + j))
+                j++;
+            if (!worse(h + j, &e))
+                break;
+            h[i] = h[j];
+        }
+    }
+    h[i] = e;
+    ret = TRUE;
+
+  out:
+#ifdef HAVE_OPENMP
+    omp_unset_lock(locks + x - base);
+#endif
+    return ret;
+}
+
+/**
+ * Compare a string with candidates and update the lists of both
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param x Index of string
+ * @param ys Indices of candidates
+ * @param num Number of candidates
+ * @return number of updates
+ */
+static long update(hmatrix_t *m, hstring_t *s, int x, int *ys, int num)
+{
+    hstring_t strs[HMATRIX_TILE];
+    float out[HMATRIX_TILE];
+    long changes = 0;
+
+    for (int i = 0; i < num; i++)
+        strs[i] = s[ys[i]];
+    measure_compare_batch(s[x], strs, num, out);
+
+    /* Only row strings are neighbors */
+    for (int i = 0; i < num; i++) {
+        if (ys[i] >= m->row.start && ys[i] < m->row.end)
+            changes += insert(x, ys[i], out[i]);
+        if (x >= m->row.start && x < m->row.end)
+            changes += insert(ys[i], x, out[i]);
+    }
+
+    return changes;
+}
+
+/**
+ * Add a string to a list of candidates. If the list is full, the string
+ * replaces a random candidate, such that each offered string is kept with
+ * equal probability (reservoir sampling).
+ * @param c List of candidates
+ * @param y Index of string
+ * @param state State of random generator
+ */
+static void offer(cands_t *c, int y, uint64_t *state)
+{
+    for (int i = 0; i < c->num; i++)
+        if (c->ids[i] == y)
+            return;
+
+    if (c->num < 2 * k) {
+        c->ids[c->num++] = y;
+    } else {
+        uint64_t j = rand_next(state) % (c->seen + 1);
+        if (j < (uint64_t) c->num)
+            c->ids[j] = y;
+    }
+    c->seen++;
+}
+
+/**
+ * Initialize the graph with random row strings as neighbors
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param lo First string of graph
+ * @param hi End of graph
+ * @return number of comparisons
+ */
+static long random_graph(hmatrix_t *m, hstring_t *s, int lo, int hi)
+{
+    int rn = m->row.end - m->row.start;
+    long cmps = 0;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel reduction(+:cmps)
+#endif
+    {
+        int *ys = malloc(k * sizeof(int));
+        if (!ys)
+            fatal("Could not allocate memory for neighbors");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+        for (int x = lo; x < hi; x++) {
+            uint64_t state = join_mix(x + 1);
+            int num = 0;
+
+            if (!join_used(m, x))
+                continue;
+
+            /* Few row strings are taken completely */
+            for (int i = 0; num < k && i < 4 * k + rn; i++) {
+                int y, j;
+
+                if (rn > 2 * k + 1)
+                    y = m->row.start + rand_next(&state) % rn;
+                else if (i < rn)
+                    y = m->row.start + i;
+                else
+                    break;
+
+                for (j = 0; j < num && ys[j] != y; j++);
+                if (y != x && j == num)
+                    ys[num++] = y;
+            }
+
+            for (int i = 0; i < num; i += HMATRIX_TILE)
+                update(m, s, x, ys + i, MIN(num - i, HMATRIX_TILE));
+            cmps += num;
+        }
+        free(ys);
+    }
+
+    return cmps;
+}
+
+/**
+ * Collect the candidates of the local join. The new and old neighbors of
+ * each string are added to its candidates and, in reverse, the string to
+ * the candidates of its neighbors. New neighbors are marked as joined.
+ * @param lo First string of graph
+ * @param hi End of graph
+ * @param fresh New candidates
+ * @param old Old candidates
+ */
+static void candidates(int lo, int hi, cands_t *fresh, cands_t *old)
+{
+    uint64_t state = join_mix(hi);
+
+    for (int x = 0; x < hi - lo; x++)
+        fresh[x].num = fresh[x].seen = old[x].num = old[x].seen = 0;
+
+    for (int x = 0; x < hi - lo; x++) {
+        nbr_t *h = graph + (long) x * k;
+
+        for (int i = 0; i < degree[x]; i++) {
+            int y = h[i].id - lo;
+            cands_t *c = h[i].fresh ? fresh : old;
+
+            offer(c + x, y + lo, &state);
+            offer(c + y, x + lo, &state);
+            h[i].fresh = FALSE;
+        }
+    }
+}
+
+/**
+ * Run the local join of all strings in parallel. New candidates are
+ * compared with each other and with old candidates.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param lo First string of graph
+ * @param hi End of graph
+ * @param fresh New candidates
+ * @param old Old candidates
+ * @param cmps Number of comparisons (output)
+ * @return number of updates
+ */
+static long local_join(hmatrix_t *m, hstring_t *s, int lo, int hi,
+                       cands_t *fresh, cands_t *old, long *cmps)
+{
+    long changes = 0, total = 0;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel reduction(+:changes,total)
+#endif
+    {
+        int *ys = malloc(4 * k * sizeof(int));
+        if (!ys)
+            fatal("Could not allocate memory for candidates");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+        for (int x = 0; x < hi - lo; x++) {
+            cands_t *f = fresh + x, *o = old + x;
+
+            for (int i = 0; i < f->num; i++) {
+                int num = 0;
+
+                for (int j = i + 1; j < f->num; j++)
+                    ys[num++] = f->ids[j];
+                for (int j = 0; j < o->num; j++)
+                    if (o->ids[j] != f->ids[i])
+                        ys[num++] = o->ids[j];
+
+                for (int j = 0; j < num; j += HMATRIX_TILE)
+                    changes += update(m, s, f->ids[i], ys + j,
+                                      MIN(num - j, HMATRIX_TILE));
+                total += num;
+            }
+        }
+        free(ys);
+    }
+
+    *cmps += total;
+    return changes;
+}
+
+/**
+ * Run NN-descent over the strings of the row and column range. Only row
+ * strings are used as neighbors and the neighbors of the column strings
+ * are reported.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+void join_nndescent_run(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+    int lo = MIN(m->col.start, m->row.start);
+    int hi = MAX(m->col.end, m->row.end), n = 0, it;
+    cands_t *fresh, *old;
+    long changes = 0;
+    int *ids;
+
+    if (m->row.end <= m->row.start || m->col.end <= m->col.start)
+        return;
+
+    k = MAX(join_neighbors(), MIN_DEGREE);
+    base = lo;
+    graph = malloc((long) (hi - lo) * k * sizeof(nbr_t));
+    degree = calloc(hi - lo, sizeof(int));
+    fresh = malloc((hi - lo) * sizeof(cands_t));
+    old = malloc((hi - lo) * sizeof(cands_t));
+    ids = malloc((long) (hi - lo) * 4 * k * sizeof(int));
+    if (!graph || !degree || !fresh || !old || !ids)
+        fatal("Could not allocate memory for graph");
+
+    for (int x = 0; x < hi - lo; x++) {
+        fresh[x].ids = ids + (long) x * 4 * k;
+        old[x].ids = fresh[x].ids + 2 * k;
+        n += join_used(m, x + lo);
+    }
+
+#ifdef HAVE_OPENMP
+    locks = malloc((hi - lo) * sizeof(omp_lock_t));
+    if (!locks)
+        fatal("Could not allocate memory for locks");
+    for (int x = 0; x < hi - lo; x++)
+        omp_init_lock(locks + x);
+#endif
+
+    p->cands += random_graph(m, s, lo, hi);
+
+    for (it = 0; it < iterations; it++) {
+        candidates(lo, hi, fresh, old);
+        changes = local_join(m, s, lo, hi, fresh, old, &p->cands);
+        info_msg(1, "Iteration %d: %ld neighbors changed.", it + 1,
+                 changes);
+        if (changes <= delta * n * k) {
+            it++;
+            break;
+        }
+    }
+
+    info_msg(1, "Stopped after %d iterations with %ld changes (delta = %g).",
+             it, changes, delta);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        join_knn_t *knn = join_knn_init();
+        if (!local || !knn)
+            fatal("Could not allocate list of pairs");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (int c = m->col.start; c < m->col.end; c++) {
+            nbr_t *h = graph + (long) (c - lo) * k;
+            for (int i = 0; i < degree[c - lo]; i++)
+                join_knn_add(knn, c, h[i].id, h[i].v);
+            join_knn_flush(knn, local);
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+        join_knn_destroy(knn);
+    }
+
+#ifdef HAVE_OPENMP
+    for (int x = 0; x < hi - lo; x++)
+        omp_destroy_lock(locks + x);
+    free(locks);
+    locks = NULL;
+#endif
+    free(ids);
+    free(old);
+    free(fresh);
+    free(degree);
+    free(graph);
+    graph = NULL;
+    degree = NULL;
+}
+
+/** @} */
@@ -0,0 +1,21 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef JOIN_NNDESCENT_H
+#define JOIN_NNDESCENT_H
+
+#include "join.h"
+
+/* Module interface */
+int join_nndescent_config(const char *);
+void join_nndescent_run(hmatrix_t *, hstring_t *, hpairs_t *);
+
+#endif /* JOIN_NNDESCENT_H */
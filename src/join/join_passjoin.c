@@ -0,0 +1,283 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "murmur.h"
+#include "scratch.h"
+#include "dist_levenshtein.h"
+#include "join_passjoin.h"
+
+/**
+ * @addtogroup join
+ * <hr>
+ * <em>passjoin</em>: Partition-based join for the Levenshtein distance.
+ *
+ * Each indexed string is split into tau + 1 segments, where tau is the
+ * maximum number of edits. By the pigeonhole principle, a string within
+ * distance tau contains one of the segments as substring. The segments
+ * are indexed by length of the string and position, and a probed string
+ * only looks up its substrings at positions that are compatible with the
+ * length difference and the segment (multi-match-aware selection). The
+ * candidates are verified with a banded edit distance.
+ *
+ * Li, Deng, Wang, and Feng. Pass-join: A partition-based method for
+ * similarity joins. Proceedings of the VLDB Endowment, 5(3):253-264,
+ * 2011.
+ * @{
+ */
+
+/* External variables */
+extern config_t cfg;
+
+/* Local variables */
+static int tau = 0;
+static double cost = 1.0;
+
+/**
+ * Configure the join. The Levenshtein distance needs to use equal costs
+ * and no normalization, such that the threshold is a number of edits.
+ * @param measure Name of similarity measure
+ * @return true on success, false otherwise
+ */
+int join_passjoin_config(const char *measure)
+{
+    double ins, del, sub;
+    const char *str;
+
+    if (strcmp(measure, "dist_levenshtein")) {
+        error("Join 'passjoin' is not supported for measure '%s'.",
+              measure);
+        return FALSE;
+    }
+
+    config_lookup_float(&cfg, "measures.dist_levenshtein.cost_ins", &ins);
+    config_lookup_float(&cfg, "measures.dist_levenshtein.cost_del", &del);
+    config_lookup_float(&cfg, "measures.dist_levenshtein.cost_sub", &sub);
+    config_lookup_string(&cfg, "measures.dist_levenshtein.norm", &str);
+
+    if (fabs(ins - del) > 1e-6 || fabs(del - sub) > 1e-6 || ins <= 0) {
+        error("Join 'passjoin' requires equal costs of edit operations.");
+        return FALSE;
+    }
+    if (strcasecmp(str, "none")) {
+        error("Join 'passjoin' does not support normalization.");
+        return FALSE;
+    }
+    if (join_threshold() < 0) {
+        error("Join 'passjoin' requires a non-negative threshold.");
+        return FALSE;
+    }
+
+    cost = ins;
+    tau = (int) floor(join_threshold() / cost + 1e-6);
+    return TRUE;
+}
+
+/**
+ * Return the start of a segment. A string of length l is split into
+ * tau + 1 segments, where the last l % (tau + 1) segments are one symbol
+ * longer than the others.
+ * @param l Length of string
+ * @param i Index of segment
+ * @return start of segment
+ */
+static int seg_start(int l, int i)
+{
+    int n = tau + 1, b = l / n, r = n - l % n;
+    return i * b + MAX(0, i - r);
+}
+
+/**
+ * Return the length of a segment
+ * @param l Length of string
+ * @param i Index of segment
+ * @return length of segment
+ */
+static int seg_len(int l, int i)
+{
+    return seg_start(l, i + 1) - seg_start(l, i);
+}
+
+/**
+ * Compute the key of a substring. The hash of the substring is combined
+ * with the length of the indexed string and the index of the segment.
+ * @param x String
+ * @param p Start of substring
+ * @param n Length of substring
+ * @param l Length of indexed string
+ * @param i Index of segment
+ * @return key of substring
+ */
+static uint64_t seg_key(hstring_t x, int p, int n, int l, int i)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    switch (x.type) {
+    case TYPE_BYTE:
+        h = MurmurHash64B(x.str.c + p, n, 0xc0ffee);
+        break;
+    case TYPE_TOKEN:
+        h = MurmurHash64B(x.str.s + p, n * sizeof(sym_t), 0xc0ffee);
+        break;
+    default:
+        for (int j = p; j < p + n; j++)
+            h = (h ^ hstring_get(x, j)) * 0x100000001b3ULL;
+        break;
+    }
+
+    return h ^ ((uint64_t) l * 0x9e3779b97f4a7c15ULL) ^
+        ((uint64_t) (i + 1) * 0xc2b2ae3d27d4eb4fULL);
+}
+
+/**
+ * Run the partition-based join. The strings of the column range are
+ * indexed and the strings of the row range are probed in parallel.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+void join_passjoin_run(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+    join_entry_t *idx;
+    int *shorts, *lens, nshort = 0, maxlen = 0;
+    long nidx = 0;
+
+    /* Count lengths of indexed strings */
+    for (int c = m->col.start; c < m->col.end; c++)
+        maxlen = MAX(maxlen, s[c].len);
+
+    lens = calloc(maxlen + 1, sizeof(int));
+    shorts = malloc(MAX(m->col.end - m->col.start, 1) * sizeof(int));
+    idx = malloc(MAX((long) (m->col.end - m->col.start) * (tau + 1), 1) *
+                 sizeof(join_entry_t));
+    if (!lens || !shorts || !idx)
+        fatal("Could not allocate memory for segment index");
+
+    /* Strings shorter than tau + 1 have empty segments */
+    for (int c = m->col.start; c < m->col.end; c++) {
+        int l = s[c].len;
+        if (l <= tau) {
+            shorts[nshort++] = c;
+            continue;
+        }
+        lens[l]++;
+        for (int i = 0; i <= tau; i++) {
+            idx[nidx].key = seg_key(s[c], seg_start(l, i), seg_len(l, i),
+                                    l, i);
+            idx[nidx++].id = c;
+        }
+    }
+    qsort(idx, nidx, sizeof(join_entry_t), join_entry_cmp);
+
+    info_msg(1, "Indexed %ld segments of %d strings (tau = %d).", nidx,
+             m->col.end - m->col.start - nshort, tau);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        int *cands = NULL, num, size = 0;
+        if (!local)
+            fatal("Could not allocate list of pairs");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+        for (int r = m->row.start; r < m->row.end; r++) {
+            hstring_t y = s[r];
+            int l0 = MAX(0, y.len - tau), l1 = MIN(maxlen, y.len + tau);
+            scratch_mark_t mark;
+
+            num = 0;
+            for (int l = MAX(l0, tau + 1); l <= l1; l++) {
+                int d = y.len - l;
+
+                if (lens[l] == 0)
+                    continue;
+
+                for (int i = 0; i <= tau; i++) {
+                    int ps = seg_start(l, i), n = seg_len(l, i);
+
+                    /* Multi-match-aware selection of substrings */
+                    int lo = MAX(ps - i, ps + d - (tau - i));
+                    int hi = MIN(ps + i, ps + d + (tau - i));
+                    lo = MAX(lo, 0);
+                    hi = MIN(hi, y.len - n);
+
+                    for (int q = lo; q <= hi; q++) {
+                        uint64_t key = seg_key(y, q, n, l, i);
+                        long e = join_index_find(idx, nidx, key);
+
+                        for (; e < nidx && idx[e].key == key; e++) {
+                            if (!join_pair(m, idx[e].id, r))
+                                continue;
+                            if (num == size) {
+                                size = MAX(2 * size, 256);
+                                cands = realloc(cands, size * sizeof(int));
+                                if (!cands)
+                                    fatal("Could not allocate candidates");
+                            }
+                            cands[num++] = idx[e].id;
+                        }
+                    }
+                }
+            }
+
+            /* Short strings are only filtered by length */
+            for (int j = 0; j < nshort; j++) {
+                int c = shorts[j];
+                if (abs(s[c].len - y.len) > tau || !join_pair(m, c, r))
+                    continue;
+                if (num == size) {
+                    size = MAX(2 * size, 256);
+                    cands = realloc(cands, size * sizeof(int));
+                    if (!cands)
+                        fatal("Could not allocate candidates");
+                }
+                cands[num++] = c;
+            }
+
+            /* Verify unique candidates */
+            qsort(cands, num, sizeof(int), join_int_cmp);
+            mark = scratch_mark();
+            for (int j = 0; j < num; j++) {
+                int c = cands[j], e;
+                float v;
+
+                if (j > 0 && cands[j - 1] == c)
+                    continue;
+
+                local->cands++;
+                e = dist_levenshtein_bounded(s[c], y, tau);
+                v = cost * e;
+                if (e <= tau && join_match(v))
+                    hpairs_add(local, c, r, v);
+            }
+            scratch_release(mark);
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+        free(cands);
+    }
+
+    free(idx);
+    free(shorts);
+    free(lens);
+}
+
+/** @} */
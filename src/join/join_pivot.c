@@ -0,0 +1,327 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "measures.h"
+#include "join_pivot.h"
+
+/**
+ * @addtogroup join
+ * <hr>
+ * <em>pivot</em>: Pivot-based pruning for metric distances.
+ *
+ * A few row strings are selected as pivots by farthest-first traversal,
+ * such that each pivot is the string farthest from the pivots chosen
+ * before. The distances of all strings to the pivots are computed once.
+ * By the triangle inequality, |d(x,p) - d(y,p)| <= d(x,y) holds for each
+ * pivot p, and the maximum over the pivots is a lower bound of the
+ * distance. Pairs whose bound exceeds the threshold or the distance of
+ * the current k-th neighbor are skipped without computing the measure.
+ * For nearest neighbors, the strings with the smallest bounds are
+ * verified first to obtain a tight bound early.
+ *
+ * Mico, Oncina, and Vidal. A new version of the nearest-neighbour
+ * approximating and eliminating search algorithm (AESA) with linear
+ * preprocessing time and memory requirements. Pattern Recognition
+ * Letters, 15(1):9-17, 1994.
+ * @{
+ */
+
+/* External variables */
+extern config_t cfg;
+
+
+/* Local variables */
+static int pivots = 16;
+
+/**
+ * Configure the join. Only distances that satisfy the triangle
+ * inequality are supported.
+ * @param measure Name of similarity measure
+ * @return true on success, false otherwise
+ */
+int join_pivot_config(const char *measure)
+{
+    cfg_int k;
+    int integer;
+
+    if (!join_metric("pivot", measure, &integer))
+        return FALSE;
+
+    if (!join_neighbors() && join_threshold() < 0) {
+        error("Join 'pivot' requires a non-negative threshold.");
+        return FALSE;
+    }
+
+    config_lookup_int(&cfg, "measures.join.pivot.pivots", &k);
+    if (k < 1) {
+        error("Number of pivots (%d) needs to be positive.", (int) k);
+        return FALSE;
+    }
+
+    pivots = k;
+    return TRUE;
+}
+
+/**
+ * Check whether the lower bound of the distance of two strings exceeds a
+ * radius. The bound is the maximum over the pivots, such that the check
+ * stops at the first pivot exceeding the radius.
+ * @param a Distances of first string to pivots
+ * @param b Distances of second string to pivots
+ * @param n Number of pivots
+ * @param r Radius
+ * @return true if the bound exceeds the radius, false otherwise
+ */
+static int exceeds(const float *a, const float *b, int n, double r)
+{
+    float t = r + JOIN_TOLERANCE * (1 + fabs(r));
+
+    for (int j = 0; j < n; j++)
+        if (fabsf(a[j] - b[j]) > t)
+            return TRUE;
+
+    return FALSE;
+}
+
+/**
+ * Lower bound of the distance of two strings using the pivot table
+ * @param a Distances of first string to pivots
+ * @param b Distances of second string to pivots
+ * @param n Number of pivots
+ * @return lower bound of distance
+ */
+static float lower_bound(const float *a, const float *b, int n)
+{
+    float lb = 0;
+
+    for (int j = 0; j < n; j++)
+        lb = MAX(lb, fabsf(a[j] - b[j]));
+
+    return lb;
+}
+
+/**
+ * Select pivots by farthest-first traversal and compute the distances of
+ * all strings to the pivots. The distances of a string to the pivots are
+ * stored consecutively.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param lo First string of table
+ * @param hi End of table
+ * @param n Number of pivots (in/out)
+ * @return pivot table
+ */
+static float *pivot_table(hmatrix_t *m, hstring_t *s, int lo, int hi,
+                          int *n)
+{
+    int rn = m->row.end - m->row.start, p = m->row.start, j;
+    int tiles = (hi - lo + HMATRIX_TILE - 1) / HMATRIX_TILE;
+    float *tab, *mind;
+
+    *n = MIN(*n, rn);
+    tab = malloc(MAX((long) (hi - lo) * *n, 1) * sizeof(float));
+    mind = malloc(rn * sizeof(float));
+    if (!tab || !mind)
+        fatal("Could not allocate memory for pivot table");
+
+    for (int r = 0; r < rn; r++)
+        mind[r] = INFINITY;
+
+    for (j = 0; j < *n; j++) {
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (int t = 0; t < tiles; t++) {
+            hstring_t ys[HMATRIX_TILE];
+            float out[HMATRIX_TILE];
+            int is[HMATRIX_TILE], num = 0;
+            int i1 = MIN(lo + (t + 1) * HMATRIX_TILE, hi);
+
+            for (int i = lo + t * HMATRIX_TILE; i < i1; i++) {
+                if (!join_used(m, i))
+                    continue;
+                ys[num] = s[i];
+                is[num++] = i;
+            }
+            if (num == 0)
+                continue;
+
+            measure_compare_batch(s[p], ys, num, out);
+            for (int i = 0; i < num; i++)
+                tab[(long) (is[i] - lo) * *n + j] = out[i];
+        }
+
+        /* Next pivot is the string farthest from all pivots */
+        float far = 0;
+        for (int r = 0; r < rn; r++) {
+            float d = tab[(long) (r + m->row.start - lo) * *n + j];
+            mind[r] = MIN(mind[r], d);
+            if (mind[r] > far) {
+                far = mind[r];
+                p = r + m->row.start;
+            }
+        }
+
+        /* Remaining strings coincide with the pivots */
+        if (far == 0) {
+            j++;
+            break;
+        }
+    }
+
+    /* Compact the table if fewer pivots are distinct */
+    if (j < *n) {
+        for (long i = 0; i < hi - lo; i++)
+            memmove(tab + i * j, tab + i * *n, j * sizeof(float));
+        *n = j;
+    }
+
+    free(mind);
+    return tab;
+}
+
+/**
+ * Run the pivot join. The row and column strings are compared with the
+ * pivots and the column strings are processed in parallel.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+void join_pivot_run(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+    int lo = MIN(m->col.start, m->row.start);
+    int hi = MAX(m->col.end, m->row.end);
+    int rn = m->row.end - m->row.start, n = pivots;
+    long pairs = 0, pruned = 0;
+    float *tab;
+
+    if (rn <= 0 || m->col.end <= m->col.start)
+        return;
+
+    tab = pivot_table(m, s, lo, hi, &n);
+    info_msg(1, "Selected %d pivots and compared %d strings with them.", n,
+             hi - lo);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel reduction(+:pairs,pruned)
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        join_knn_t *knn = NULL, *seed = NULL;
+        hstring_t ys[HMATRIX_TILE];
+        int rs[HMATRIX_TILE];
+        float *lbs = NULL;
+        if (!local)
+            fatal("Could not allocate list of pairs");
+
+        if (join_neighbors()) {
+            knn = join_knn_init();
+            seed = join_knn_init();
+            lbs = malloc(rn * sizeof(float));
+            if (!knn || !seed || !lbs)
+                fatal("Could not allocate list of neighbors");
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+        for (int c = m->col.start; c < m->col.end; c++) {
+            const float *a = tab + (long) (c - lo) * n;
+            double t = join_threshold();
+            int num = 0;
+
+            /* Verify the row strings with the smallest bounds first */
+            if (knn) {
+                for (int r = m->row.start; r < m->row.end; r++) {
+                    float *lb = lbs + r - m->row.start;
+                    *lb = NAN;
+                    if (!join_pair(m, c, r))
+                        continue;
+                    *lb = lower_bound(a, tab + (long) (r - lo) * n, n);
+                    join_knn_add(seed, c, r, *lb);
+                }
+
+                for (int i = 0; i < seed->num; i++) {
+                    int r = seed->heap[i].y;
+                    lbs[r - m->row.start] = NAN;
+                    ys[num] = s[r];
+                    rs[num++] = r;
+                    if (num == HMATRIX_TILE) {
+                        join_verify(s[c], c, ys, rs, num, local, knn);
+                        num = 0;
+                    }
+                }
+                if (num > 0)
+                    join_verify(s[c], c, ys, rs, num, local, knn);
+                pairs += seed->num;
+                seed->num = 0;
+                num = 0;
+                t = join_knn_bound(knn);
+                t += JOIN_TOLERANCE * (1 + fabs(t));
+            }
+
+            for (int r = m->row.start; r < m->row.end; r++) {
+                if (knn) {
+                    float lb = lbs[r - m->row.start];
+                    if (isnan(lb))
+                        continue;
+                    pairs++;
+                    if (lb > t) {
+                        pruned++;
+                        continue;
+                    }
+                } else {
+                    if (!join_pair(m, c, r))
+                        continue;
+                    pairs++;
+                    if (exceeds(a, tab + (long) (r - lo) * n, n, t)) {
+                        pruned++;
+                        continue;
+                    }
+                }
+
+                ys[num] = s[r];
+                rs[num++] = r;
+                if (num == HMATRIX_TILE) {
+                    join_verify(s[c], c, ys, rs, num, local, knn);
+                    num = 0;
+                    if (knn) {
+                        t = join_knn_bound(knn);
+                        t += JOIN_TOLERANCE * (1 + fabs(t));
+                    }
+                }
+            }
+            if (num > 0)
+                join_verify(s[c], c, ys, rs, num, local, knn);
+            if (knn)
+                join_knn_flush(knn, local);
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+        join_knn_destroy(knn);
+        join_knn_destroy(seed);
+        free(lbs);
+    }
+
+    info_msg(1, "Pruned %ld of %ld pairs (%.2f%%) using the pivots.",
+             pruned, pairs, pairs > 0 ? 100.0 * pruned / pairs : 0.0);
+
+    free(tab);
+}
+
+/** @} */
@@ -0,0 +1,564 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "sim_coefficient.h"
+#include "join_prefix.h"
+
+/**
+ * @addtogroup join
+ * <hr>
+ * <em>prefix</em>: Prefix-filtered join for similarity coefficients.
+ *
+ * The strings are mapped to sets of symbols, which are sorted by a
+ * global order of increasing frequency. For a threshold t, two sets can
+ * only be similar if they overlap in a minimum number of symbols, such
+ * that they need to share a symbol in their prefixes. The prefixes of the
+ * indexed sets are stored in an inverted index. A probed set only
+ * considers sets of compatible size (length filter) and drops candidates
+ * whose remaining symbols can not reach the overlap (positional filter).
+ * The remaining candidates are verified exactly.
+ *
+ * Bayardo, Ma, and Srikant. Scaling up all pairs similarity search.
+ * Proceedings of the 16th International Conference on World Wide Web,
+ * 131-140, 2007.
+ *
+ * Xiao, Wang, Lin, and Yu. Efficient similarity joins for near duplicate
+ * detection. Proceedings of the 17th International Conference on World
+ * Wide Web, 131-140, 2008.
+ * @{
+ */
+
+/* External variables */
+extern config_t cfg;
+
+/* Supported coefficients */
+typedef enum
+{
+    CO_JACCARD,
+    CO_DICE,
+    CO_OTSUKA,
+    CO_BRAUN,
+    CO_SIMPSON,
+    CO_KULCZYNSKI,
+    CO_SOKAL,
+} coef_id_t;
+
+static struct
+{
+    const char *name;
+    coef_id_t id;
+} names[] = {
+    {"sim_jaccard", CO_JACCARD},
+    {"sim_dice", CO_DICE},
+    {"sim_otsuka", CO_OTSUKA},
+    {"sim_braun", CO_BRAUN},
+    {"sim_simpson", CO_SIMPSON},
+    {"sim_kulczynski", CO_KULCZYNSKI},
+    {"sim_sokal", CO_SOKAL},
+    {NULL}
+};
+
+/**
+ * Entry of the inverted index
+ */
+typedef struct
+{
+    int id;                     /**< Index of string */
+    int pos;                    /**< Position of symbol in set */
+} posting_t;
+
+/* Local variables */
+static coef_id_t id = CO_JACCARD;
+static coef_t coef = NULL;
+static double t = 0;
+
+
+/**
+ * Configure the join. The coefficients need to use binary matching and a
+ * positive threshold.
+ * @param measure Name of similarity measure
+ * @return true on success, false otherwise
+ */
+int join_prefix_config(const char *measure)
+{
+    int i;
+
+    for (i = 0; names[i].name; i++)
+        if (!strcmp(names[i].name, measure))
+            break;
+
+    if (!names[i].name) {
+        error("Join 'prefix' is not supported for measure '%s'.", measure);
+        return FALSE;
+    }
+    if (!sim_coefficient_binary(measure_default())) {
+        error("Join 'prefix' requires binary matching of coefficients.");
+        return FALSE;
+    }
+
+    t = join_threshold();
+    if (t <= 0) {
+        error("Join 'prefix' requires a positive threshold.");
+        return FALSE;
+    }
+
+    id = names[i].id;
+    coef = sim_coefficient_get(measure);
+    return TRUE;
+}
+
+/**
+ * Return the overlap of two sets required to reach the threshold
+ * @param x Size of first set
+ * @param y Size of second set
+ * @return minimum overlap
+ */
+static int overlap(double x, double y)
+{
+    double o;
+
+    switch (id) {
+    case CO_JACCARD:
+        o = t / (1 + t) * (x + y);
+        break;
+    case CO_DICE:
+        o = t * (x + y) / 2;
+        break;
+    case CO_OTSUKA:
+        o = t * sqrt(x * y);
+        break;
+    case CO_BRAUN:
+        o = t * fmax(x, y);
+        break;
+    case CO_SIMPSON:
+        o = t * fmin(x, y);
+        break;
+    case CO_KULCZYNSKI:
+        o = 2 * t * x * y / (x + y);
+        break;
+    case CO_SOKAL:
+    default:
+        o = 2 * t * (x + y) / (1 + 3 * t);
+        break;
+    }
+
+    return MAX(1, (int) ceil(o * (1 - JOIN_TOLERANCE) - JOIN_TOLERANCE));
+}
+
+/**
+ * Return the minimum size of a set that can be similar to a set of
+ * size x. For the coefficients supported here, the required overlap
+ * increases with the size of the other set and this minimum size is
+ * also the minimum overlap of both sets.
+ * @param x Size of set
+ * @return minimum size
+ */
+static double lower(double x)
+{
+    switch (id) {
+    case CO_JACCARD:
+    case CO_BRAUN:
+        return t * x;
+    case CO_DICE:
+        return t * x / (2 - t);
+    case CO_OTSUKA:
+        return t * t * x;
+    case CO_SIMPSON:
+        return 0;
+    case CO_KULCZYNSKI:
+        return t > 0.5 ? (2 * t - 1) * x : 0;
+    case CO_SOKAL:
+    default:
+        return 2 * t * x / (1 + t);
+    }
+}
+
+/**
+ * Return the maximum size of a set that can be similar to a set of
+ * size x.
+ * @param x Size of set
+ * @return maximum size
+ */
+static double upper(double x)
+{
+    switch (id) {
+    case CO_JACCARD:
+    case CO_BRAUN:
+        return x / t;
+    case CO_DICE:
+        return x * (2 - t) / t;
+    case CO_OTSUKA:
+        return x / (t * t);
+    case CO_SIMPSON:
+        return INFINITY;
+    case CO_KULCZYNSKI:
+        return t > 0.5 ? x / (2 * t - 1) : INFINITY;
+    case CO_SOKAL:
+    default:
+        return x * (1 + t) / (2 * t);
+    }
+}
+
+/**
+ * Return the length of the prefix of a set
+ * @param x Size of set
+ * @return length of prefix
+ */
+static int prefix(int x)
+{
+    double l = lower(x) * (1 - JOIN_TOLERANCE) - JOIN_TOLERANCE;
+    int o = MAX(1, (int) ceil(l));
+    return MAX(0, x - o + 1);
+}
+
+/**
+ * Compare two symbols
+ * @param a First symbol
+ * @param b Second symbol
+ * @return order of symbols
+ */
+static int sym_cmp(const void *a, const void *b)
+{
+    sym_t x = *(const sym_t *) a, y = *(const sym_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+/* Frequencies for ordering of symbols */
+static int *freqs = NULL;
+
+/**
+ * Compare two symbols by frequency
+ * @param a Index of first symbol
+ * @param b Index of second symbol
+ * @return order of symbols
+ */
+static int freq_cmp(const void *a, const void *b)
+{
+    int x = *(const int *) a, y = *(const int *) b;
+
+    if (freqs[x] != freqs[y])
+        return freqs[x] - freqs[y];
+    return x - y;
+}
+
+/**
+ * Map the strings to sets of symbols sorted by increasing frequency.
+ * The symbols are replaced by their rank in this order.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param lo Index of first string
+ * @param n Number of strings
+ * @param lens Sizes of sets (output)
+ * @return sets of ranks (to be freed)
+ */
+static int **sets_create(hmatrix_t *m, hstring_t *s, int lo, int n,
+                         int *lens)
+{
+    sym_t **syms, *all;
+    int **sets, *order, *rank, i;
+    long total = 0, k, u;
+
+    syms = calloc(MAX(n, 1), sizeof(sym_t *));
+    sets = calloc(MAX(n, 1), sizeof(int *));
+    if (!syms || !sets)
+        fatal("Could not allocate memory for sets");
+
+    /* Distinct symbols of each string */
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:total)
+#endif
+    for (i = 0; i < n; i++) {
+        hstring_t x = s[lo + i];
+        int j, l = 0;
+
+        lens[i] = 0;
+        if (!join_used(m, lo + i))
+            continue;
+
+        syms[i] = malloc(MAX(x.len, 1) * sizeof(sym_t));
+        if (!syms[i])
+            fatal("Could not allocate memory for sets");
+
+        for (j = 0; j < x.len; j++)
+            syms[i][j] = hstring_get(x, j);
+        qsort(syms[i], x.len, sizeof(sym_t), sym_cmp);
+        for (j = 0; j < x.len; j++)
+            if (l == 0 || syms[i][l - 1] != syms[i][j])
+                syms[i][l++] = syms[i][j];
+
+        lens[i] = l;
+        total += l;
+    }
+
+    /* Global dictionary of symbols */
+    all = malloc(MAX(total, 1) * sizeof(sym_t));
+    if (!all)
+        fatal("Could not allocate memory for sets");
+    for (i = 0, k = 0; i < n; i++) {
+        memcpy(all + k, syms[i], lens[i] * sizeof(sym_t));
+        k += lens[i];
+    }
+    qsort(all, total, sizeof(sym_t), sym_cmp);
+
+    freqs = calloc(MAX(total, 1), sizeof(int));
+    order = malloc(MAX(total, 1) * sizeof(int));
+    rank = malloc(MAX(total, 1) * sizeof(int));
+    if (!freqs || !order || !rank)
+        fatal("Could not allocate memory for sets");
+
+    for (k = 0, u = 0; k < total; k++) {
+        if (k > 0 && all[k] == all[u - 1]) {
+            freqs[u - 1]++;
+            continue;
+        }
+        all[u] = all[k];
+        freqs[u++] = 1;
+    }
+
+    /* Rank of symbols by increasing frequency */
+    for (k = 0; k < u; k++)
+        order[k] = k;
+    qsort(order, u, sizeof(int), freq_cmp);
+    for (k = 0; k < u; k++)
+        rank[order[k]] = k;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (i = 0; i < n; i++) {
+        if (!syms[i])
+            continue;
+
+        sets[i] = malloc(MAX(lens[i], 1) * sizeof(int));
+        if (!sets[i])
+            fatal("Could not allocate memory for sets");
+
+        for (int j = 0; j < lens[i]; j++) {
+            sym_t *e = bsearch(syms[i] + j, all, u, sizeof(sym_t), sym_cmp);
+            sets[i][j] = rank[e - all];
+        }
+        qsort(sets[i], lens[i], sizeof(int), join_int_cmp);
+        free(syms[i]);
+    }
+
+    free(syms);
+    free(all);
+    free(freqs);
+    free(order);
+    free(rank);
+    freqs = NULL;
+
+    return sets;
+}
+
+/**
+ * Compute the overlap of two sorted sets. The computation stops early if
+ * the required overlap can not be reached anymore.
+ * @param x First set
+ * @param xl Size of first set
+ * @param y Second set
+ * @param yl Size of second set
+ * @param req Required overlap
+ * @return overlap or a smaller value if below the required overlap
+ */
+static int set_overlap(int *x, int xl, int *y, int yl, int req)
+{
+    int i = 0, j = 0, o = 0;
+
+    while (i < xl && j < yl) {
+        if (o + MIN(xl - i, yl - j) < req)
+            return o;
+        if (x[i] < y[j]) {
+            i++;
+        } else if (x[i] > y[j]) {
+            j++;
+        } else {
+            o++, i++, j++;
+        }
+    }
+
+    return o;
+}
+
+/**
+ * Run the prefix-filtered join. The prefixes of the column strings are
+ * indexed and the row strings are probed in parallel.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+void join_prefix_run(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+    int lo = MIN(m->col.start, m->row.start);
+    int n = MAX(m->col.end, m->row.end) - lo;
+    int cn = m->col.end - m->col.start;
+    int *lens, **sets, *heads, *empty, nempty = 0, maxrank = 0;
+    posting_t *posts;
+    long nposts = 0;
+
+    lens = calloc(MAX(n, 1), sizeof(int));
+    if (!lens)
+        fatal("Could not allocate memory for sets");
+    sets = sets_create(m, s, lo, n, lens);
+
+    /* Count postings of the prefixes of the column strings */
+    for (int c = m->col.start; c < m->col.end; c++) {
+        int *x = sets[c - lo], l = lens[c - lo];
+        for (int j = 0; j < prefix(l); j++)
+            maxrank = MAX(maxrank, x[j] + 1);
+    }
+
+    heads = calloc(maxrank + 1, sizeof(int));
+    empty = malloc(MAX(cn, 1) * sizeof(int));
+    if (!heads || !empty)
+        fatal("Could not allocate memory for inverted index");
+
+    for (int c = m->col.start; c < m->col.end; c++) {
+        int *x = sets[c - lo], l = lens[c - lo];
+        if (l == 0)
+            empty[nempty++] = c;
+        for (int j = 0; j < prefix(l); j++)
+            heads[x[j] + 1]++;
+    }
+    for (int k = 0; k < maxrank; k++)
+        heads[k + 1] += heads[k];
+
+    nposts = heads[maxrank];
+    posts = malloc(MAX(nposts, 1) * sizeof(posting_t));
+    if (!posts)
+        fatal("Could not allocate memory for inverted index");
+
+    /* Fill postings in order of strings */
+    for (int c = m->col.start; c < m->col.end; c++) {
+        int *x = sets[c - lo], l = lens[c - lo];
+        for (int j = 0; j < prefix(l); j++) {
+            posting_t *e = posts + heads[x[j]]++;
+            e->id = c;
+            e->pos = j;
+        }
+    }
+    for (int k = maxrank; k > 0; k--)
+        heads[k] = heads[k - 1];
+    heads[0] = 0;
+
+    info_msg(1, "Indexed %ld prefix symbols of %d strings.", nposts, cn);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        int *stamp = malloc(MAX(cn, 1) * sizeof(int));
+        int *acc = malloc(MAX(cn, 1) * sizeof(int));
+        int *cands = malloc(MAX(cn, 1) * sizeof(int));
+        if (!local || !stamp || !acc || !cands)
+            fatal("Could not allocate memory for join");
+
+        for (int i = 0; i < cn; i++)
+            stamp[i] = -1;
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+        for (int r = m->row.start; r < m->row.end; r++) {
+            int *y = sets[r - lo], yl = lens[r - lo], num = 0;
+            double ylo = lower(yl) * (1 - JOIN_TOLERANCE) - JOIN_TOLERANCE;
+            double yhi = upper(yl) * (1 + JOIN_TOLERANCE) + JOIN_TOLERANCE;
+
+            /* Empty sets are only similar to empty sets */
+            if (yl == 0) {
+                for (int j = 0; j < nempty; j++) {
+                    match_t e = { 0, 0, 0 };
+                    float v = coef(e);
+                    if (!join_pair(m, empty[j], r))
+                        continue;
+                    local->cands++;
+                    if (join_match(v))
+                        hpairs_add(local, empty[j], r, v);
+                }
+                continue;
+            }
+
+            for (int i = 0; i < prefix(yl); i++) {
+                if (y[i] >= maxrank)
+                    continue;
+
+                for (int k = heads[y[i]]; k < heads[y[i] + 1]; k++) {
+                    int c = posts[k].id, j = posts[k].pos;
+                    int ci = c - m->col.start, cl = lens[c - lo];
+
+                    /* Length filter */
+                    if (cl < ylo || cl > yhi || !join_pair(m, c, r))
+                        continue;
+
+                    if (stamp[ci] != r) {
+                        stamp[ci] = r;
+                        acc[ci] = 0;
+                        cands[num++] = ci;
+                    }
+                    if (acc[ci] < 0)
+                        continue;
+
+                    /* Positional filter */
+                    if (acc[ci] + 1 + MIN(yl - i - 1, cl - j - 1) >=
+                        overlap(cl, yl))
+                        acc[ci]++;
+                    else
+                        acc[ci] = -1;
+                }
+            }
+
+            /* Verify candidates */
+            for (int j = 0; j < num; j++) {
+                int c = cands[j] + m->col.start, cl = lens[c - lo], o;
+                match_t e;
+                float v;
+
+                if (acc[cands[j]] <= 0)
+                    continue;
+
+                local->cands++;
+                o = set_overlap(sets[c - lo], cl, y, yl, overlap(cl, yl));
+                if (o < overlap(cl, yl))
+                    continue;
+
+                e.a = o;
+                e.b = cl - o;
+                e.c = yl - o;
+                v = coef(e);
+                if (join_match(v))
+                    hpairs_add(local, c, r, v);
+            }
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+        free(stamp);
+        free(acc);
+        free(cands);
+    }
+
+    for (int i = 0; i < n; i++)
+        free(sets[i]);
+    free(sets);
+    free(lens);
+    free(posts);
+    free(heads);
+    free(empty);
+}
+
+/** @} */
@@ -0,0 +1,759 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "murmur.h"
+#include "measures.h"
+#include "join_tree.h"
+
+/**
+ * @addtogroup join
+ * <hr>
+ * <em>tree</em>: Metric trees for range and nearest-neighbor queries.
+ *
+ * The strings of the row range are indexed in a metric tree and the
+ * strings of the column range are used as queries. Each node of the tree
+ * holds one string as pivot and the remaining strings of its subtree are
+ * split by their distance to the pivot. For real-valued distances, the
+ * strings are split at the median distance (vantage-point tree). For
+ * integer distances, each distance to the pivot forms one child
+ * (BK-tree). Every child stores the minimum and maximum distance of its
+ * strings to the pivot, such that a child can be skipped if the triangle
+ * inequality rules out strings within the query radius. For nearest
+ * neighbors, the radius shrinks to the distance of the k-th neighbor
+ * found so far.
+ *
+ * The tree is built in parallel and can be stored in a file, such that
+ * subsequent runs with the same strings and configuration skip the
+ * construction. The method requires a metric, since otherwise pairs may
+ * be missed.
+ *
+ * Burkhard and Keller. Some approaches to best-match file searching.
+ * Communications of the ACM, 16(4):230-236, 1973.
+ *
+ * Yianilos. Data structures and algorithms for nearest neighbor search in
+ * general metric spaces. Proceedings of the ACM-SIAM Symposium on Discrete
+ * Algorithms (SODA), 311-321, 1993.
+ * @{
+ */
+
+/* External variables */
+extern config_t cfg;
+
+/* Magic of tree files */
+#define TREE_MAGIC      0x31455254
+/* Minimum number of strings to build a subtree in a separate task */
+#define TASK_MIN        256
+/* Maximum number of strings of a subtree compared without pruning */
+#define BUCKET          16
+
+/**
+ * Types of trees
+ */
+enum
+{
+    TREE_VP,                    /**< Vantage-point tree */
+    TREE_BK                     /**< Burkhard-Keller tree */
+};
+
+/**
+ * Node of the tree
+ */
+typedef struct
+{
+    int id;                     /**< Pivot relative to row range */
+    int edge;                   /**< First edge to children */
+    int num;                    /**< Number of children */
+    int size;                   /**< Number of strings in subtree */
+} node_t;
+
+/**
+ * Edge from a node to a child
+ */
+typedef struct
+{
+    float lo;                   /**< Minimum distance to pivot */
+    float hi;                   /**< Maximum distance to pivot */
+    int node;                   /**< Child node */
+} edge_t;
+
+/**
+ * String with distance to a pivot during construction
+ */
+typedef struct
+{
+    float d;                    /**< Distance to pivot */
+    int id;                     /**< String relative to row range */
+} item_t;
+
+/**
+ * Query pending at a node
+ */
+typedef struct
+{
+    int q;                      /**< Query in batch */
+    float lb;                   /**< Lower bound of distances */
+} visit_t;
+
+/**
+ * Node pending in a traversal with its queries
+ */
+typedef struct
+{
+    int node;                   /**< Node */
+    long off;                   /**< First query in buffer */
+    int num;                    /**< Number of queries */
+} frame_t;
+
+/**
+ * Batch of queries traversing the tree together
+ */
+typedef struct
+{
+    int c[HMATRIX_TILE];        /**< Column strings */
+    double r[HMATRIX_TILE];     /**< Radius of queries */
+    join_knn_t *knn[HMATRIX_TILE];      /**< Neighbors or NULL */
+    int num;                    /**< Number of queries */
+    visit_t *buf;               /**< Buffer of pending queries */
+    long size;                  /**< Size of buffer */
+    frame_t *stack;             /**< Stack of pending nodes */
+    int depth;                  /**< Depth of stack */
+    int room;                   /**< Size of stack */
+} batch_t;
+
+/* Local variables */
+static const char *metric = NULL;
+static const char *file = "";
+static int type = TREE_VP;
+
+/* Tree of row strings */
+static node_t *nodes = NULL;
+static edge_t *edges = NULL;
+
+/**
+ * Configure the join. Only distances that satisfy the triangle
+ * inequality are supported.
+ * @param measure Name of similarity measure
+ * @return true on success, false otherwise
+ */
+int join_tree_config(const char *measure)
+{
+    const char *str;
+    int integer;
+
+    if (!join_metric("tree", measure, &integer))
+        return FALSE;
+
+    if (!join_neighbors() && join_threshold() < 0) {
+        error("Join 'tree' requires a non-negative threshold.");
+        return FALSE;
+    }
+
+    config_lookup_string(&cfg, "measures.join.tree.type", &str);
+    if (!strcasecmp(str, "vp")) {
+        type = TREE_VP;
+    } else if (!strcasecmp(str, "bk")) {
+        type = TREE_BK;
+    } else if (!strcasecmp(str, "auto")) {
+        type = integer ? TREE_BK : TREE_VP;
+    } else {
+        error("Unknown type of tree '%s'.", str);
+        return FALSE;
+    }
+
+    config_lookup_string(&cfg, "measures.join.tree.file", &file);
+    metric = measure;
+    return TRUE;
+}
+
+/**
+ * Add a scalar setting to a digest. Groups and lists are ignored.
+ * @param h Digest
+ * @param e Configuration setting or NULL
+ * @return updated digest
+ */
+static uint64_t hash_setting(uint64_t h, config_setting_t *e)
+{
+    char buf[512];
+
+    if (!e)
+        return h;
+
+    switch (config_setting_type(e)) {
+    case CONFIG_TYPE_INT:
+        snprintf(buf, sizeof(buf), "%s=%d", config_setting_name(e),
+                 (int) config_setting_get_int(e));
+        break;
+    case CONFIG_TYPE_FLOAT:
+        snprintf(buf, sizeof(buf), "%s=%g", config_setting_name(e),
+                 config_setting_get_float(e));
+        break;
+    case CONFIG_TYPE_BOOL:
+        snprintf(buf, sizeof(buf), "%s=%d", config_setting_name(e),
+                 config_setting_get_bool(e));
+        break;
+    case CONFIG_TYPE_STRING:
+        snprintf(buf, sizeof(buf), "%s=%s", config_setting_name(e),
+                 config_setting_get_string(e));
+        break;
+    default:
+        return h;
+    }
+
+    return join_mix(h ^ MurmurHash64B(buf, strlen(buf), 0x7ee));
+}
+
+/**
+ * Add the scalar settings of a group of measures to a digest
+ * @param h Digest
+ * @param name Name of measure
+ * @return updated digest
+ */
+static uint64_t hash_group(uint64_t h, const char *name)
+{
+    config_setting_t *g;
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), "measures.%s", name);
+    h = join_mix(h ^ MurmurHash64B(buf, strlen(buf), 0x7ee));
+
+    g = config_lookup(&cfg, buf);
+    for (int i = 0; g && i < config_setting_length(g); i++)
+        h = hash_setting(h, config_setting_get_elem(g, i));
+
+    return h;
+}
+
+/**
+ * Compute a digest of the row strings and the configuration of the
+ * measure. The configuration comprises the group of the measure, the
+ * group of the kernel used by dist_kernel and the global settings of the
+ * strings. A stored tree is only used if the digest matches.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @return digest
+ */
+static uint64_t digest(hmatrix_t *m, hstring_t *s)
+{
+    const char *str, *globals[] = {
+        "measures.granularity", "measures.token_delim", NULL
+    };
+    char buf[256];
+    uint64_t h = type;
+
+    for (int i = 0; globals[i]; i++)
+        h = hash_setting(h, config_lookup(&cfg, globals[i]));
+
+    h = hash_group(h, metric);
+    if (!strcmp(metric, "dist_kernel")) {
+        /* Kernels may be given without prefix, e.g. "wdegree" */
+        config_lookup_string(&cfg, "measures.dist_kernel.kern", &str);
+        snprintf(buf, sizeof(buf), "measures.%s", str);
+        if (config_lookup(&cfg, buf)) {
+            h = hash_group(h, str);
+        } else {
+            snprintf(buf, sizeof(buf), "kern_%s", str);
+            h = hash_group(h, buf);
+        }
+    }
+
+    for (int r = m->row.start; r < m->row.end; r++) {
+        h = join_mix(h ^ ((uint64_t) s[r].type << 32 | s[r].len));
+        if (s[r].len > 0)
+            h = join_mix(h ^ hstring_hash1(s[r]));
+    }
+
+    return h;
+}
+
+/**
+ * Load the tree from a file. The file needs to match the number of
+ * strings and the digest.
+ * @param n Number of strings
+ * @param dg Digest of strings and configuration
+ * @return true on success, false otherwise
+ */
+static int tree_load(int n, uint64_t dg)
+{
+    uint32_t hdr[4];
+    uint64_t d;
+    int ret = FALSE;
+    FILE *f;
+
+    f = fopen(file, "r");
+    if (!f)
+        return FALSE;
+
+    if (fread(hdr, sizeof(hdr), 1, f) != 1 || fread(&d, sizeof(d), 1, f) != 1
+        || hdr[0] != TREE_MAGIC || hdr[1] != (uint32_t) n ||
+        hdr[2] != (uint32_t) type || d != dg) {
+        warning("Tree in '%s' does not match. Rebuilding.", file);
+    } else if (fread(nodes, sizeof(node_t), n, f) != (size_t) n ||
+               fread(edges, sizeof(edge_t), n - 1, f) != (size_t) n - 1) {
+        warning("Could not read tree from '%s'.", file);
+    } else {
+        ret = TRUE;
+    }
+
+    fclose(f);
+    return ret;
+}
+
+/**
+ * Save the tree to a file. The file has the form
+ * <pre>
+ * | magic (uint32) | num (uint32) | type (uint32) | 0 (uint32) |
+ * | digest (uint64) | nodes (num) ... | edges (num - 1) ... |
+ * </pre>
+ * @param n Number of strings
+ * @param dg Digest of strings and configuration
+ */
+static void tree_save(int n, uint64_t dg)
+{
+    uint32_t hdr[4] = { TREE_MAGIC, n, type, 0 };
+    FILE *f;
+
+    f = fopen(file, "w");
+    if (!f) {
+        error("Could not open tree file '%s'.", file);
+        return;
+    }
+
+    if (fwrite(hdr, sizeof(hdr), 1, f) != 1 ||
+        fwrite(&dg, sizeof(dg), 1, f) != 1 ||
+        fwrite(nodes, sizeof(node_t), n, f) != (size_t) n ||
+        fwrite(edges, sizeof(edge_t), n - 1, f) != (size_t) n - 1)
+        error("Could not write tree to '%s'.", file);
+
+    fclose(f);
+}
+
+/**
+ * Compare two items by distance and index
+ * @param a First item
+ * @param b Second item
+ * @return order of items
+ */
+static int item_cmp(const void *a, const void *b)
+{
+    const item_t *x = a, *y = b;
+
+    if (x->d != y->d)
+        return x->d < y->d ? -1 : 1;
+    return x->id - y->id;
+}
+
+/**
+ * Compute the distances of a tile of strings to a pivot
+ * @param p Pivot
+ * @param s Array of row strings
+ * @param items Strings of tile
+ * @param num Number of strings (at most one tile)
+ */
+static void tile(hstring_t p, hstring_t *s, item_t *items, int num)
+{
+    hstring_t ys[HMATRIX_TILE];
+    float out[HMATRIX_TILE];
+
+    for (int i = 0; i < num; i++)
+        ys[i] = s[items[i].id];
+    measure_compare_batch(p, ys, num, out);
+    for (int i = 0; i < num; i++)
+        items[i].d = out[i];
+}
+
+/**
+ * Compute the distances of strings to a pivot. Large sets of strings are
+ * split into tasks.
+ * @param p Pivot
+ * @param s Array of row strings
+ * @param items Strings
+ * @param n Number of strings
+ */
+static void distances(hstring_t p, hstring_t *s, item_t *items, int n)
+{
+    if (n <= 16 * HMATRIX_TILE) {
+        for (int t = 0; t < n; t += HMATRIX_TILE)
+            tile(p, s, items + t, MIN(HMATRIX_TILE, n - t));
+        return;
+    }
+
+#ifdef HAVE_OPENMP
+#pragma omp taskloop
+#endif
+    for (int t = 0; t < n; t += HMATRIX_TILE)
+        tile(p, s, items + t, MIN(HMATRIX_TILE, n - t));
+}
+
+/**
+ * Build a subtree. The subtree of n strings occupies the nodes from nb
+ * on and the edges from eb on. The children of a node are laid out in
+ * the order of their distances, such that the nodes and edges of each
+ * subtree can be determined without synchronization. The largest child
+ * is built in a loop to bound the depth of the recursion. The nodes of
+ * small subtrees are stored without children.
+ * @param s Array of row strings
+ * @param items Strings of subtree
+ * @param n Number of strings
+ * @param nb First node
+ * @param eb First edge
+ */
+static void build(hstring_t *s, item_t *items, int n, int nb, int eb)
+{
+    while (n > 0) {
+        node_t *node = nodes + nb;
+        int a, b, c, j, big = -1, bn = 0, bb = 0, be = 0;
+        item_t t;
+
+        /* Pivot chosen pseudo-randomly */
+        j = join_mix(nb + 1) % n;
+        t = items[0], items[0] = items[j], items[j] = t;
+
+        node->id = items[0].id;
+        node->edge = eb;
+        node->num = 0;
+        node->size = n;
+
+        /* Small subtrees are compared as bucket */
+        if (n <= BUCKET) {
+            for (j = 1; j < n; j++)
+                nodes[nb + j] = (node_t) { items[j].id, eb, 0, 1 };
+            return;
+        }
+
+        distances(s[items[0].id], s, items + 1, n - 1);
+        qsort(items + 1, n - 1, sizeof(item_t), item_cmp);
+
+        /* Count children: median split or one child per distance */
+        if (type == TREE_VP) {
+            c = n > 2 ? 2 : 1;
+        } else {
+            for (c = 1, a = 2; a < n; a++)
+                c += items[a].d != items[a - 1].d;
+        }
+        node->num = c;
+
+        for (j = 0, a = 1; j < c; j++, a = b) {
+            edge_t *e = edges + eb + j;
+
+            if (type == TREE_VP)
+                b = j == 0 && c == 2 ? 1 + (n - 1) / 2 : n;
+            else
+                for (b = a + 1; b < n && items[b].d == items[a].d; b++);
+
+            /* Layout of subtree: nodes nb + a and edges after children */
+            e->lo = items[a].d;
+            e->hi = items[b - 1].d;
+            e->node = nb + a;
+
+            if (b - a > bn) {
+                if (big >= 0) {
+#ifdef HAVE_OPENMP
+#pragma omp task if(bn > TASK_MIN)
+#endif
+                    build(s, items + big, bn, bb, be);
+                }
+                big = a, bn = b - a, bb = nb + a, be = eb + c + a - 1 - j;
+                continue;
+            }
+
+#ifdef HAVE_OPENMP
+#pragma omp task if(b - a > TASK_MIN)
+#endif
+            build(s, items + a, b - a, nb + a, eb + c + a - 1 - j);
+        }
+
+        items += big, n = bn, nb = bb, eb = be;
+    }
+}
+
+/**
+ * Check whether a lower bound exceeds the query radius
+ * @param lb Lower bound
+ * @param r Radius
+ * @return true if exceeded, false otherwise
+ */
+static int exceeds(double lb, double r)
+{
+    return lb > r + JOIN_TOLERANCE * (1 + r);
+}
+
+/**
+ * Report a pair of a query and a row string
+ * @param m Matrix object
+ * @param b Batch of queries
+ * @param q Query in batch
+ * @param y Index of row string
+ * @param d Distance
+ * @param p List of pairs
+ */
+static void report(hmatrix_t *m, batch_t *b, int q, int y, float d,
+                   hpairs_t *p)
+{
+    if (!join_pair(m, b->c[q], y))
+        return;
+
+    if (b->knn[q]) {
+        join_knn_add(b->knn[q], b->c[q], y, d);
+        b->r[q] = join_knn_bound(b->knn[q]);
+    } else if (join_match(d)) {
+        hpairs_add(p, b->c[q], y, d);
+    }
+}
+
+/**
+ * Push a node with its queries on the stack of a batch
+ * @param b Batch of queries
+ * @param node Node
+ * @param off First query in buffer
+ * @param num Number of queries
+ */
+static void push(batch_t *b, int node, long off, int num)
+{
+    if (num == 0)
+        return;
+
+    if (b->depth == b->room) {
+        b->room = MAX(2 * b->room, 64);
+        b->stack = realloc(b->stack, b->room * sizeof(frame_t));
+        if (!b->stack)
+            fatal("Could not allocate stack of tree");
+    }
+    b->stack[b->depth++] = (frame_t) { node, off, num };
+}
+
+/**
+ * Make room for queries in the buffer of a batch
+ * @param b Batch of queries
+ * @param len Required length of buffer
+ */
+static void reserve(batch_t *b, long len)
+{
+    if (len <= b->size)
+        return;
+
+    b->size = MAX(2 * b->size, len);
+    b->buf = realloc(b->buf, b->size * sizeof(visit_t));
+    if (!b->buf)
+        fatal("Could not allocate queries of tree");
+}
+
+/**
+ * Compare the queries at a node with the strings of a bucket
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param b Batch of queries
+ * @param node Node of bucket
+ * @param qs Queries
+ * @param num Number of queries
+ * @param p List of pairs
+ */
+static void bucket(hmatrix_t *m, hstring_t *s, batch_t *b, node_t *node,
+                   visit_t *qs, int num, hpairs_t *p)
+{
+    hstring_t ys[BUCKET];
+    float out[BUCKET];
+
+    for (int i = 0; i < node->size; i++)
+        ys[i] = s[node[i].id + m->row.start];
+
+    for (int j = 0; j < num; j++) {
+        int q = qs[j].q;
+        measure_compare_batch(s[b->c[q]], ys, node->size, out);
+        p->cands += node->size;
+        for (int i = 0; i < node->size; i++)
+            report(m, b, q, node[i].id + m->row.start, out[i], p);
+    }
+}
+
+/**
+ * Traverse the tree with a batch of queries. Each node is visited with
+ * the queries that are not ruled out by the triangle inequality, such
+ * that the distances of the pivot to all queries are computed at once.
+ * In a greedy traversal, each query only descends into the child with
+ * the smallest lower bound. This quickly finds close neighbors and
+ * shrinks the radius for the full traversal.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param b Batch of queries
+ * @param greedy Flag for greedy traversal
+ * @param p List of pairs
+ */
+static void traverse(hmatrix_t *m, hstring_t *s, batch_t *b, int greedy,
+                     hpairs_t *p)
+{
+    hstring_t ys[HMATRIX_TILE];
+    float out[HMATRIX_TILE];
+    int best[HMATRIX_TILE];
+
+    reserve(b, b->num);
+    for (int q = 0; q < b->num; q++)
+        b->buf[q] = (visit_t) { q, 0 };
+    b->depth = 0;
+    push(b, 0, 0, b->num);
+
+    while (b->depth > 0) {
+        frame_t f = b->stack[--b->depth];
+        node_t *node = nodes + f.node;
+        visit_t *qs = b->buf + f.off;
+        long top = f.off;
+        int num = 0, y = node->id + m->row.start;
+
+        /* Drop queries whose radius has shrunk */
+        for (int j = 0; j < f.num; j++)
+            if (!exceeds(qs[j].lb, b->r[qs[j].q]))
+                qs[num++] = qs[j];
+        if (num == 0)
+            continue;
+
+        if (node->num == 0) {
+            bucket(m, s, b, node, qs, num, p);
+            continue;
+        }
+
+        for (int j = 0; j < num; j++)
+            ys[j] = s[b->c[qs[j].q]];
+        measure_compare_batch(s[y], ys, num, out);
+        p->cands += num;
+        for (int j = 0; j < num; j++)
+            report(m, b, qs[j].q, y, out[j], p);
+
+        /* Triangle inequality: |d(x, p) - d(y, p)| <= d(x, y) */
+        top += num;
+        reserve(b, top + (long) num * node->num);
+        qs = b->buf + f.off;
+        for (int j = 0; greedy && j < num; j++) {
+            float lb, min = INFINITY;
+            for (int i = 0; i < node->num; i++) {
+                edge_t *e = edges + node->edge + i;
+                lb = fmax(e->lo - out[j], out[j] - e->hi);
+                if (lb < min)
+                    min = lb, best[j] = i;
+            }
+        }
+
+        for (int i = node->num - 1; i >= 0; i--) {
+            edge_t *e = edges + node->edge + i;
+            long off = top;
+
+            for (int j = 0; j < num; j++) {
+                float lb = fmax(fmax(e->lo - out[j], out[j] - e->hi), 0);
+                if (greedy ? best[j] == i : !exceeds(lb, b->r[qs[j].q]))
+                    b->buf[top++] = (visit_t) { qs[j].q, lb };
+            }
+            push(b, e->node, off, top - off);
+        }
+    }
+}
+
+/**
+ * Run the tree join. The strings of the row range are indexed and the
+ * strings of the column range are queried in parallel batches.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param p List of pairs
+ */
+void join_tree_run(hmatrix_t *m, hstring_t *s, hpairs_t *p)
+{
+    int n = m->row.end - m->row.start;
+    int save = strlen(file) > 0;
+    uint64_t dg = 0;
+    item_t *items;
+
+    if (n <= 0 || m->col.end <= m->col.start)
+        return;
+
+    nodes = malloc(n * sizeof(node_t));
+    edges = malloc(MAX(n - 1, 1) * sizeof(edge_t));
+    if (!nodes || !edges)
+        fatal("Could not allocate memory for tree");
+
+    if (save)
+        dg = digest(m, s);
+
+    if (save && tree_load(n, dg)) {
+        info_msg(1, "Loaded tree of %d strings from '%s'.", n, file);
+    } else {
+        items = malloc(n * sizeof(item_t));
+        if (!items)
+            fatal("Could not allocate memory for tree");
+        for (int i = 0; i < n; i++)
+            items[i].id = i;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#pragma omp single
+#endif
+        build(s + m->row.start, items, n, 0, 0);
+        free(items);
+
+        info_msg(1, "Built %s-tree of %d strings.",
+                 type == TREE_VP ? "VP" : "BK", n);
+        if (save) {
+            tree_save(n, dg);
+            info_msg(1, "Saved tree of %d strings to '%s'.", n, file);
+        }
+    }
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        hpairs_t *local = hpairs_init();
+        batch_t *b = calloc(1, sizeof(batch_t));
+        if (!local || !b)
+            fatal("Could not allocate list of pairs");
+
+        for (int q = 0; join_neighbors() && q < HMATRIX_TILE; q++) {
+            b->knn[q] = join_knn_init();
+            if (!b->knn[q])
+                fatal("Could not allocate list of neighbors");
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for (int c = m->col.start; c < m->col.end; c += HMATRIX_TILE) {
+            b->num = MIN(HMATRIX_TILE, m->col.end - c);
+            for (int q = 0; q < b->num; q++) {
+                b->c[q] = c + q;
+                b->r[q] = b->knn[q] ? join_knn_bound(b->knn[q]) :
+                    join_threshold();
+            }
+
+            if (b->knn[0])
+                traverse(m, s, b, TRUE, local);
+            traverse(m, s, b, FALSE, local);
+            for (int q = 0; b->knn[0] && q < b->num; q++)
+                join_knn_flush(b->knn[q], local);
+        }
+
+#ifdef HAVE_OPENMP
+#pragma omp critical
+#endif
+        hpairs_merge(p, local);
+        hpairs_destroy(local);
+        for (int q = 0; q < HMATRIX_TILE; q++)
+            join_knn_destroy(b->knn[q]);
+        free(b->buf);
+        free(b->stack);
+        free(b);
+    }
+
+    free(nodes);
+    free(edges);
+    nodes = NULL;
+    edges = NULL;
+}
+
+/** @} */
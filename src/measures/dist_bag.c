@@ -15,6 +15,17 @@
 #include "uthash.h"
 #include "norm.h"
 #include "dist_bag.h"
+#include "scratch.h"
+
+/* Hash tables are allocated from scratch memory */
+#undef uthash_tbl_malloc
+#undef uthash_tbl_free
+#undef uthash_bkt_malloc
+#undef uthash_bkt_free
+#define uthash_tbl_malloc(sz)   scratch_alloc(sz)
+#define uthash_tbl_free(ptr)
+#define uthash_bkt_malloc(sz)   scratch_alloc(sz)
+#define uthash_bkt_free(ptr)
 
 /**
  * @addtogroup measures
@@ -36,22 +47,32 @@ typedef struct
     UT_hash_handle hh;  /**< uthash handle */
 } bag_t;
 
-/* Static variables */
-static lnorm_t n = LN_NONE;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    lnorm_t n;                  /**< Normalization */
+} param_t;
 
-/* External variables */
-extern config_t cfg;
+/* Default parameters */
+static const param_t defaults = { LN_NONE };
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void dist_bag_config()
+void dist_bag_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.dist_bag.norm", &str);
-    n = lnorm_get(str);
+    config_lookup_string(m->cfg, "measures.dist_bag.norm", &str);
+    p->n = lnorm_get(str);
+
+    /* Signatures of symbols */
+    hstring_sig_config_r(m->prep, 1);
 }
 
 /**
@@ -68,7 +89,7 @@ static bag_t *bag_create(hstring_t x)
         HASH_FIND(hh, xh, &s, sizeof(sym_t), bag);
 
         if (!bag) {
-            bag = malloc(sizeof(bag_t));
+            bag = scratch_alloc(sizeof(bag_t));
             bag->sym = s;
             bag->cnt = 0;
             HASH_ADD(hh, xh, sym, sizeof(sym_t), bag);
@@ -80,33 +101,19 @@ static bag_t *bag_create(hstring_t x)
     return xh;
 }
 
-/** 
- * Free the memory of histogram
- * @param xh Histogram
- */
-static void bag_destroy(bag_t * xh)
-{
-    /* Clear hash table */
-    while (xh) {
-        bag_t *bag = xh;
-        HASH_DEL(xh, bag);
-        free(bag);
-    }
-}
-
 /**
- * Computes the bag distance of two strings. The distance approximates
- * and lower bounds the Levenshtein distance.
- * @param x first string 
+ * Computes the bag distance using the histogram of the first string.
+ * @param p Parameters of measure
+ * @param xh Histogram of first string
+ * @param x first string
  * @param y second string
  * @return Bag distance
  */
-float dist_bag_compare(hstring_t x, hstring_t y)
+static float bag_distance(param_t *p, bag_t * xh, hstring_t x, hstring_t y)
 {
     float xd = 0, yd = 0;
-    bag_t *xh, *yh, *xb, *yb;
+    bag_t *yh, *xb, *yb;
 
-    xh = bag_create(x);
     yh = bag_create(y);
 
     int missing = y.len;
@@ -123,10 +130,53 @@ float dist_bag_compare(hstring_t x, hstring_t y)
     }
     yd += missing;
 
-    bag_destroy(xh);
-    bag_destroy(yh);
+    return lnorm(p->n, fmax(xd, yd), x, y);
+}
 
-    return lnorm(n, fmax(xd, yd), x, y);
+/**
+ * Computes the bag distance of two strings. The distance approximates
+ * and lower bounds the Levenshtein distance.
+ * @param m Instance of measure
+ * @param x first string 
+ * @param y second string
+ * @return Bag distance
+ */
+float dist_bag_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    param_t *p = m->param;
+
+    /* Strings without common symbols differ in all symbols */
+    if (hstring_sig_disjoint(x, y, 1))
+        return lnorm(p->n, fmax(x.len, y.len), x, y);
+
+    return bag_distance(p, bag_create(x), x, y);
+}
+
+/**
+ * Computes the bag distance between one string and several strings. The
+ * histogram of the first string is created only once.
+ * @param m Instance of measure
+ * @param x first string
+ * @param ys array of second strings
+ * @param num number of second strings
+ * @param out array of distances
+ */
+void dist_bag_compare_batch(hmeasure_t *m, hstring_t x, hstring_t *ys,
+                            int num, float *out)
+{
+    param_t *p = m->param;
+    bag_t *xh = bag_create(x);
+
+    for (int i = 0; i < num; i++) {
+        if (hstring_sig_disjoint(x, ys[i], 1)) {
+            out[i] = lnorm(p->n, fmax(x.len, ys[i].len), x, ys[i]);
+            continue;
+        }
+
+        scratch_mark_t mark = scratch_mark();
+        out[i] = bag_distance(p, xh, x, ys[i]);
+        scratch_release(mark);
+    }
 }
 
 /** @} */
@@ -13,9 +13,12 @@
 #define DIST_BAG_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void dist_bag_config();
-float dist_bag_compare(hstring_t, hstring_t);
+void dist_bag_config(hmeasure_t *);
+float dist_bag_compare(hmeasure_t *, hstring_t, hstring_t);
+void dist_bag_compare_batch(hmeasure_t *, hstring_t, hstring_t *, int,
+                            float *);
 
 #endif /* DIST_BAG_H */
@@ -13,9 +13,20 @@
 #include "harry.h"
 #include "util.h"
 #include "vcache.h"
+#include "scratch.h"
 
 #include "dist_compression.h"
 
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_BZIP2
+#include <bzlib.h>
+#endif
+
 /**
  * @addtogroup measures
  * <hr>
@@ -23,117 +34,702 @@
  *
  * Cilibrasi and Vitanyi. Clustering by compression, IEEE Transactions on
  * Information Theory, 51:4, 1523-1545, 2005.
+ *
+ * The compressor is selected using the parameter "compressor". Besides
+ * zlib, the compressors zstd, lz4 and bzip2 are supported if available.
  * @{
  */
 
-/* External variables */
-extern config_t cfg;
-static cfg_int level = 0;
+/**
+ * Backend for compressing strings
+ */
+typedef struct
+{
+    const char *name;           /**< Name of compressor */
+    float (*str1) (cfg_int, hstring_t); /**< Compress one string */
+    float (*cat) (cfg_int, hstring_t, hstring_t, float, int);   /**< Concat */
+} backend_t;
 
 /**
- * Initializes the similarity measure
+ * Parameters of the measure
  */
-void dist_compression_config()
+typedef struct
 {
-    /* Configuration */
-    config_lookup_int(&cfg, "measures.dist_compression.level", &level);
+    cfg_int level;              /**< Compression level */
+    const backend_t *backend;   /**< Selected backend */
+} param_t;
+
+/* Size of sink buffer for compressed output */
+#define SINK_SIZE       4096
+/* Size of pool for copies of the primed stream */
+#define POOL_SIZE       (512 * 1024)
+/* Minimum length of prefix for priming a stream */
+#define PRIME_MIN       4096
+/* Number of cached memory blocks for bzip2 */
+#define BLOCK_CACHE     8
+
+/**
+ * Memory block kept for reuse
+ */
+typedef struct
+{
+    void *ptr;                  /**< Memory or NULL */
+    size_t size;                /**< Size of memory */
+    int busy;                   /**< Flag for memory in use */
+} block_t;
+
+/**
+ * Compression engine of a thread. The deflate streams are reused for all
+ * comparisons. A second stream is kept primed with the last prefix, such
+ * that only the suffix needs to be compressed for further strings. The
+ * contexts of the other compressors are also created once per thread.
+ */
+typedef struct
+{
+    z_stream zs;                /**< Stream for single strings */
+    z_stream primed;            /**< Stream primed with prefix */
+    uint64_t prefix;            /**< Hash of prefix or 0 */
+    cfg_int level;              /**< Level of streams */
+    int ready;                  /**< Flag for initialized streams */
+    char *pool;                 /**< Pool for copies of primed stream */
+    size_t used;                /**< Used bytes of pool */
+    int pooled;                 /**< Flag for allocations from pool */
+    Bytef sink[SINK_SIZE];      /**< Sink for compressed output */
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx *zstd;            /**< Context of zstd */
+#endif
+#ifdef HAVE_LZ4
+    LZ4_stream_t *lz4;          /**< Stream of lz4 */
+#endif
+#ifdef HAVE_BZIP2
+    block_t blocks[BLOCK_CACHE];        /**< Memory of bzip2 streams */
+#endif
+} engine_t;
+
+/* Engine of the current thread */
+static engine_t engine;
+#ifdef HAVE_OPENMP
+#pragma omp threadprivate(engine)
+#endif
+
+/**
+ * Return the number of bytes of a string
+ * @param x String
+ * @return number of bytes
+ */
+static size_t str_bytes(hstring_t x)
+{
+    switch (x.type) {
+    case TYPE_TOKEN:
+        return x.len * sizeof(sym_t);
+    case TYPE_BIT:
+        return (x.len + 7) / 8;
+    default:
+        return x.len;
+    }
+}
+
+/**
+ * Allocate memory for a deflate stream. Copies of the primed stream are
+ * placed in the pool of the engine, all other memory is allocated from
+ * the heap.
+ * @param opaque Engine
+ * @param items Number of items
+ * @param size Size of items
+ * @return memory or NULL on error
+ */
+static voidpf engine_alloc(voidpf opaque, uInt items, uInt size)
+{
+    engine_t *e = opaque;
+    size_t len = (size_t) items * size;
+    voidpf p;
+
+    if (!e->pooled || e->used + len > POOL_SIZE)
+        return calloc(items, size);
+
+    p = e->pool + e->used;
+    e->used += (len + 15) & ~((size_t) 15);
+    return p;
+}
+
+/**
+ * Free memory of a deflate stream
+ * @param opaque Engine
+ * @param p Memory
+ */
+static void engine_free(voidpf opaque, voidpf p)
+{
+    engine_t *e = opaque;
+
+    if ((char *) p < e->pool || (char *) p >= e->pool + POOL_SIZE)
+        free(p);
+}
+
+/**
+ * Initialize a deflate stream of the engine
+ * @param zs Stream
+ * @param level Compression level
+ * @return true on success, false otherwise
+ */
+static int engine_stream(z_stream *zs, cfg_int level)
+{
+    memset(zs, 0, sizeof(z_stream));
+    zs->zalloc = engine_alloc;
+    zs->zfree = engine_free;
+    zs->opaque = &engine;
+
+    /* Same parameters as compress2() */
+    if (deflateInit(zs, level) != Z_OK) {
+        error("Could not initialize deflate stream");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Prepare the engine of the current thread. The streams are created once
+ * and only re-initialized if the compression level changes.
+ * @param level Compression level
+ * @return true on success, false otherwise
+ */
+static int engine_init(cfg_int level)
+{
+    if (engine.ready && engine.level == level)
+        return TRUE;
+
+    if (engine.ready) {
+        deflateEnd(&engine.zs);
+        deflateEnd(&engine.primed);
+    }
+
+    engine.ready = FALSE;
+    engine.prefix = 0;
+    engine.level = level;
+
+    if (!engine.pool && !(engine.pool = malloc(POOL_SIZE))) {
+        error("Could not allocate memory for compression");
+        return FALSE;
+    }
+
+    if (!engine_stream(&engine.zs, level))
+        return FALSE;
+    if (!engine_stream(&engine.primed, level)) {
+        deflateEnd(&engine.zs);
+        return FALSE;
+    }
+
+    engine.ready = TRUE;
+    return TRUE;
+}
+
+/**
+ * Feed data to a deflate stream. The compressed output is written to the
+ * sink buffer and only counted.
+ * @param zs Stream
+ * @param x String
+ * @param flush Flush mode of deflate
+ * @return true on success, false otherwise
+ */
+static int engine_feed(z_stream *zs, hstring_t x, int flush)
+{
+    int r;
+
+    zs->next_in = (void *) x.str.c;
+    zs->avail_in = str_bytes(x);
+
+    do {
+        zs->next_out = engine.sink;
+        zs->avail_out = SINK_SIZE;
+        r = deflate(zs, flush);
+        if (r == Z_STREAM_ERROR) {
+            error("Compression failed: %s", zs->msg ? zs->msg : "unknown");
+            return FALSE;
+        }
+    } while (zs->avail_in > 0 || zs->avail_out == 0 ||
+             (flush == Z_FINISH && r != Z_STREAM_END));
+
+    return TRUE;
+}
+
+/**
+ * Compress one string using zlib and return the length of the compressed
+ * data
+ * @param level Compression level
+ * @param x String x
+ * @return length of the compressed data
+ */
+static float zlib_str1(cfg_int level, hstring_t x)
+{
+    if (!engine_init(level) || deflateReset(&engine.zs) != Z_OK ||
+        !engine_feed(&engine.zs, x, Z_FINISH))
+        return -1;
+
+    return (float) engine.zs.total_out;
+}
+
+/**
+ * Compress the concatenation of two strings using zlib and return the
+ * length of the compressed data. If priming is requested and the prefix
+ * is long, the stream primed with the prefix is copied and only the
+ * suffix is compressed. The output is the same as when compressing the
+ * concatenation at once.
+ * @param level Compression level
+ * @param x Prefix string
+ * @param y Suffix string
+ * @param xl Compressed length of prefix (unused)
+ * @param prime Flag for priming with the prefix
+ * @return length of the compressed data.
+ */
+static float zlib_cat(cfg_int level, hstring_t x, hstring_t y, float xl,
+                      int prime)
+{
+    z_stream zs;
+    uint64_t key;
+    float len;
+
+    assert(x.type == y.type);
+
+    if (!engine_init(level))
+        return -1;
+
+    if (!prime || x.len < PRIME_MIN) {
+        if (deflateReset(&engine.zs) != Z_OK ||
+            !engine_feed(&engine.zs, x, Z_NO_FLUSH) ||
+            !engine_feed(&engine.zs, y, Z_FINISH))
+            return -1;
+        return (float) engine.zs.total_out;
+    }
+
+    /* Prime stream with prefix if it has changed */
+    key = hstring_hash1(x);
+    if (engine.prefix != key) {
+        engine.prefix = 0;
+        if (deflateReset(&engine.primed) != Z_OK ||
+            !engine_feed(&engine.primed, x, Z_NO_FLUSH))
+            return -1;
+        engine.prefix = key;
+    }
+
+    /* Copy primed stream into the pool */
+    engine.pooled = TRUE;
+    engine.used = 0;
+    if (deflateCopy(&zs, &engine.primed) != Z_OK) {
+        engine.pooled = FALSE;
+        error("Could not copy deflate stream");
+        return -1;
+    }
+    engine.pooled = FALSE;
+
+    len = engine_feed(&zs, y, Z_FINISH) ? (float) zs.total_out : -1;
+    deflateEnd(&zs);
+    return len;
+}
+
+#if defined(HAVE_ZSTD) || defined(HAVE_LZ4)
+/**
+ * Detach a string from a prefix. zstd and lz4 drop a dictionary that
+ * overlaps with the input, which happens if a string is compared with
+ * itself. In this case, the string is copied to scratch memory.
+ * @param x Prefix string
+ * @param y String
+ * @return string not overlapping with prefix
+ */
+static hstring_t str_detach(hstring_t x, hstring_t y)
+{
+    size_t len = str_bytes(y);
+    char *buf;
+
+    if (x.str.c != y.str.c)
+        return y;
+
+    buf = scratch_alloc(len + 1);
+    y.str.c = memcpy(buf, y.str.c, len);
+    return y;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+/**
+ * Prepare the zstd context of the current thread for a new frame
+ * @param level Compression level
+ * @return true on success, false otherwise
+ */
+static int zstd_init(cfg_int level)
+{
+    if (!engine.zstd && !(engine.zstd = ZSTD_createCCtx())) {
+        error("Could not create zstd context");
+        return FALSE;
+    }
+
+    /* Parameters are kept, only the frame is reset */
+    ZSTD_CCtx_reset(engine.zstd, ZSTD_reset_session_only);
+    ZSTD_CCtx_setParameter(engine.zstd, ZSTD_c_compressionLevel, level);
+    return TRUE;
 }
 
+/**
+ * Compress a string as one zstd frame. The compressed output is written
+ * to the sink buffer and only counted.
+ * @param x String
+ * @return length of the compressed data
+ */
+static float zstd_feed(hstring_t x)
+{
+    ZSTD_inBuffer in = { x.str.c, str_bytes(x), 0 };
+    size_t r, len = 0;
+
+    do {
+        ZSTD_outBuffer out = { engine.sink, SINK_SIZE, 0 };
+        r = ZSTD_compressStream2(engine.zstd, &out, &in, ZSTD_e_end);
+        if (ZSTD_isError(r)) {
+            error("Compression failed: %s", ZSTD_getErrorName(r));
+            return -1;
+        }
+        len += out.pos;
+    } while (r != 0);
+
+    return (float) len;
+}
 
 /**
- * Compress one string and return the length of the compressed data
+ * Compress one string using zstd
+ * @param level Compression level
  * @param x String x
  * @return length of the compressed data
  */
-static float compress_str1(hstring_t x)
+static float zstd_str1(cfg_int level, hstring_t x)
+{
+    if (!zstd_init(level))
+        return -1;
+
+    return zstd_feed(x);
+}
+
+/**
+ * Compress the concatenation of two strings using zstd. The prefix is
+ * referenced as raw dictionary, such that only the suffix is compressed.
+ * The length is the compressed prefix plus the conditionally compressed
+ * suffix.
+ * @param level Compression level
+ * @param x Prefix string
+ * @param y Suffix string
+ * @param xl Compressed length of prefix
+ * @param prime Flag for priming (unused)
+ * @return length of the compressed data.
+ */
+static float zstd_cat(cfg_int level, hstring_t x, hstring_t y, float xl,
+                      int prime)
 {
-    unsigned long tmp, width;
-    unsigned char *dst;
+    float yl;
 
-    width = x.type == TYPE_TOKEN ? sizeof(sym_t) : sizeof(char);
-    tmp = compressBound(x.len * width);
+    if (!zstd_init(level))
+        return -1;
+
+    ZSTD_CCtx_refPrefix(engine.zstd, x.str.c, str_bytes(x));
+    yl = zstd_feed(str_detach(x, y));
+    return yl < 0 ? -1 : xl + yl;
+}
+#endif
+
+#ifdef HAVE_LZ4
+/**
+ * Compress a string using lz4. If a prefix is given, it is loaded as
+ * dictionary of the stream first.
+ * @param x Prefix string or NULL
+ * @param y String
+ * @return length of the compressed data
+ */
+static float lz4_feed(hstring_t *x, hstring_t y)
+{
+    int len = str_bytes(y), bound = LZ4_compressBound(len), r;
+    char *out;
 
-    dst = malloc(tmp);
-    if (!dst) {
-        error("Failed to allocate memory for compression");
+    if (!engine.lz4 && !(engine.lz4 = LZ4_createStream())) {
+        error("Could not create lz4 stream");
         return -1;
     }
 
-    compress2(dst, &tmp, (void *) x.str.c, x.len * width, level);
+    out = scratch_alloc(bound);
+    if (!x) {
+        r = LZ4_compress_fast_extState(engine.lz4, y.str.c, out, len,
+                                       bound, 1);
+    } else {
+        LZ4_resetStream_fast(engine.lz4);
+        LZ4_loadDict(engine.lz4, x->str.c, str_bytes(*x));
+        r = LZ4_compress_fast_continue(engine.lz4, y.str.c, out, len,
+                                       bound, 1);
+    }
+
+    if (r <= 0) {
+        error("Compression failed: lz4 error %d", r);
+        return -1;
+    }
 
-    free(dst);
-    return (float) tmp;
+    return (float) r;
 }
 
 /**
- * Compress two strings and return the length of the compressed data
+ * Compress one string using lz4
+ * @param level Compression level (unused)
  * @param x String x
- * @param y String y
+ * @return length of the compressed data
+ */
+static float lz4_str1(cfg_int level, hstring_t x)
+{
+    return lz4_feed(NULL, x);
+}
+
+/**
+ * Compress the concatenation of two strings using lz4. As in a stream of
+ * lz4 blocks, the suffix is compressed with the prefix as dictionary.
+ * @param level Compression level (unused)
+ * @param x Prefix string
+ * @param y Suffix string
+ * @param xl Compressed length of prefix
+ * @param prime Flag for priming (unused)
  * @return length of the compressed data.
  */
-static float compress_str2(hstring_t x, hstring_t y)
+static float lz4_cat(cfg_int level, hstring_t x, hstring_t y, float xl,
+                     int prime)
 {
-    unsigned long tmp, width;
-    unsigned char *src, *dst;
+    float yl = lz4_feed(&x, str_detach(x, y));
+    return yl < 0 ? -1 : xl + yl;
+}
+#endif
 
-    assert(x.type == y.type);
+#ifdef HAVE_BZIP2
+/**
+ * Allocate memory for a bzip2 stream. bzip2 cannot reset a stream, yet
+ * it requests blocks of the same sizes for each stream. These blocks are
+ * kept in the engine and reused.
+ * @param opaque Engine
+ * @param items Number of items
+ * @param size Size of items
+ * @return memory or NULL on error
+ */
+static void *block_alloc(void *opaque, int items, int size)
+{
+    engine_t *e = opaque;
+    size_t len = (size_t) items * size;
+    int i, j = -1;
 
-    width = x.type == TYPE_TOKEN ? sizeof(sym_t) : sizeof(char);
-    tmp = compressBound((x.len + y.len) * width);
+    for (i = 0; i < BLOCK_CACHE; i++) {
+        if (e->blocks[i].busy)
+            continue;
+        if (e->blocks[i].ptr && e->blocks[i].size == len) {
+            e->blocks[i].busy = TRUE;
+            return e->blocks[i].ptr;
+        }
+        if (j < 0 || !e->blocks[i].ptr)
+            j = i;
+    }
 
-    dst = malloc(tmp);
-    src = malloc(tmp);
-    if (!src || !dst) {
-        error("Failed to allocate memory for compression");
+    if (j < 0)
+        return malloc(len);
+
+    free(e->blocks[j].ptr);
+    e->blocks[j].ptr = malloc(len);
+    e->blocks[j].size = len;
+    e->blocks[j].busy = e->blocks[j].ptr != NULL;
+    return e->blocks[j].ptr;
+}
+
+/**
+ * Release memory of a bzip2 stream
+ * @param opaque Engine
+ * @param p Memory
+ */
+static void block_free(void *opaque, void *p)
+{
+    engine_t *e = opaque;
+    int i;
+
+    for (i = 0; i < BLOCK_CACHE; i++) {
+        if (e->blocks[i].ptr == p) {
+            e->blocks[i].busy = FALSE;
+            return;
+        }
+    }
+    free(p);
+}
+
+/**
+ * Feed data to a bzip2 stream. The compressed output is written to the
+ * sink buffer and only counted.
+ * @param bs Stream
+ * @param x String
+ * @param action Action of bzip2
+ * @return true on success, false otherwise
+ */
+static int bzip2_feed(bz_stream *bs, hstring_t x, int action)
+{
+    int r;
+
+    bs->next_in = x.str.c;
+    bs->avail_in = str_bytes(x);
+
+    do {
+        bs->next_out = (char *) engine.sink;
+        bs->avail_out = SINK_SIZE;
+        r = BZ2_bzCompress(bs, action);
+        if (r < 0) {
+            error("Compression failed: bzip2 error %d", r);
+            return FALSE;
+        }
+    } while (action == BZ_FINISH ? r != BZ_STREAM_END : bs->avail_in > 0);
+
+    return TRUE;
+}
+
+/**
+ * Compress the concatenation of strings using bzip2. bzip2 has no notion
+ * of a dictionary, thus the concatenation is compressed at once.
+ * @param level Compression level
+ * @param x Prefix string or NULL
+ * @param y String
+ * @return length of the compressed data
+ */
+static float bzip2_run(cfg_int level, hstring_t *x, hstring_t y)
+{
+    bz_stream bs;
+    float len = -1;
+
+    memset(&bs, 0, sizeof(bs));
+    bs.bzalloc = block_alloc;
+    bs.bzfree = block_free;
+    bs.opaque = &engine;
+
+    if (BZ2_bzCompressInit(&bs, MIN(MAX(level, 1), 9), 0, 0) != BZ_OK) {
+        error("Could not initialize bzip2 stream");
         return -1;
     }
 
-    /* Concatenate sequences y and x */
-    memcpy(src, y.str.s, y.len * width);
-    memcpy(src + y.len * width, x.str.s, x.len * width);
+    if ((!x || bzip2_feed(&bs, *x, BZ_RUN)) && bzip2_feed(&bs, y, BZ_FINISH))
+        len = (float) bs.total_out_lo32 +
+            (float) ((uint64_t) bs.total_out_hi32 << 32);
 
-    compress2(dst, &tmp, src, (x.len + y.len) * width, level);
+    BZ2_bzCompressEnd(&bs);
+    return len;
+}
+
+/**
+ * Compress one string using bzip2
+ * @param level Compression level
+ * @param x String x
+ * @return length of the compressed data
+ */
+static float bzip2_str1(cfg_int level, hstring_t x)
+{
+    return bzip2_run(level, NULL, x);
+}
 
-    free(dst);
-    free(src);
-    return (float) tmp;
+/**
+ * Compress the concatenation of two strings using bzip2
+ * @param level Compression level
+ * @param x Prefix string
+ * @param y Suffix string
+ * @param xl Compressed length of prefix (unused)
+ * @param prime Flag for priming (unused)
+ * @return length of the compressed data.
+ */
+static float bzip2_cat(cfg_int level, hstring_t x, hstring_t y, float xl,
+                       int prime)
+{
+    return bzip2_run(level, &x, y);
 }
+#endif
 
+/* Table of backends. Missing functions indicate unavailable backends */
+static const backend_t backends[] = {
+    {"zlib", zlib_str1, zlib_cat},
+#ifdef HAVE_ZSTD
+    {"zstd", zstd_str1, zstd_cat},
+#else
+    {"zstd", NULL, NULL},
+#endif
+#ifdef HAVE_LZ4
+    {"lz4", lz4_str1, lz4_cat},
+#else
+    {"lz4", NULL, NULL},
+#endif
+#ifdef HAVE_BZIP2
+    {"bzip2", bzip2_str1, bzip2_cat},
+#else
+    {"bzip2", NULL, NULL},
+#endif
+    {NULL}
+};
 
+/* Default parameters */
+static const param_t defaults = { 0, &backends[0] };
+
+/**
+ * Initializes the similarity measure
+ * @param m Instance of measure
+ */
+void dist_compression_config(hmeasure_t *m)
+{
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
+    const char *str;
+    int i;
+
+    /* Configuration */
+    config_lookup_int(m->cfg, "measures.dist_compression.level", &p->level);
+    config_lookup_string(m->cfg, "measures.dist_compression.compressor",
+                         &str);
+
+    for (i = 0; backends[i].name; i++) {
+        if (strcasecmp(str, backends[i].name))
+            continue;
+        if (backends[i].str1)
+            p->backend = &backends[i];
+        else
+            warning("Harry has been compiled without %s support. "
+                    "Using 'zlib' instead.", backends[i].name);
+        return;
+    }
+
+    warning("Unknown compressor '%s'. Using 'zlib' instead.", str);
+}
 
 /**
- * Computes the compression distance of two strings. 
+ * Computes the compression distance of two strings. The compressor is
+ * primed with the first string, which is fixed when comparing one string
+ * with many others.
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return Compression distance
  */
-float dist_compression_compare(hstring_t x, hstring_t y)
+float dist_compression_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
+    param_t *p = m->param;
+    const backend_t *b = p->backend;
     float xl, yl, xyl, yxl;
     uint64_t xk, yk, xyk, yxk;
 
     xk = hstring_hash1(x);
-    if (!vcache_load(xk, &xl, ID_DIST_COMPRESS)) {
-        xl = compress_str1(x);
-        vcache_store(xk, xl, ID_DIST_COMPRESS);
+    if (!vcache_load_r(m->cache, xk, &xl, ID_DIST_COMPRESS)) {
+        xl = b->str1(p->level, x);
+        vcache_store_r(m->cache, xk, xl, ID_DIST_COMPRESS);
     }
 
     yk = hstring_hash1(y);
-    if (!vcache_load(yk, &yl, ID_DIST_COMPRESS)) {
-        yl = compress_str1(y);
-        vcache_store(yk, yl, ID_DIST_COMPRESS);
+    if (!vcache_load_r(m->cache, yk, &yl, ID_DIST_COMPRESS)) {
+        yl = b->str1(p->level, y);
+        vcache_store_r(m->cache, yk, yl, ID_DIST_COMPRESS);
     }
 
     xyk = hstring_hash2(x, y);
-    if (!vcache_load(xyk, &xyl, ID_DIST_COMPRESS)) {
-        xyl = compress_str2(x, y);
-        vcache_store(xyk, xyl, ID_DIST_COMPRESS);
+    if (!vcache_load_r(m->cache, xyk, &xyl, ID_DIST_COMPRESS)) {
+        xyl = b->cat(p->level, y, x, yl, FALSE);
+        vcache_store_r(m->cache, xyk, xyl, ID_DIST_COMPRESS);
     }
 
     yxk = hstring_hash2(y, x);
-    if (!vcache_load(yxk, &yxl, ID_DIST_COMPRESS)) {
-        yxl = compress_str2(y, x);
-        vcache_store(yxk, yxl, ID_DIST_COMPRESS);
+    if (!vcache_load_r(m->cache, yxk, &yxl, ID_DIST_COMPRESS)) {
+        yxl = b->cat(p->level, x, y, xl, TRUE);
+        vcache_store_r(m->cache, yxk, yxl, ID_DIST_COMPRESS);
     }
 
     /* Symmetric version of distance */
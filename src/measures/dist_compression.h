@@ -13,9 +13,10 @@
 #define DIST_COMPRESSION_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void dist_compression_config();
-float dist_compression_compare(hstring_t, hstring_t);
+void dist_compression_config(hmeasure_t *);
+float dist_compression_compare(hmeasure_t *, hstring_t, hstring_t);
 
 #endif /* DIST_COMPRESSION_H */
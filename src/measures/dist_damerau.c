@@ -15,6 +15,17 @@
 #include "util.h"
 #include "norm.h"
 #include "dist_damerau.h"
+#include "scratch.h"
+
+/* Hash tables are allocated from scratch memory */
+#undef uthash_tbl_malloc
+#undef uthash_tbl_free
+#undef uthash_bkt_malloc
+#undef uthash_bkt_free
+#define uthash_tbl_malloc(sz)   scratch_alloc(sz)
+#define uthash_tbl_free(ptr)
+#define uthash_bkt_malloc(sz)   scratch_alloc(sz)
+#define uthash_bkt_free(ptr)
 
 /**
  * @addtogroup measures
@@ -26,15 +37,20 @@
  * @{
  */
 
-/* Normalizations */
-static lnorm_t n = LN_NONE;
-static double cost_ins = 1.0;
-static double cost_del = 1.0;
-static double cost_sub = 1.0;
-static double cost_tra = 1.0;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    lnorm_t n;                  /**< Normalization */
+    double cost_ins;            /**< Cost of insertion */
+    double cost_del;            /**< Cost of deletion */
+    double cost_sub;            /**< Cost of substitution */
+    double cost_tra;            /**< Cost of transposition */
+} param_t;
 
-/* External variables */
-extern config_t cfg;
+/* Default parameters */
+static const param_t defaults = { LN_NONE, 1.0, 1.0, 1.0, 1.0 };
 
 /* Symbols hash table */
 typedef struct
@@ -64,7 +80,7 @@ static int hash_get(sym_hash_t **hash, sym_t s)
 
     HASH_FIND(hh, *hash, &s, sizeof(sym_t), entry);
     if (!entry) {
-        entry = malloc(sizeof(sym_hash_t));
+        entry = scratch_alloc(sizeof(sym_hash_t));
         entry->sym = s;
         entry->val = 0;
         HASH_ADD(hh, *hash, sym, sizeof(sym_t), entry);
@@ -85,7 +101,7 @@ static void hash_set(sym_hash_t **hash, sym_t s, int val)
 
     HASH_FIND(hh, *hash, &s, sizeof(sym_t), entry);
     if (!entry) {
-        entry = malloc(sizeof(sym_hash_t));
+        entry = scratch_alloc(sizeof(sym_hash_t));
         entry->sym = s;
         entry->val = val;
         HASH_ADD(hh, *hash, sym, sizeof(sym_t), entry);
@@ -94,37 +110,28 @@ static void hash_set(sym_hash_t **hash, sym_t s, int val)
     entry->val = val;
 }
 
-/**
- * Destroy hash table
- * @param hash hash table
- */
-static void hash_destroy(sym_hash_t **hash)
-{
-    sym_hash_t *entry;
-
-    while (*hash) {
-        entry = *hash;
-        HASH_DEL(*hash, entry);
-        free(entry);
-    }
-}
-
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void dist_damerau_config()
+void dist_damerau_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
     /* Costs */
-    config_lookup_float(&cfg, "measures.dist_damerau.cost_ins", &cost_ins);
-    config_lookup_float(&cfg, "measures.dist_damerau.cost_del", &cost_del);
-    config_lookup_float(&cfg, "measures.dist_damerau.cost_sub", &cost_sub);
-    config_lookup_float(&cfg, "measures.dist_damerau.cost_tra", &cost_tra);
+    config_lookup_float(m->cfg, "measures.dist_damerau.cost_ins",
+                        &p->cost_ins);
+    config_lookup_float(m->cfg, "measures.dist_damerau.cost_del",
+                        &p->cost_del);
+    config_lookup_float(m->cfg, "measures.dist_damerau.cost_sub",
+                        &p->cost_sub);
+    config_lookup_float(m->cfg, "measures.dist_damerau.cost_tra",
+                        &p->cost_tra);
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.dist_damerau.norm", &str);
-    n = lnorm_get(str);
+    config_lookup_string(m->cfg, "measures.dist_damerau.norm", &str);
+    p->n = lnorm_get(str);
 }
 
 /* Ugly macros to access arrays */
@@ -133,12 +140,14 @@ void dist_damerau_config()
 /**
  * Computes the Damerau-Levenshtein distance of two strings. Adapted from 
  * Wikipedia entry and comments from Stackoverflow.com
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return Levenshtein distance
  */
-float dist_damerau_compare(hstring_t x, hstring_t y)
+float dist_damerau_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
+    param_t *p = m->param;
     sym_hash_t *shash = NULL;
     int i, j, inf = x.len + y.len;
 
@@ -146,7 +155,7 @@ float dist_damerau_compare(hstring_t x, hstring_t y)
         return 0;
 
     /* Allocate table for dynamic programming */
-    int *d = malloc((x.len + 2) * (y.len + 2) * sizeof(int));
+    int *d = scratch_alloc((x.len + 2) * (y.len + 2) * sizeof(int));
     if (!d) {
         error("Could not allocate memory for Damerau-Levenshtein distance");
         return 0;
@@ -168,27 +177,21 @@ float dist_damerau_compare(hstring_t x, hstring_t y)
         for (j = 1; j <= y.len; j++) {
             int i1 = hash_get(&shash, hstring_get(y, j - 1));
             int j1 = db;
-            int dz = hstring_compare(x, i - 1, y, j - 1) ? cost_sub : 0;
+            int dz = hstring_compare(x, i - 1, y, j - 1) ? p->cost_sub : 0;
             if (dz == 0)
                 db = j;
 
             D(i + 1, j + 1) = min(D(i, j) + dz,
-                                  D(i + 1, j) + cost_ins,
-                                  D(i, j + 1) + cost_del,
-                                  D(i1, j1) + (i - i1 - 1) + cost_tra +
+                                  D(i + 1, j) + p->cost_ins,
+                                  D(i, j + 1) + p->cost_del,
+                                  D(i1, j1) + (i - i1 - 1) + p->cost_tra +
                                   (j - j1 - 1));
         }
 
         hash_set(&shash, hstring_get(x, i - 1), i);
     }
 
-    float r = D(x.len + 1, y.len + 1);
-
-    /* Free memory */
-    free(d);
-    hash_destroy(&shash);
-
-    return lnorm(n, r, x, y);
+    return lnorm(p->n, D(x.len + 1, y.len + 1), x, y);
 }
 
 /** @} */
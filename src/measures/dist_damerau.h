@@ -13,9 +13,10 @@
 #define DIST_DAMERAU_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void dist_damerau_config();
-float dist_damerau_compare(hstring_t, hstring_t);
+void dist_damerau_config(hmeasure_t *);
+float dist_damerau_compare(hmeasure_t *, hstring_t, hstring_t);
 
 #endif /* DIST_DAMERAU_H */
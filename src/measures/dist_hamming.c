@@ -14,6 +14,7 @@
 #include "util.h"
 #include "norm.h"
 #include "dist_hamming.h"
+#include "lanes.h"
 
 /**
  * @addtogroup measures
@@ -25,34 +26,43 @@
  * @{
  */
 
-/* Normalizations */
-static lnorm_t n = LN_NONE;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    lnorm_t n;                  /**< Normalization */
+} param_t;
 
-/* External variables */
-extern config_t cfg;
+/* Default parameters */
+static const param_t defaults = { LN_NONE };
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void dist_hamming_config()
+void dist_hamming_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.dist_hamming.norm", &str);
-    n = lnorm_get(str);
+    config_lookup_string(m->cfg, "measures.dist_hamming.norm", &str);
+    p->n = lnorm_get(str);
 }
 
 /**
  * Computes the Hamming distance of two strings. If the strings have
  * different lengths, the remaining symbols of the longer string are
  * considered mismatches.
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return Hamming distance
  */
-float dist_hamming_compare(hstring_t x, hstring_t y)
+float dist_hamming_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
+    param_t *p = m->param;
     float d = 0;
     int i;
 
@@ -64,7 +74,36 @@ float dist_hamming_compare(hstring_t x, hstring_t y)
     /* Add remaining characters as mismatches */
     d += fabs(y.len - x.len);
 
-    return lnorm(n, d, x, y);
+    return lnorm(p->n, d, x, y);
+}
+
+/**
+ * Computes the Hamming distance of one string to several strings. Short
+ * strings are compared in vector lanes.
+ * @param m Instance of measure
+ * @param x first string
+ * @param y array of second strings
+ * @param num number of second strings
+ * @param out array of distances
+ */
+void dist_hamming_compare_batch(hmeasure_t *m, hstring_t x, hstring_t *y,
+                                int num, float *out)
+{
+    param_t *p = m->param;
+    int i;
+
+    if (!lanes_hamming(x, y, num, out)) {
+        for (i = 0; i < num; i++)
+            out[i] = dist_hamming_compare(m, x, y[i]);
+        return;
+    }
+
+    for (i = 0; i < num; i++) {
+        if (isnan(out[i]))
+            out[i] = dist_hamming_compare(m, x, y[i]);
+        else
+            out[i] = lnorm(p->n, out[i], x, y[i]);
+    }
 }
 
 /** @} */
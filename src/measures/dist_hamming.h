@@ -13,9 +13,12 @@
 #define DIST_HAMMING_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void dist_hamming_config();
-float dist_hamming_compare(hstring_t, hstring_t);
+void dist_hamming_config(hmeasure_t *);
+float dist_hamming_compare(hmeasure_t *, hstring_t, hstring_t);
+void dist_hamming_compare_batch(hmeasure_t *, hstring_t, hstring_t *, int,
+                                float *);
 
 #endif /* DIST_HAMMING_H */
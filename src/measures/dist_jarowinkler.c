@@ -24,6 +24,8 @@
 #include "util.h"
 
 #include "dist_jarowinkler.h"
+#include "lanes.h"
+#include "scratch.h"
 
 /**
  * @addtogroup measures
@@ -40,11 +42,16 @@
  * @{
  */
 
-/* External variables */
-extern config_t cfg;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    double scaling;             /**< Scaling of prefix */
+} param_t;
 
-/* Global variables */
-static double scaling = 0.1;
+/* Default parameters */
+static const param_t defaults = { 0.1 };
 
 #ifdef JARO_COMPARE_SERRANO
 /* Some help functions */
@@ -61,10 +68,14 @@ static inline int min(int x, int y)
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void dist_jarowinkler_config()
+void dist_jarowinkler_config(hmeasure_t *m)
 {
-    config_lookup_float(&cfg, "measures.dist_jarowinkler.scaling", &scaling);
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
+
+    config_lookup_float(m->cfg, "measures.dist_jarowinkler.scaling",
+                        &p->scaling);
 }
 
 
@@ -85,13 +96,13 @@ static float dist_jaro_compare_serrano(hstring_t x, hstring_t y)
     if (x.len == 0 && y.len == 0)
         return 0.0;
 
-    char *xflags = calloc(sizeof(char), x.len);
+    char *xflags = scratch_calloc(sizeof(char), x.len);
     if (!xflags) {
         error("Could not allocate memory for Jaro distance");
         return 0;
     }
 
-    char *yflags = calloc(sizeof(char), y.len);
+    char *yflags = scratch_calloc(sizeof(char), y.len);
     if (!yflags) {
         error("Could not allocate memory for Jaro distance");
         return 0;
@@ -128,9 +139,6 @@ static float dist_jaro_compare_serrano(hstring_t x, hstring_t y)
     }
     t /= 2;
 
-    free(xflags);
-    free(yflags);
-
     return 1 - ((((float) m / x.len) + ((float) m / y.len) +
                  ((float) (m - t) / m)) / 3.0);
 }
@@ -162,7 +170,7 @@ static float dist_jaro_compare_yeti(hstring_t x, hstring_t y)
     }
 
     halflen = (x.len + 1) / 2;
-    idx = (int *) calloc(x.len, sizeof(int));
+    idx = scratch_calloc(x.len, sizeof(int));
     if (!idx) {
         error("Failed to allocate memory for Jaro distance");
         return 0;
@@ -178,7 +186,7 @@ static float dist_jaro_compare_yeti(hstring_t x, hstring_t y)
     match = 0;
     /* the part with allowed range overlapping left */
     for (i = 0; i < halflen; i++) {
-        for (j = 0; j <= i + halflen; j++) {
+        for (j = 0; j <= i + halflen && j < x.len; j++) {
             if (!hstring_compare(x, j, y, i) && !idx[j]) {
                 match++;
                 idx[j] = match;
@@ -198,10 +206,8 @@ static float dist_jaro_compare_yeti(hstring_t x, hstring_t y)
             }
         }
     }
-    if (!match) {
-        free(idx);
+    if (!match)
         return 1.0;
-    }
     /* count transpositions */
     i = 0;
     trans = 0;
@@ -212,7 +218,6 @@ static float dist_jaro_compare_yeti(hstring_t x, hstring_t y)
                 trans++;
         }
     }
-    free(idx);
 
     md = (float) match;
     return 1.0 - (md / x.len + md / y.len + 1.0 - trans / md / 2.0) / 3.0;
@@ -221,11 +226,12 @@ static float dist_jaro_compare_yeti(hstring_t x, hstring_t y)
 
 /**
  * Computes the Jaro-Winkler distance of two strings.
+ * @param m Instance of measure
  * @param x first string
  * @param y second string
  * @return Jaro-Winkler distance
  */
-float dist_jaro_compare(hstring_t x, hstring_t y)
+float dist_jaro_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
 #ifdef JARO_COMPARE_SERRANO
     return dist_jaro_compare_serrano(x, y);
@@ -235,15 +241,16 @@ float dist_jaro_compare(hstring_t x, hstring_t y)
 }
 
 /**
- * Computes the Jaro-Winkler distance of two strings.
+ * Applies the prefix scaling of Winkler to a Jaro distance.
+ * @param p Parameters of measure
+ * @param d Jaro distance
  * @param x first string
  * @param y second string
  * @return Jaro-Winkler distance
  */
-float dist_jarowinkler_compare(hstring_t x, hstring_t y)
+static float winkler(param_t *p, float d, hstring_t x, hstring_t y)
 {
     int l;
-    float d = dist_jaro_compare(x, y);
 
     /* Calculate common string prefix up to 4 chars */
     int m = min(min(x.len, y.len), 4);
@@ -252,7 +259,67 @@ float dist_jarowinkler_compare(hstring_t x, hstring_t y)
             break;
 
     /* Jaro-Winkler distance */
-    return d - l * scaling * d;
+    return d - l * p->scaling * d;
+}
+
+/**
+ * Computes the Jaro-Winkler distance of two strings.
+ * @param m Instance of measure
+ * @param x first string
+ * @param y second string
+ * @return Jaro-Winkler distance
+ */
+float dist_jarowinkler_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    return winkler(m->param, dist_jaro_compare(m, x, y), x, y);
+}
+
+/**
+ * Computes the Jaro distance of one string to several strings. Short
+ * strings are compared in vector lanes.
+ * @param m Instance of measure
+ * @param x first string
+ * @param y array of second strings
+ * @param num number of second strings
+ * @param out array of distances
+ */
+void dist_jaro_compare_batch(hmeasure_t *m, hstring_t x, hstring_t *y,
+                             int num, float *out)
+{
+    int i;
+
+#ifdef JARO_COMPARE_SERRANO
+    for (i = 0; i < num; i++)
+        out[i] = dist_jaro_compare(m, x, y[i]);
+#else
+    if (!lanes_jaro(x, y, num, out)) {
+        for (i = 0; i < num; i++)
+            out[i] = dist_jaro_compare(m, x, y[i]);
+        return;
+    }
+
+    for (i = 0; i < num; i++)
+        if (isnan(out[i]))
+            out[i] = dist_jaro_compare(m, x, y[i]);
+#endif
+}
+
+/**
+ * Computes the Jaro-Winkler distance of one string to several strings.
+ * @param m Instance of measure
+ * @param x first string
+ * @param y array of second strings
+ * @param num number of second strings
+ * @param out array of distances
+ */
+void dist_jarowinkler_compare_batch(hmeasure_t *m, hstring_t x,
+                                    hstring_t *y, int num, float *out)
+{
+    int i;
+
+    dist_jaro_compare_batch(m, x, y, num, out);
+    for (i = 0; i < num; i++)
+        out[i] = winkler(m->param, out[i], x, y[i]);
 }
 
 /** @} */
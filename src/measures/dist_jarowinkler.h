@@ -13,14 +13,19 @@
 #define DIST_JAROWINKLER_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Interface 1 */
-void dist_jarowinkler_config();
-float dist_jarowinkler_compare(hstring_t, hstring_t);
+void dist_jarowinkler_config(hmeasure_t *);
+float dist_jarowinkler_compare(hmeasure_t *, hstring_t, hstring_t);
+void dist_jarowinkler_compare_batch(hmeasure_t *, hstring_t, hstring_t *,
+                                    int, float *);
 
 /* Interface 2 */
 #define dist_jaro_config dist_jarowinkler_config
-float dist_jaro_compare(hstring_t, hstring_t);
+float dist_jaro_compare(hmeasure_t *, hstring_t, hstring_t);
+void dist_jaro_compare_batch(hmeasure_t *, hstring_t, hstring_t *, int,
+                             float *);
 
 
 #endif /* DIST_JAROWINKLER_H */
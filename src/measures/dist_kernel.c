@@ -28,75 +28,88 @@
  */
 
 /* External variables */
-extern config_t cfg;
 extern measure_t func[];
 
-/* Normalizations */
-static knorm_t norm = KN_NONE;
-static int kern = 0;
-static int squared = 1;
+/**
+ * Parameters of the measure. The kernel is a nested measure.
+ */
+typedef struct
+{
+    knorm_t norm;               /**< Normalization */
+    int squared;                /**< Flag for squared distance */
+} param_t;
+
+/* Default parameters */
+static const param_t defaults = { KN_NONE, 1 };
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void dist_kernel_config()
+void dist_kernel_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
     /* Kernel measure */
-    config_lookup_string(&cfg, "measures.dist_kernel.kern", &str);
-    kern = measure_match(str);
-    func[kern].measure_config();
+    config_lookup_string(m->cfg, "measures.dist_kernel.kern", &str);
+    measure_nested(m, str);
 
     /* Parameters */
-    config_lookup_bool(&cfg, "measures.dist_kernel.squared", &squared);
+    config_lookup_bool(m->cfg, "measures.dist_kernel.squared", &p->squared);
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.dist_kernel.norm", &str);
-    norm = knorm_get(str);
+    config_lookup_string(m->cfg, "measures.dist_kernel.norm", &str);
+    p->norm = knorm_get(str);
 }
 
 /**
  * Internal kernel function.
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return kernel value
  */
-static float kernel(hstring_t x, hstring_t y)
+static float kernel(hmeasure_t *m, hstring_t x, hstring_t y)
 {
-    double k = func[kern].measure_compare(x, y);
-    return knorm(norm, k, x, y, func[kern].measure_compare);
+    param_t *p = m->param;
+    measure_t *f = &func[m->sub->idx];
+
+    double k = f->measure_compare(m->sub, x, y);
+    return knorm(m->sub, p->norm, k, x, y, f->measure_compare);
 }
 
 /**
  * Compute a kernel-based distance
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return kernel-based distance
  */
-float dist_kernel_compare(hstring_t x, hstring_t y)
+float dist_kernel_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
+    param_t *p = m->param;
     float k1, k2, k3;
     uint64_t xk, yk;
     float d = 0;
 
     xk = hstring_hash1(x);
-    if (!vcache_load(xk, &k1, ID_DIST_KERNEL)) {
-        k1 = kernel(x, x);
-        vcache_store(xk, k1, ID_DIST_KERNEL);
+    if (!vcache_load_r(m->cache, xk, &k1, ID_DIST_KERNEL)) {
+        k1 = kernel(m, x, x);
+        vcache_store_r(m->cache, xk, k1, ID_DIST_KERNEL);
     }
 
     yk = hstring_hash1(y);
-    if (!vcache_load(yk, &k2, ID_DIST_KERNEL)) {
-        k2 = kernel(y, y);
-        vcache_store(yk, k2, ID_DIST_KERNEL);
+    if (!vcache_load_r(m->cache, yk, &k2, ID_DIST_KERNEL)) {
+        k2 = kernel(m, y, y);
+        vcache_store_r(m->cache, yk, k2, ID_DIST_KERNEL);
     }
 
     /* Not cached here */
-    k3 = kernel(x, y);
+    k3 = kernel(m, x, y);
     d = k1 + k2 - 2 * k3;
 
-    return squared ? d : sqrt(d);
+    return p->squared ? d : sqrt(d);
 }
 
 /** @} */
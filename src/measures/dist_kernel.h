@@ -13,9 +13,10 @@
 #define DIST_KERNEL_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void dist_kernel_config();
-float dist_kernel_compare(hstring_t, hstring_t);
+void dist_kernel_config(hmeasure_t *);
+float dist_kernel_compare(hmeasure_t *, hstring_t, hstring_t);
 
 #endif /* DIST_KERNEL_H */
@@ -25,43 +25,53 @@
  * @{
  */
 
-/* Alphabet size */
-static cfg_int min_sym = 0;
-static cfg_int max_sym = 255;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    cfg_int min_sym;            /**< Smallest symbol of alphabet */
+    cfg_int max_sym;            /**< Largest symbol of alphabet */
+} param_t;
 
-/* External variables */
-extern config_t cfg;
+/* Default parameters */
+static const param_t defaults = { 0, 255 };
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void dist_lee_config()
+void dist_lee_config(hmeasure_t *m)
 {
-    config_lookup_int(&cfg, "measures.dist_lee.min_sym", &min_sym);
-    config_lookup_int(&cfg, "measures.dist_lee.max_sym", &max_sym);
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
+
+    config_lookup_int(m->cfg, "measures.dist_lee.min_sym", &p->min_sym);
+    config_lookup_int(m->cfg, "measures.dist_lee.max_sym", &p->max_sym);
 }
 
 /**
  * Computes the Lee distance of two strings. If the strings have
  * different lengths, the remaining symbols of the longer string are
  * added to the distance.
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return Lee distance
  */
-float dist_lee_compare(hstring_t x, hstring_t y)
+float dist_lee_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
+    param_t *p = m->param;
     float d = 0, ad;
-    int i, q = max_sym - min_sym;
+    int i, q = p->max_sym - p->min_sym;
 
     /* Loop over strings */
     for (i = 0; i < x.len || i < y.len; i++) {
         if (i < x.len && i < y.len)
-            ad = fabs(hstring_compare(x, i, y, i) - min_sym);
+            ad = fabs(hstring_compare(x, i, y, i) - p->min_sym);
         else if (i < x.len)
-            ad = fabs(hstring_get(x, i) - min_sym);
+            ad = fabs(hstring_get(x, i) - p->min_sym);
         else
-            ad = fabs(hstring_get(y, i) - min_sym);
+            ad = fabs(hstring_get(y, i) - p->min_sym);
 
         if (ad > q) {
             warning("Distance of symbols larger than alphabet. Fixing.");
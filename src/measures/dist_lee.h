@@ -13,9 +13,10 @@
 #define DIST_LEE_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void dist_lee_config();
-float dist_lee_compare(hstring_t, hstring_t);
+void dist_lee_config(hmeasure_t *);
+float dist_lee_compare(hmeasure_t *, hstring_t, hstring_t);
 
 #endif /* DIST_LEE_H */
@@ -16,6 +16,8 @@
 #include "util.h"
 #include "norm.h"
 #include "dist_levenshtein.h"
+#include "lanes.h"
+#include "scratch.h"
 
 /**
  * @addtogroup measures
@@ -27,33 +29,45 @@
  * @{
  */
 
-/* Normalizations */
-static lnorm_t n = LN_NONE;
-static double cost_ins = 1.0;
-static double cost_del = 1.0;
-static double cost_sub = 1.0;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    lnorm_t n;                  /**< Normalization */
+    double cost_ins;            /**< Cost of insertion */
+    double cost_del;            /**< Cost of deletion */
+    double cost_sub;            /**< Cost of substitution */
+} param_t;
 
-/* External variables */
-extern config_t cfg;
+/* Default parameters */
+static const param_t defaults = { LN_NONE, 1.0, 1.0, 1.0 };
+
+/* Equal costs of all edit operations */
+#define UNIT_COSTS(p) \
+    (fabs((p)->cost_ins - (p)->cost_del) < 1e-6 && \
+     fabs((p)->cost_del - (p)->cost_sub) < 1e-6)
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void dist_levenshtein_config()
+void dist_levenshtein_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
     /* Costs */
-    config_lookup_float(&cfg, "measures.dist_levenshtein.cost_ins",
-                        &cost_ins);
-    config_lookup_float(&cfg, "measures.dist_levenshtein.cost_del",
-                        &cost_del);
-    config_lookup_float(&cfg, "measures.dist_levenshtein.cost_sub",
-                        &cost_sub);
+    config_lookup_float(m->cfg, "measures.dist_levenshtein.cost_ins",
+                        &p->cost_ins);
+    config_lookup_float(m->cfg, "measures.dist_levenshtein.cost_del",
+                        &p->cost_del);
+    config_lookup_float(m->cfg, "measures.dist_levenshtein.cost_sub",
+                        &p->cost_sub);
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.dist_levenshtein.norm", &str);
-    n = lnorm_get(str);
+    config_lookup_string(m->cfg, "measures.dist_levenshtein.norm", &str);
+    p->n = lnorm_get(str);
 }
 
 
@@ -99,7 +113,7 @@ static float dist_levenshtein_compare_yeti(hstring_t x, hstring_t y)
     half = x.len >> 1;
 
     /* Unitalize first row */
-    row = (int *) malloc((y.len ) * sizeof(int));
+    row = scratch_alloc((y.len ) * sizeof(int));
     if (!row) {
         error("Failed to allocate memory for Levenshtein distance");
         return 0;
@@ -164,9 +178,7 @@ static float dist_levenshtein_compare_yeti(hstring_t x, hstring_t y)
         }
     }
 
-    i = *end;
-    free(row);
-    return i;
+    return *end;
 }
 
 /* Ugly macros to access arrays */
@@ -176,11 +188,13 @@ static float dist_levenshtein_compare_yeti(hstring_t x, hstring_t y)
  * Computes the Levenshtein distance of two strings. 
  * Adapted from Stephen Toub's C# implementation. 
  * http://blogs.msdn.com/b/toub/archive/2006/05/05/590814.aspx
+ * @param p Parameters of measure
  * @param x first string
  * @param y second string
  * @return Levenshtein distance
  */
-static float dist_levenshtein_compare_toub(hstring_t x, hstring_t y)
+static float dist_levenshtein_compare_toub(param_t *p, hstring_t x,
+                                           hstring_t y)
 {
     int i, j, a, b;
 
@@ -193,7 +207,7 @@ static float dist_levenshtein_compare_toub(hstring_t x, hstring_t y)
      * has a length m+1, so just O(m) space.  Initialize the curr row.
      */
     int curr = 0, next = 1;
-    int *rows = malloc(sizeof(int) * (y.len + 1) * 2);
+    int *rows = scratch_alloc(sizeof(int) * (y.len + 1) * 2);
     if (!rows) {
         error("Failed to allocate memory for Levenshtein distance");
         return 0;
@@ -210,14 +224,14 @@ static float dist_levenshtein_compare_toub(hstring_t x, hstring_t y)
         for (j = 1; j <= y.len; j++) {
 
             /* Insertion and deletion */
-            a = ROWS(curr,j) + cost_ins;
-            b = ROWS(next, j - 1) + cost_del;
+            a = ROWS(curr,j) + p->cost_ins;
+            b = ROWS(next, j - 1) + p->cost_del;
             if (a > b)
                 a = b;
 
             /* Substitution */
             b = ROWS(curr, j - 1) +
-                (hstring_compare(x, i - 1, y, j - 1) ? cost_sub : 0);
+                (hstring_compare(x, i - 1, y, j - 1) ? p->cost_sub : 0);
 
             if (a > b)
                 a = b;
@@ -239,23 +253,20 @@ static float dist_levenshtein_compare_toub(hstring_t x, hstring_t y)
             next = 1;
         }
     }
-    double d = ROWS(curr, y.len);
-
-    /* Free memory */
-    free(rows);
-
-    return d;
+    return ROWS(curr, y.len);
 }
 
 
 /**
  * Computes the Levenshtein distance. Wrapper function.
+ * @param m Instance of measure
  * @param x first string
  * @param y second string
  * @return Levenshtein distance
  */
-float dist_levenshtein_compare(hstring_t x, hstring_t y)
+float dist_levenshtein_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
+    param_t *p = m->param;
     float f;
 
     /*
@@ -263,13 +274,93 @@ float dist_levenshtein_compare(hstring_t x, hstring_t y)
      * implementation by David Necas, otherwise we switch to the 
      * variant by Stephen Toub.
      */
-    if (fabs(cost_ins - cost_del) < 1e-6 && fabs(cost_del - cost_sub) < 1e-6) {
-        f = cost_ins * dist_levenshtein_compare_yeti(x, y);
+    if (UNIT_COSTS(p)) {
+        f = p->cost_ins * dist_levenshtein_compare_yeti(x, y);
     } else {
-        f = dist_levenshtein_compare_toub(x,y);
+        f = dist_levenshtein_compare_toub(p, x, y);
+    }
+
+    return lnorm(p->n, f, x, y);
+}
+
+/**
+ * Computes the Levenshtein distance with unit costs up to a bound. Only a
+ * band of 2k + 1 diagonals of the distance matrix is computed, such that
+ * the run-time is O(k * |x|). The computation stops early if all values
+ * of a row exceed the bound.
+ * @param x first string
+ * @param y second string
+ * @param k bound on the distance
+ * @return Levenshtein distance or k + 1 if the distance exceeds k
+ */
+int dist_levenshtein_bounded(hstring_t x, hstring_t y, int k)
+{
+    int i, j, lo, hi, min, *prev, *curr, *tmp;
+
+    if (abs(x.len - y.len) > k)
+        return k + 1;
+
+    prev = scratch_alloc(sizeof(int) * (y.len + 2) * 2);
+    if (!prev) {
+        error("Failed to allocate memory for Levenshtein distance");
+        return k + 1;
     }
+    curr = prev + y.len + 2;
 
-    return lnorm(n, f, x, y);
+    for (j = 0; j <= y.len + 1; j++)
+        prev[j] = j <= k ? j : k + 1;
+
+    for (i = 1; i <= x.len; i++) {
+        lo = MAX(1, i - k);
+        hi = MIN(y.len, i + k);
+
+        /* Values left and right of the band */
+        curr[lo - 1] = lo == 1 ? i : k + 1;
+        curr[hi + 1] = k + 1;
+
+        for (j = lo, min = curr[lo - 1]; j <= hi; j++) {
+            int a = MIN(prev[j], curr[j - 1]) + 1;
+            int b = prev[j - 1] + (hstring_compare(x, i - 1, y, j - 1) != 0);
+            curr[j] = MIN(MIN(a, b), k + 1);
+            min = MIN(min, curr[j]);
+        }
+
+        if (min > k)
+            return k + 1;
+
+        tmp = prev, prev = curr, curr = tmp;
+    }
+
+    return prev[y.len];
+}
+
+/**
+ * Computes the Levenshtein distance of one string to several strings. If
+ * the costs are equal, short strings are compared in vector lanes.
+ * @param m Instance of measure
+ * @param x first string
+ * @param y array of second strings
+ * @param num number of second strings
+ * @param out array of distances
+ */
+void dist_levenshtein_compare_batch(hmeasure_t *m, hstring_t x,
+                                    hstring_t *y, int num, float *out)
+{
+    param_t *p = m->param;
+    int i;
+
+    if (!UNIT_COSTS(p) || !lanes_levenshtein(x, y, num, out)) {
+        for (i = 0; i < num; i++)
+            out[i] = dist_levenshtein_compare(m, x, y[i]);
+        return;
+    }
+
+    for (i = 0; i < num; i++) {
+        if (isnan(out[i]))
+            out[i] = dist_levenshtein_compare(m, x, y[i]);
+        else
+            out[i] = lnorm(p->n, (float) (p->cost_ins * out[i]), x, y[i]);
+    }
 }
 
 /** @} */
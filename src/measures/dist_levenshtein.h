@@ -13,9 +13,15 @@
 #define DIST_LEVENSHTEIN_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void dist_levenshtein_config();
-float dist_levenshtein_compare(hstring_t, hstring_t);
+void dist_levenshtein_config(hmeasure_t *);
+float dist_levenshtein_compare(hmeasure_t *, hstring_t, hstring_t);
+void dist_levenshtein_compare_batch(hmeasure_t *, hstring_t, hstring_t *,
+                                    int, float *);
+
+/* Threshold joins */
+int dist_levenshtein_bounded(hstring_t, hstring_t, int);
 
 #endif /* DIST_LEVENSHTEIN_H */
@@ -14,6 +14,7 @@
 #include "util.h"
 #include "norm.h"
 #include "dist_osa.h"
+#include "scratch.h"
 
 /**
  * @addtogroup measures
@@ -25,32 +26,43 @@
  @{
  */
 
-/* Normalizations */
-static lnorm_t n = LN_NONE;
-static double cost_ins = 1.0;
-static double cost_del = 1.0;
-static double cost_sub = 1.0;
-static double cost_tra = 1.0;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    lnorm_t n;                  /**< Normalization */
+    double cost_ins;            /**< Cost of insertion */
+    double cost_del;            /**< Cost of deletion */
+    double cost_sub;            /**< Cost of substitution */
+    double cost_tra;            /**< Cost of transposition */
+} param_t;
 
-/* External variables */
-extern config_t cfg;
+/* Default parameters */
+static const param_t defaults = { LN_NONE, 1.0, 1.0, 1.0, 1.0 };
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void dist_osa_config()
+void dist_osa_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
     /* Costs */
-    config_lookup_float(&cfg, "measures.dist_osa.cost_ins", &cost_ins);
-    config_lookup_float(&cfg, "measures.dist_osa.cost_del", &cost_del);
-    config_lookup_float(&cfg, "measures.dist_osa.cost_sub", &cost_sub);
-    config_lookup_float(&cfg, "measures.dist_osa.cost_tra", &cost_tra);
+    config_lookup_float(m->cfg, "measures.dist_osa.cost_ins",
+                        &p->cost_ins);
+    config_lookup_float(m->cfg, "measures.dist_osa.cost_del",
+                        &p->cost_del);
+    config_lookup_float(m->cfg, "measures.dist_osa.cost_sub",
+                        &p->cost_sub);
+    config_lookup_float(m->cfg, "measures.dist_osa.cost_tra",
+                        &p->cost_tra);
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.dist_osa.norm", &str);
-    n = lnorm_get(str);
+    config_lookup_string(m->cfg, "measures.dist_osa.norm", &str);
+    p->n = lnorm_get(str);
 }
 
 /* Ugly macros to access arrays */
@@ -58,25 +70,31 @@ void dist_osa_config()
 
 /**
  * Computes the OSA distance of two strings. 
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return OSA distance
  */
-float dist_osa_compare(hstring_t x, hstring_t y)
+float dist_osa_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
+    param_t *p = m->param;
     int i, j, a, b, c;
 
     if (x.len == 0 && y.len == 0)
         return 0;
 
     /* Allocate matrix. We might reduce this to some rows only */
-    int *d = (int *) calloc((x.len + 1) * (y.len + 1), sizeof(int));
+    int *d = scratch_calloc((x.len + 1) * (y.len + 1), sizeof(int));
+    if (!d) {
+        error("Could not allocate memory for OSA distance");
+        return 0;
+    }
 
     /* Init margin of matrix */
     for (i = 0; i <= x.len; i++)
-        D(i, 0) = i * cost_ins;
+        D(i, 0) = i * p->cost_ins;
     for (j = 0; j <= y.len; j++)
-        D(0, j) = j * cost_ins;
+        D(0, j) = j * p->cost_ins;
 
     for (i = 1; i <= x.len; i++) {
         for (j = 1; j <= y.len; j++) {
@@ -85,13 +103,13 @@ float dist_osa_compare(hstring_t x, hstring_t y)
             c = hstring_compare(x, i - 1, y, j - 1);
 
             /* Insertion an deletion */
-            a = D(i - 1, j) + cost_ins;
-            b = D(i, j - 1) + cost_del;
+            a = D(i - 1, j) + p->cost_ins;
+            b = D(i, j - 1) + p->cost_del;
             if (a > b)
                 a = b;
 
             /* Substitution */
-            b = D(i - 1, j - 1) + (c ? cost_sub : 0);
+            b = D(i - 1, j - 1) + (c ? p->cost_sub : 0);
             if (a > b)
                 a = b;
 
@@ -99,7 +117,7 @@ float dist_osa_compare(hstring_t x, hstring_t y)
             if (i > 1 && j > 1 && 
                 !hstring_compare(x, i - 1, y, j - 2) &&
                 !hstring_compare(x, i - 2, y, j - 1)) {
-                b = D(i - 2, j - 2) + (c ? cost_tra : 0);
+                b = D(i - 2, j - 2) + (c ? p->cost_tra : 0);
                 if (a > b)
                     a = b;
             }
@@ -109,10 +127,9 @@ float dist_osa_compare(hstring_t x, hstring_t y)
         }
     }
 
-    double m = D(x.len, y.len);
-    free(d);
+    double v = D(x.len, y.len);
 
-    return lnorm(n, m, x, y);
+    return lnorm(p->n, v, x, y);
 }
 
 /** @} */
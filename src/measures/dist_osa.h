@@ -13,9 +13,10 @@
 #define DIST_OSA_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void dist_osa_config();
-float dist_osa_compare(hstring_t, hstring_t);
+void dist_osa_config(hmeasure_t *);
+float dist_osa_compare(hmeasure_t *, hstring_t, hstring_t);
 
 #endif /* DIST_OSA_H */
@@ -1,5 +1,6 @@
 #!/usr/bin/env python
 import sys
+import os
 
 measures = set()
 modules = set()
@@ -23,12 +24,34 @@ includes = ""
 for m in sorted(modules):
     includes += '#include "%s.h"\n' % m
 
+# Find modules with batch comparison
+module = {}
+for line in open(sys.argv[1]).readlines():
+    if line.startswith('#'):
+        continue
+    tok = line.strip().split(':')
+    module[tok[0].split(',')[0]] = tok[1]
+
+def batch(m):
+    header = os.path.join(os.path.dirname(sys.argv[1]), module[m] + '.h')
+    if '%s_compare_batch' % m in open(header).read():
+        return '%s_compare_batch' % m
+    return 'NULL'
+
 # Prepare interfaces
+def compare_all(m):
+    header = os.path.join(os.path.dirname(sys.argv[1]), module[m] + '.h')
+    if '%s_compare_all' % m in open(header).read():
+        return '%s_compare_all' % m
+    return 'NULL'
+
 interfaces = 'measure_t func[] = {\n'
 for m in sorted(measures):
-    interfaces += '    {"%s", %s_config, %s_compare},\n' % (m,m,m)
+    interfaces += '    {"%s", %s_config, %s_compare, %s, %s},\n' % \
+        (m,m,m,batch(m),compare_all(m))
     for a in aliases[m]:
-        interfaces += '    {"%s", %s_config, %s_compare},\n' % (a,m,m)
+        interfaces += '    {"%s", %s_config, %s_compare, %s, %s},\n' % \
+            (a,m,m,batch(m),compare_all(m))
 interfaces += '    {NULL}\n};'
 
 # Prepare list
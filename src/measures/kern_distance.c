@@ -29,129 +29,165 @@
  */
 
 /* External variables */
-extern config_t cfg;
 extern measure_t func[];
 
-/* Normalizations */
-static knorm_t norm = KN_NONE;
-static subst_t subst = DS_LINEAR;
-static int dist = 0;
-static double fgamma = 1.0;
-static double degree = 1.0;
-
 /**
- * Initializes the similarity measure
+ * Parameters of the measure. The distance is a nested measure.
  */
-void kern_distance_config()
+typedef struct
 {
-    const char *str;
+    knorm_t norm;               /**< Normalization */
+    subst_t subst;              /**< Substitution type */
+    double fgamma;              /**< Scaling factor */
+    double degree;              /**< Polynomial degree */
+} param_t;
 
-    /* Distance measure */
-    config_lookup_string(&cfg, "measures.kern_distance.dist", &str);
-    dist = measure_match(str);
-    func[dist].measure_config();
+/* Default parameters */
+static const param_t defaults = { KN_NONE, DS_LINEAR, 1.0, 1.0 };
 
-    /* Substitution type */
-    config_lookup_string(&cfg, "measures.kern_distance.type", &str);
+/**
+ * Parse string for substitution type
+ * @param str String for substitution type
+ * @return substitution type
+ */
+subst_t subst_get(const char *str)
+{
     if (!strcasecmp(str, "linear")) {
-        subst = DS_LINEAR;
+        return DS_LINEAR;
     } else if (!strcasecmp(str, "poly")) {
-        subst = DS_POLY;
+        return DS_POLY;
     } else if (!strcasecmp(str, "neg")) {
-        subst = DS_NEG;
+        return DS_NEG;
     } else if (!strcasecmp(str, "rbf")) {
-        subst = DS_RBF;
-    } else {
-        warning("Unknown substitution type '%s'. Using 'linear'.", str);
-        subst = DS_LINEAR;
+        return DS_RBF;
     }
 
+    warning("Unknown substitution type '%s'. Using 'linear'.", str);
+    return DS_LINEAR;
+}
+
+/**
+ * Initializes the similarity measure
+ * @param m Instance of measure
+ */
+void kern_distance_config(hmeasure_t *m)
+{
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
+    const char *str;
+
+    /* Distance measure */
+    config_lookup_string(m->cfg, "measures.kern_distance.dist", &str);
+    measure_nested(m, str);
+
+    /* Substitution type */
+    config_lookup_string(m->cfg, "measures.kern_distance.type", &str);
+    p->subst = subst_get(str);
+
     /* Parameters */
-    config_lookup_float(&cfg, "measures.kern_distance.gamma", &fgamma);
-    config_lookup_float(&cfg, "measures.kern_distance.degree", &degree);
+    config_lookup_float(m->cfg, "measures.kern_distance.gamma", &p->fgamma);
+    config_lookup_float(m->cfg, "measures.kern_distance.degree",
+                        &p->degree);
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.kern_distance.norm", &str);
-    norm = knorm_get(str);
+    config_lookup_string(m->cfg, "measures.kern_distance.norm", &str);
+    p->norm = knorm_get(str);
 
 }
 
 /**
- * Internal computation of an inner product in an implicit feature space. 
- * The inner-product space is created by centering the distances at the
- * empty string. Note that if the distance is not Euclidean, the computed
- * result is undefined and a feature space may not exist.
+ * Substitute a distance into a kernel. The linear and polynomial
+ * substitution use an inner product in an implicit feature space that is
+ * created by centering the distances at the empty string. Note that if
+ * the distance is not Euclidean, the computed result is undefined and a
+ * feature space may not exist.
  *
+ * @param s Substitution type
+ * @param gamma Scaling factor
+ * @param degree Polynomial degree
+ * @param d Distance of x and y
+ * @param dx Distance of x and the empty string
+ * @param dy Distance of y and the empty string
+ * @return kernel value
+ */
+float subst_kernel(subst_t s, double gamma, double degree, float d,
+                   float dx, float dy)
+{
+    float dot;
+
+    switch (s) {
+    default:
+    case DS_LINEAR:
+        dot = -0.5 * (d * d - dy * dy - dx * dx);
+        return dot;
+    case DS_POLY:
+        dot = -0.5 * (d * d - dy * dy - dx * dx);
+        return pow(1 + gamma * dot, degree);
+    case DS_NEG:
+        return -pow(d, degree);
+    case DS_RBF:
+        return exp(-gamma * d * d);
+    }
+}
+
+/**
+ * Internal computation of the distance to the empty string
+ * @param m Instance of measure
  * @param x String x
- * @param y String y
- * @return inner product (dot)
+ * @return distance
  */
-static float dot(hstring_t x, hstring_t y)
+static float empty(hmeasure_t *m, hstring_t x)
 {
     hstring_t o;
-    uint64_t xk, yk;
-    float d1, d2, d3;
+    uint64_t xk;
+    float d;
 
     o = hstring_empty(o, x.type);
 
     xk = hstring_hash1(x);
-    if (!vcache_load(xk, &d1, ID_KERN_DISTANCE)) {
-        d1 = func[dist].measure_compare(x, o);
-        vcache_store(xk, d1, ID_KERN_DISTANCE);
-    }
-
-    yk = hstring_hash1(y);
-    if (!vcache_load(yk, &d2, ID_KERN_DISTANCE)) {
-        d2 = func[dist].measure_compare(y, o);
-        vcache_store(yk, d2, ID_KERN_DISTANCE);
+    if (!vcache_load_r(m->cache, xk, &d, ID_KERN_DISTANCE)) {
+        d = func[m->sub->idx].measure_compare(m->sub, x, o);
+        vcache_store_r(m->cache, xk, d, ID_KERN_DISTANCE);
     }
 
-    /* Not cached here */
-    d3 = func[dist].measure_compare(x, y);
-    return -0.5 * (d3 * d3 - d2 * d2 - d1 * d1);
+    return d;
 }
 
 /**
  * Internal computation of distance substitution kernel 
+ * @param m Instance of measure
  * @param x first string
  * @param y second string
  * @return distance substitution kernel
  */
-static float kernel(hstring_t x, hstring_t y)
+static float kernel(hmeasure_t *m, hstring_t x, hstring_t y)
 {
-    float d, k = 0;
+    param_t *p = m->param;
+    float dx = 0, dy = 0;
 
-    switch (subst) {
-    default:
-    case DS_LINEAR:
-        k = dot(x, y);
-        break;
-    case DS_POLY:
-        k = pow(1 + fgamma * dot(x, y), degree);
-        break;
-    case DS_NEG:
-        d = func[dist].measure_compare(x, y);
-        k = -pow(d, degree);
-        break;
-    case DS_RBF:
-        d = func[dist].measure_compare(x, y);
-        k = exp(-fgamma * d * d);
-        break;
+    /* Only the linear and polynomial substitution need an origin */
+    if (p->subst == DS_LINEAR || p->subst == DS_POLY) {
+        dx = empty(m, x);
+        dy = empty(m, y);
     }
 
-    return k;
+    /* Not cached here */
+    return subst_kernel(p->subst, p->fgamma, p->degree,
+                        func[m->sub->idx].measure_compare(m->sub, x, y),
+                        dx, dy);
 }
 
 /**
  * Compute a distance substitution kernel
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return distance substitution kernel
  */
-float kern_distance_compare(hstring_t x, hstring_t y)
+float kern_distance_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
-    float k = kernel(x, y);
-    return knorm(norm, k, x, y, kernel);
+    param_t *p = m->param;
+    float k = kernel(m, x, y);
+    return knorm(m, p->norm, k, x, y, kernel);
 }
 
 /** @} */
@@ -13,6 +13,7 @@
 #define KERN_DISTANCE_H
 
 #include "hstring.h"
+#include "measures.h"
 
 typedef enum
 {
@@ -20,7 +21,11 @@ typedef enum
 } subst_t;
 
 /* Module interface */
-void kern_distance_config();
-float kern_distance_compare(hstring_t, hstring_t);
+void kern_distance_config(hmeasure_t *);
+float kern_distance_compare(hmeasure_t *, hstring_t, hstring_t);
+
+/* Substitution of distances */
+subst_t subst_get(const char *);
+float subst_kernel(subst_t, double, double, float, float, float);
 
 #endif /* KERN_DISTANCE_H */
@@ -15,6 +15,7 @@
 #include "vcache.h"
 #include "norm.h"
 #include "kern_spectrum.h"
+#include "scratch.h"
 
 /**
  * @addtogroup measures
@@ -23,8 +24,10 @@
  *
  * The runtime complexity of the kernel is linear in the length of the 
  * strings. However, the implementation is not very efficient, as the 
- * k-mers are repeatedly extracted from the strings. A caching mechanism
- * might provide a considerable acceleration here.
+ * k-mers are repeatedly extracted from the strings. When a row of the
+ * matrix is computed, the k-mers of the fixed string are extracted only
+ * once. A full matrix is computed using an inverted index of the k-mers,
+ * such that only pairs of strings sharing k-mers are visited.
  *
  * C. Leslie, E. Eskin, and W. Noble. The spectrum kernel: a string kernel
  * for SVM protein classifica- tion.  In Proc. of Pacific Symposium on
@@ -32,28 +35,46 @@
  * @{
  */
 
-/* External variables */
-extern config_t cfg;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    knorm_t n;                  /**< Normalization */
+    cfg_int len;                /**< Length of k-mers */
+} param_t;
 
-/* Normalizations */
-static knorm_t n = KN_NONE;
+/* Default parameters */
+static const param_t defaults = { KN_NONE, 3 };
 
-/* Local variables */
-static cfg_int len = 3;         /**< Length of k-mers */
+/**
+ * Entry of the inverted index of k-mers
+ */
+typedef struct
+{
+    uint64_t key;               /**< Hash of k-mer */
+    int id;                     /**< Index of string */
+    float cnt;                  /**< Number of occurrences */
+} posting_t;
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void kern_spectrum_config()
+void kern_spectrum_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
     /* Length parameter */
-    config_lookup_int(&cfg, "measures.kern_spectrum.length", &len);
+    config_lookup_int(m->cfg, "measures.kern_spectrum.length", &p->len);
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.kern_spectrum.norm", &str);
-    n = knorm_get(str);
+    config_lookup_string(m->cfg, "measures.kern_spectrum.norm", &str);
+    p->n = knorm_get(str);
+
+    /* Signatures of k-mers */
+    hstring_sig_config_r(m->prep, p->len);
 }
 
 
@@ -75,85 +96,339 @@ static int cmp_uint64(const void *x, const void *y)
 /**
  * Extract and sort k-mers in a string and return their hashes.
  * @param x string 
+ * @param len Length of k-mers
+ * @param num Return pointer for number of k-mers
  * @return array of sorted k-mer hashes
  */
-static uint64_t *extract_kmers(hstring_t x)
+static uint64_t *extract_kmers(hstring_t x, int len, int *num)
 {
-    assert(x.len - len + 1 >= 0);
-
     int i;
 
-    uint64_t *xh = malloc(x.len * sizeof(uint64_t));
+    *num = MAX(x.len - len + 1, 0);
+    uint64_t *xh = scratch_alloc(MAX(*num, 1) * sizeof(uint64_t));
     if (!xh) {
         error("Could not allocate memory for spectrum kernel");
+        *num = 0;
         return NULL;
     }
     
-    for (i = 0; i < x.len - len + 1; i++) 
+    for (i = 0; i < *num; i++) 
         xh[i] = hstring_hash_sub(x, i, len);    
     
-    qsort(xh, x.len - len + 1, sizeof(uint64_t), cmp_uint64);
+    qsort(xh, *num, sizeof(uint64_t), cmp_uint64);
     return xh;
 }
 
 /**
- * Internal computation of spectrum kernel
- * @param x first string
- * @param y second string
+ * Compute the spectrum kernel from two sorted arrays of k-mer hashes
+ * @param xh k-mers of first string
+ * @param xn number of k-mers of first string
+ * @param yh k-mers of second string
+ * @param yn number of k-mers of second string
  * @return spectrum kernel
  */
-static float kernel(hstring_t x, hstring_t y)
+static float spectrum(uint64_t *xh, int xn, uint64_t *yh, int yn)
 {
     float k = 0;
     int i = 0, j = 0;
-    
-    /* Check for small strings */
-    if (x.len < len || y.len < len)
-        return 0;
-    
-    /* Extract k-mers */
-    uint64_t *xh = extract_kmers(x);
-    uint64_t *yh = extract_kmers(y);
-    
-    while(i < x.len - len + 1 && j < y.len - len + 1) {
+
+    while (i < xn && j < yn) {
         if (xh[i] < yh[j]) {
             i++;
         } else if (xh[i] > yh[j]) {
             j++;
         } else {
-            float xn = 0;
-            while(xh[i] == yh[j]) {
-                i++;
-                xn++;
-            }
+            uint64_t h = xh[i];
+            float xc = 0, yc = 0;
 
-            float yn = 0;
-            while(xh[i - 1] == yh[j]) {
-                j++;
-                yn++;
-            }
+            for (; i < xn && xh[i] == h; i++)
+                xc++;
+            for (; j < yn && yh[j] == h; j++)
+                yc++;
 
-            k += xn * yn;
+            k += xc * yc;
         }
-    } 
-    
-    /* Free space */
-    free(xh);
-    free(yh);
-    
+    }
+
     return k;
 }
 
+/**
+ * Internal computation of spectrum kernel
+ * @param m Instance of measure
+ * @param x first string
+ * @param y second string
+ * @return spectrum kernel
+ */
+static float kernel(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    param_t *p = m->param;
+    int xn, yn, len = p->len;
+
+    /* Check for small strings */
+    if (x.len < len || y.len < len)
+        return 0;
+    
+    /* Extract k-mers */
+    uint64_t *xh = extract_kmers(x, len, &xn);
+    uint64_t *yh = extract_kmers(y, len, &yn);
+
+    return spectrum(xh, xn, yh, yn);
+}
+
 /**
  * Compute the spectrum kernel by Leslie et al. (2002). 
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return spectrum kernel
  */
-float kern_spectrum_compare(hstring_t x, hstring_t y)
+float kern_spectrum_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    param_t *p = m->param;
+    int len = p->len;
+
+    /* Strings without common k-mers */
+    if (x.len >= len && y.len >= len && hstring_sig_disjoint(x, y, len))
+        return 0;
+
+    float k = kernel(m, x, y);
+    return knorm(m, p->n, k, x, y, kernel);
+}
+
+/**
+ * Compute the spectrum kernel between one string and several strings.
+ * The k-mers of the first string are extracted only once.
+ * @param m Instance of measure
+ * @param x first string
+ * @param ys array of second strings
+ * @param num number of second strings
+ * @param out array of kernel values
+ */
+void kern_spectrum_compare_batch(hmeasure_t *m, hstring_t x, hstring_t *ys,
+                                 int num, float *out)
 {
-    float k = kernel(x, y);
-    return knorm(n, k, x, y, kernel);
+    param_t *p = m->param;
+    int i, xn, yn, len = p->len;
+    uint64_t *xh, *yh;
+
+    xh = extract_kmers(x, len, &xn);
+    for (i = 0; i < num; i++) {
+        if (x.len >= len && ys[i].len >= len &&
+            hstring_sig_disjoint(x, ys[i], len)) {
+            out[i] = 0;
+            continue;
+        }
+
+        scratch_mark_t mark = scratch_mark();
+
+        out[i] = 0;
+        if (x.len >= len && ys[i].len >= len) {
+            yh = extract_kmers(ys[i], len, &yn);
+            out[i] = spectrum(xh, xn, yh, yn);
+        }
+        out[i] = knorm(m, p->n, out[i], x, ys[i], kernel);
+        scratch_release(mark);
+    }
+}
+
+/**
+ * Compare two postings by key and index of string
+ * @param a First posting
+ * @param b Second posting
+ * @return order of postings
+ */
+static int cmp_posting(const void *a, const void *b)
+{
+    const posting_t *x = a, *y = b;
+
+    if (x->key != y->key)
+        return x->key < y->key ? -1 : 1;
+    return x->id - y->id;
+}
+
+/**
+ * Build an inverted index of the k-mers of the column strings. The
+ * postings of a k-mer are stored consecutively and sorted by string.
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param len Length of k-mers
+ * @param num Number of postings (output)
+ * @return postings (to be freed)
+ */
+static posting_t *index_create(hmatrix_t *m, hstring_t *s, int len,
+                               long *num)
+{
+    int cn = m->col.end - m->col.start;
+    long *offs, total = 0, k;
+    posting_t *idx;
+
+    offs = malloc((cn + 1) * sizeof(long));
+    if (!offs)
+        fatal("Could not allocate memory for k-mer index");
+
+    for (int c = 0; c < cn; c++) {
+        offs[c] = total;
+        total += MAX(s[m->col.start + c].len - len + 1, 0);
+    }
+    offs[cn] = total;
+
+    idx = malloc(MAX(total, 1) * sizeof(posting_t));
+    if (!idx)
+        fatal("Could not allocate memory for k-mer index");
+
+    /* Count the k-mers of each string in parallel */
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int c = 0; c < cn; c++) {
+        scratch_mark_t mark = scratch_mark();
+        posting_t *p = idx + offs[c];
+        uint64_t *xh;
+        int xn, j = 0;
+
+        xh = extract_kmers(s[m->col.start + c], len, &xn);
+        for (int i = 0; i < xn; i++) {
+            if (j > 0 && p[j - 1].key == xh[i]) {
+                p[j - 1].cnt++;
+                continue;
+            }
+            p[j].key = xh[i];
+            p[j].id = m->col.start + c;
+            p[j++].cnt = 1;
+        }
+
+        /* Mark unused entries */
+        for (; j < xn; j++)
+            p[j].id = -1;
+        scratch_release(mark);
+    }
+
+    /* Compact and sort postings */
+    for (k = 0, *num = 0; k < total; k++)
+        if (idx[k].id >= 0)
+            idx[(*num)++] = idx[k];
+    qsort(idx, *num, sizeof(posting_t), cmp_posting);
+
+    free(offs);
+    return idx;
+}
+
+/**
+ * Find the first posting of a k-mer
+ * @param idx Inverted index
+ * @param n Number of postings
+ * @param key Hash of k-mer
+ * @return position of first posting or n if not found
+ */
+static long index_find(posting_t *idx, long n, uint64_t key)
+{
+    long lo = 0, hi = n;
+
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (idx[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo < n && idx[lo].key == key ? lo : n;
+}
+
+/**
+ * Compute the spectrum kernel for all pairs of a matrix. The k-mers of
+ * the column strings are stored in an inverted index and the kernel
+ * values of a row are accumulated by walking the postings of its k-mers.
+ * Pairs without shared k-mers are never visited. The values are
+ * accumulated in the same order as in the pairwise comparison and are
+ * thus identical.
+ * @param hm Instance of measure
+ * @param m Matrix object
+ * @param s Array of strings
+ */
+void kern_spectrum_compare_all(hmeasure_t *hm, hmatrix_t *m, hstring_t *s)
+{
+    param_t *p = hm->param;
+    int cn = m->col.end - m->col.start;
+    int lo = MIN(m->col.start, m->row.start);
+    int hi = MAX(m->col.end, m->row.end);
+    float *self = NULL;
+    posting_t *idx;
+    long num;
+
+    idx = index_create(m, s, p->len, &num);
+    info_msg(1, "Indexed %ld k-mer postings of %d strings.", num, cn);
+
+    /* Kernel values of strings with themselves for normalization */
+    if (p->n == KN_L2) {
+        self = malloc((hi - lo) * sizeof(float));
+        if (!self)
+            fatal("Could not allocate memory for normalization");
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+        for (int i = lo; i < hi; i++) {
+            scratch_mark_t mark = scratch_mark();
+            self[i - lo] = kernel(hm, s[i], s[i]);
+            scratch_release(mark);
+        }
+    }
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        float *acc = malloc(MAX(cn, 1) * sizeof(float));
+        if (!acc)
+            fatal("Could not allocate memory for spectrum kernel");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+        for (int r = m->row.start; r < m->row.end; r++) {
+            scratch_mark_t mark = scratch_mark();
+            uint64_t *yh;
+            int yn;
+
+            memset(acc, 0, cn * sizeof(float));
+            yh = extract_kmers(s[r], p->len, &yn);
+
+            /* Accumulate products of counts over shared k-mers */
+            for (int i = 0; i < yn;) {
+                uint64_t h = yh[i];
+                float yc = 0;
+                long e;
+
+                for (; i < yn && yh[i] == h; i++)
+                    yc++;
+
+                e = index_find(idx, num, h);
+                for (; e < num && idx[e].key == h; e++)
+                    acc[idx[e].id - m->col.start] += idx[e].cnt * yc;
+            }
+            scratch_release(mark);
+
+            for (int c = m->col.start; c < m->col.end; c++) {
+                float k = acc[c - m->col.start];
+
+                /* Lower triangle is stored with the upper triangle */
+                if (m->triangular && r < c)
+                    continue;
+                if (!isnan(hmatrix_get(m, c, r)))
+                    continue;
+
+                if (self)
+                    k = k / sqrt(self[c - lo] * self[r - lo]);
+                hmatrix_set(m, c, r, k);
+            }
+        }
+        free(acc);
+    }
+
+    free(idx);
+    free(self);
 }
 
 /** @} */
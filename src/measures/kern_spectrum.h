@@ -13,9 +13,14 @@
 #define KERN_SPECTRUM_H
 
 #include "hstring.h"
+#include "measures.h"
+#include "hmatrix.h"
 
 /* Module interface */
-void kern_spectrum_config();
-float kern_spectrum_compare(hstring_t, hstring_t);
+void kern_spectrum_config(hmeasure_t *);
+float kern_spectrum_compare(hmeasure_t *, hstring_t, hstring_t);
+void kern_spectrum_compare_batch(hmeasure_t *, hstring_t, hstring_t *, int,
+                                 float *);
+void kern_spectrum_compare_all(hmeasure_t *, hmatrix_t *, hstring_t *);
 
 #endif /* KERN_SPECTRUM_H */
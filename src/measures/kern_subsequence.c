@@ -15,6 +15,7 @@
 #include "vcache.h"
 #include "norm.h"
 #include "kern_subsequence.h"
+#include "scratch.h"
 
 /**
  * @addtogroup measures
@@ -27,29 +28,36 @@
  * @{
  */
 
-/* External variables */
-extern config_t cfg;
-
-/* Normalizations */
-static knorm_t n = KN_NONE;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    knorm_t n;                  /**< Normalization */
+    cfg_int length;             /**< Maximum length */
+    double lambda;              /**< Weight for gaps */
+} param_t;
 
-/* Local variables */
-static cfg_int length = 3;     /**< Maximum length */
-static double lambda = 0.1;    /**< Weight for gaps */
+/* Default parameters */
+static const param_t defaults = { KN_NONE, 3, 0.1 };
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void kern_subsequence_config()
+void kern_subsequence_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
-    config_lookup_int(&cfg, "measures.kern_subsequence.length", &length);
-    config_lookup_float(&cfg, "measures.kern_subsequence.lambda", &lambda);
+    config_lookup_int(m->cfg, "measures.kern_subsequence.length",
+                      &p->length);
+    config_lookup_float(m->cfg, "measures.kern_subsequence.lambda",
+                        &p->lambda);
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.kern_subsequence.norm", &str);
-    n = knorm_get(str);
+    config_lookup_string(m->cfg, "measures.kern_subsequence.norm", &str);
+    p->n = knorm_get(str);
 }
 
 
@@ -59,12 +67,16 @@ void kern_subsequence_config()
 
 /**
  * Internal computation of subsequence kernel
+ * @param m Instance of measure
  * @param x first string
  * @param y second string
  * @return subsequence kernel
  */
-static float kernel(hstring_t x, hstring_t y)
+static float kernel(hmeasure_t *m, hstring_t x, hstring_t y)
 {
+    param_t *p = m->param;
+    cfg_int length = p->length;
+    double lambda = p->lambda;
     float *dps, *dp;
     float kern[length];
     int i, j, l;
@@ -78,8 +90,8 @@ static float kernel(hstring_t x, hstring_t y)
         return 0.0;
 
     /* Allocate temporary memory */
-    dp = malloc(sizeof(float) * (x.len + 1) * (y.len + 1));
-    dps = malloc(sizeof(float) * x.len * y.len);
+    dp = scratch_alloc(sizeof(float) * (x.len + 1) * (y.len + 1));
+    dps = scratch_alloc(sizeof(float) * x.len * y.len);
     if (!dp || !dps) {
         error("Could not allocate memory for subsequence kernel");
         return 0;
@@ -113,24 +125,23 @@ static float kernel(hstring_t x, hstring_t y)
             }
         }
     }
-    
-    free(dps);
-    free(dp);
-    
+
     return kern[length - 1];
 }
 
 /**
  * Compute the subsequence kernel by Lodhi et al. (2002). The implementation
  * has been taken from the book by Cristianini & Shawe-Taylor.
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return subsequence kernel
  */
-float kern_subsequence_compare(hstring_t x, hstring_t y)
+float kern_subsequence_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
-    float k = kernel(x, y);
-    return knorm(n, k, x, y, kernel);
+    param_t *p = m->param;
+    float k = kernel(m, x, y);
+    return knorm(m, p->n, k, x, y, kernel);
 }
 
 /** @} */
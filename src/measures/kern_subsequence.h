@@ -13,9 +13,10 @@
 #define KERN_SUBSEQUENCE_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void kern_subsequence_config();
-float kern_subsequence_compare(hstring_t, hstring_t);
+void kern_subsequence_config(hmeasure_t *);
+float kern_subsequence_compare(hmeasure_t *, hstring_t, hstring_t);
 
 #endif /* KERN_SUBSEQUENCE_H */
@@ -27,29 +27,34 @@
  * @{
  */
 
-/* External variables */
-extern config_t cfg;
-
-/* Normalizations */
-static knorm_t n = KN_NONE;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    knorm_t n;                  /**< Normalization */
+    cfg_int degree;             /**< Degree of kernel */
+    cfg_int shift;              /**< Shift of kernel */
+} param_t;
 
-/* Local variables */
-static cfg_int degree = 3;         /**< Degree of kernel */
-static cfg_int shift = 0;          /**< Shift of kernel */
+/* Default parameters */
+static const param_t defaults = { KN_NONE, 3, 0 };
 
 /**
  * Initializes the similarity measure
+ * @param m Instance of measure
  */
-void kern_wdegree_config()
+void kern_wdegree_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
-    config_lookup_int(&cfg, "measures.kern_wdegree.degree", &degree);
-    config_lookup_int(&cfg, "measures.kern_wdegree.shift", &shift);
+    config_lookup_int(m->cfg, "measures.kern_wdegree.degree", &p->degree);
+    config_lookup_int(m->cfg, "measures.kern_wdegree.shift", &p->shift);
 
     /* Normalization */
-    config_lookup_string(&cfg, "measures.kern_wdegree.norm", &str);
-    n = knorm_get(str);
+    config_lookup_string(m->cfg, "measures.kern_wdegree.norm", &str);
+    p->n = knorm_get(str);
 }
 
 /**
@@ -74,6 +79,7 @@ static float weight(float len, int degree)
 
 /**
  * Implementation of weighted-degree kernel in block mode.
+ * @param degree Degree of kernel
  * @param x String x
  * @param y String y
  * @param xs Shift for x 
@@ -81,7 +87,8 @@ static float weight(float len, int degree)
  * @param len Length of region to match
  * @return kernel value
  */
-static float kern_wdegree(hstring_t x, hstring_t y, int xs, int ys, int len)
+static float kern_wdegree(int degree, hstring_t x, hstring_t y, int xs,
+                          int ys, int len)
 {
     int i, start;
     float k = 0;
@@ -110,23 +117,25 @@ static float kern_wdegree(hstring_t x, hstring_t y, int xs, int ys, int len)
 
 /** 
  * Internal computation of weighted-degree kernel with shift
+ * @param m Instance of measure
  * @param x first string
  * @param y second string
  * @return weighted-degree kernel
  */
-static float kernel(hstring_t x, hstring_t y)
+static float kernel(hmeasure_t *m, hstring_t x, hstring_t y)
 {
+    param_t *p = m->param;
     float k = 0;
     int s, len;
 
     /* Loop over shifts */
-    for (s = -shift; s <= shift; s++) {
+    for (s = -p->shift; s <= p->shift; s++) {
         if (s <= 0) {
             len = fmax(fmin(x.len, y.len + s), 0);
-            k += kern_wdegree(x, y, 0, -s, len);
+            k += kern_wdegree(p->degree, x, y, 0, -s, len);
         } else {
             len = fmax(fmin(x.len - s, y.len), 0);
-            k += kern_wdegree(x, y, +s, 0, len);
+            k += kern_wdegree(p->degree, x, y, +s, 0, len);
         }
     }
 
@@ -138,14 +147,16 @@ static float kernel(hstring_t x, hstring_t y)
  * Compute the weighted-degree kernel with shift. If the strings have
  * unequal size, the remaining symbols of the longer string are ignored (in
  * accordance with the kernel definition)
+ * @param m Instance of measure
  * @param x first string 
  * @param y second string
  * @return weighted-degree kernel
  */
-float kern_wdegree_compare(hstring_t x, hstring_t y)
+float kern_wdegree_compare(hmeasure_t *m, hstring_t x, hstring_t y)
 {
-    float k = kernel(x, y);
-    return knorm(n, k, x, y, kernel);
+    param_t *p = m->param;
+    float k = kernel(m, x, y);
+    return knorm(m, p->n, k, x, y, kernel);
 }
 
 /** @} */
@@ -13,9 +13,10 @@
 #define KERN_WDEGREE_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Module interface */
-void kern_wdegree_config();
-float kern_wdegree_compare(hstring_t, hstring_t);
+void kern_wdegree_config(hmeasure_t *);
+float kern_wdegree_compare(hmeasure_t *, hstring_t, hstring_t);
 
 #endif /* KERN_WDEGREE_H */
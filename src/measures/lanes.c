@@ -0,0 +1,173 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "lanes.h"
+#include "scratch.h"
+
+/**
+ * @addtogroup measures
+ * <hr>
+ * <em>lanes</em>: Inter-pair vectorization of measures.
+ *
+ * Short strings are compared with one string against many others, where
+ * each lane of a vector holds one pair of strings. Vectors with 8-bit
+ * lanes are used if all values of a pair fit into 8 bits and 16-bit lanes
+ * otherwise. Longer strings, tokens and bits are left to the scalar
+ * implementations. The kernels use the vector extensions of GCC and
+ * Clang, which are mapped to the instruction set of the target.
+ * @{
+ */
+
+#ifdef HAVE_VECTOR_EXT
+
+/* Type of a kernel */
+typedef void (*kernel_t) (hstring_t, hstring_t *, int, float *);
+
+/* Vector types */
+typedef uint8_t v8_t __attribute__ ((vector_size(LANES_WIDTH)));
+typedef uint16_t v16_t __attribute__ ((vector_size(LANES_WIDTH)));
+
+/* Scratch memory is aligned for vectors */
+#define lanes_alloc(n)  scratch_alloc(MAX((n), 1) * LANES_WIDTH)
+
+/* Kernels with 8-bit lanes */
+#define LANE_T          uint8_t
+#define VEC_T           v8_t
+#define LANES           (LANES_WIDTH / 1)
+#define FN(x)           lanes8_ ## x
+#include "lanes_tmpl.h"
+#undef LANE_T
+#undef VEC_T
+#undef LANES
+#undef FN
+
+/* Kernels with 16-bit lanes */
+#define LANE_T          uint16_t
+#define VEC_T           v16_t
+#define LANES           (LANES_WIDTH / 2)
+#define FN(x)           lanes16_ ## x
+#include "lanes_tmpl.h"
+#undef LANE_T
+#undef VEC_T
+#undef LANES
+#undef FN
+
+/**
+ * Compare a string with an array of strings using vectorized kernels.
+ * The strings are grouped by the width of lanes they require. Values that
+ * cannot be computed by the kernels are set to NAN.
+ * @param x String
+ * @param y Array of strings
+ * @param n Number of strings
+ * @param out Array of values
+ * @param k8 Kernel with 8-bit lanes
+ * @param k16 Kernel with 16-bit lanes
+ * @return true if vectors have been used, false otherwise
+ */
+static int lanes_run(hstring_t x, hstring_t *y, int n, float *out,
+                     kernel_t k8, kernel_t k16)
+{
+    hstring_t g8[LANES_WIDTH], g16[LANES_WIDTH / 2];
+    int i8[LANES_WIDTH], i16[LANES_WIDTH / 2];
+    float v[LANES_WIDTH];
+    int i, l, n8 = 0, n16 = 0, len;
+
+    if (x.type != TYPE_BYTE)
+        return FALSE;
+
+    for (i = 0; i < n; i++) {
+        out[i] = NAN;
+        if (y[i].type != TYPE_BYTE)
+            continue;
+
+        /* Lengths bound all values of the kernels */
+        len = MAX(x.len, y[i].len);
+        if (len < UINT8_MAX) {
+            g8[n8] = y[i];
+            i8[n8++] = i;
+        } else if (len < UINT16_MAX) {
+            g16[n16] = y[i];
+            i16[n16++] = i;
+        }
+
+        if (n8 == LANES_WIDTH || (i == n - 1 && n8 > 0)) {
+            k8(x, g8, n8, v);
+            for (l = 0; l < n8; l++)
+                out[i8[l]] = v[l];
+            n8 = 0;
+        }
+        if (n16 == LANES_WIDTH / 2 || (i == n - 1 && n16 > 0)) {
+            k16(x, g16, n16, v);
+            for (l = 0; l < n16; l++)
+                out[i16[l]] = v[l];
+            n16 = 0;
+        }
+    }
+
+    return TRUE;
+}
+#endif
+
+/**
+ * Compute Levenshtein distances with unit costs
+ * @param x String
+ * @param y Array of strings
+ * @param n Number of strings
+ * @param out Array of distances (NAN if not computed)
+ * @return true if vectors have been used, false otherwise
+ */
+int lanes_levenshtein(hstring_t x, hstring_t *y, int n, float *out)
+{
+#ifdef HAVE_VECTOR_EXT
+    return lanes_run(x, y, n, out, lanes8_levenshtein, lanes16_levenshtein);
+#else
+    return FALSE;
+#endif
+}
+
+/**
+ * Compute Hamming distances
+ * @param x String
+ * @param y Array of strings
+ * @param n Number of strings
+ * @param out Array of distances (NAN if not computed)
+ * @return true if vectors have been used, false otherwise
+ */
+int lanes_hamming(hstring_t x, hstring_t *y, int n, float *out)
+{
+#ifdef HAVE_VECTOR_EXT
+    return lanes_run(x, y, n, out, lanes8_hamming, lanes16_hamming);
+#else
+    return FALSE;
+#endif
+}
+
+/**
+ * Compute Jaro distances
+ * @param x String
+ * @param y Array of strings
+ * @param n Number of strings
+ * @param out Array of distances (NAN if not computed)
+ * @return true if vectors have been used, false otherwise
+ */
+int lanes_jaro(hstring_t x, hstring_t *y, int n, float *out)
+{
+#ifdef HAVE_VECTOR_EXT
+    return lanes_run(x, y, n, out, lanes8_jaro, lanes16_jaro);
+#else
+    return FALSE;
+#endif
+}
+
+/** @} */
@@ -0,0 +1,28 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef LANES_H
+#define LANES_H
+
+#include "hstring.h"
+
+/* Width of vectors in bytes, e.g. 16 lanes of 8 bit or 8 lanes of 16 bit */
+#ifdef __AVX2__
+#define LANES_WIDTH     32
+#else
+#define LANES_WIDTH     16
+#endif
+
+int lanes_levenshtein(hstring_t, hstring_t *, int, float *);
+int lanes_hamming(hstring_t, hstring_t *, int, float *);
+int lanes_jaro(hstring_t, hstring_t *, int, float *);
+
+#endif /* LANES_H */
@@ -0,0 +1,219 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/*
+ * Template of the inter-pair kernels. This file is included by lanes.c
+ * once for each width of lanes with LANE_T, VEC_T, LANES and FN defined.
+ * Each kernel compares one string x with up to LANES strings y and stores
+ * the unnormalized values in out.
+ */
+
+/**
+ * Transpose strings, such that the i-th vector holds the i-th byte of
+ * each string. Lanes beyond the end of a string are zero and strings are
+ * truncated to the number of vectors.
+ * @param t Array of vectors
+ * @param y Strings
+ * @param n Number of strings
+ * @param len Number of vectors
+ */
+static void FN(transpose) (VEC_T *t, hstring_t *y, int n, int len)
+{
+    int i, l;
+
+    memset(t, 0, len * sizeof(VEC_T));
+    for (l = 0; l < n; l++)
+        for (i = 0; i < MIN(y[l].len, len); i++)
+            t[i][l] = (unsigned char) y[l].str.c[i];
+}
+
+/**
+ * Broadcast the bytes of a string to vectors
+ * @param t Array of vectors
+ * @param x String
+ */
+static void FN(broadcast) (VEC_T *t, hstring_t x)
+{
+    VEC_T zero = { 0 };
+    int i;
+
+    for (i = 0; i < x.len; i++)
+        t[i] = zero + (LANE_T) (unsigned char) x.str.c[i];
+}
+
+/**
+ * Levenshtein distance with unit costs. The matrix is computed column by
+ * column for all lanes and the last row is taken from each lane when
+ * the end of its string is reached.
+ * @param x String
+ * @param y Strings
+ * @param n Number of strings
+ * @param out Distances
+ */
+static void FN(levenshtein) (hstring_t x, hstring_t *y, int n, float *out)
+{
+    VEC_T zero = { 0 }, one = zero + 1, len = zero, res, d, u, v, m;
+    VEC_T *col, *xv, *yt;
+    int i, j, l, max = 0;
+
+    for (l = 0; l < n; l++) {
+        len[l] = y[l].len;
+        max = MAX(max, y[l].len);
+    }
+
+    col = lanes_alloc(2 * x.len + 1 + max);
+    if (!col) {
+        for (l = 0; l < n; l++)
+            out[l] = NAN;
+        return;
+    }
+    xv = col + x.len + 1;
+    yt = xv + x.len;
+
+    FN(broadcast) (xv, x);
+    FN(transpose) (yt, y, n, max);
+
+    for (i = 0; i <= x.len; i++)
+        col[i] = zero + (LANE_T) i;
+    res = (VEC_T) (len == zero) & col[x.len];
+
+    for (j = 1; j <= max; j++) {
+        d = col[0];
+        col[0] = zero + (LANE_T) j;
+        for (i = 1; i <= x.len; i++) {
+            u = col[i];
+            m = (VEC_T) (u < col[i - 1]);
+            u = ((u & m) | (col[i - 1] & ~m)) + one;
+            v = d + ((VEC_T) (xv[i - 1] != yt[j - 1]) & one);
+            m = (VEC_T) (u < v);
+            d = col[i];
+            col[i] = (u & m) | (v & ~m);
+        }
+
+        /* Take distances of strings ending at this column */
+        m = (VEC_T) (len == zero + (LANE_T) j);
+        res = (res & ~m) | (col[x.len] & m);
+    }
+
+    for (l = 0; l < n; l++)
+        out[l] = res[l];
+}
+
+/**
+ * Hamming distance. Symbols of the longer string without counterpart are
+ * considered mismatches.
+ * @param x String
+ * @param y Strings
+ * @param n Number of strings
+ * @param out Distances
+ */
+static void FN(hamming) (hstring_t x, hstring_t *y, int n, float *out)
+{
+    VEC_T zero = { 0 }, len = zero, res = zero;
+    VEC_T *yt;
+    int i, l, max = 0;
+
+    for (l = 0; l < n; l++) {
+        len[l] = y[l].len;
+        max = MAX(max, y[l].len);
+    }
+    max = MIN(max, x.len);
+
+    yt = lanes_alloc(max);
+    if (!yt) {
+        for (l = 0; l < n; l++)
+            out[l] = NAN;
+        return;
+    }
+    FN(transpose) (yt, y, n, max);
+
+    /* Comparisons yield -1 in matching lanes */
+    for (i = 0; i < max; i++)
+        res -= (VEC_T) (yt[i] != zero + (LANE_T) (unsigned char) x.str.c[i])
+            & (VEC_T) (len > zero + (LANE_T) i);
+
+    for (l = 0; l < n; l++)
+        out[l] = res[l] + abs(y[l].len - x.len);
+}
+
+/**
+ * Jaro distance. The earliest-position assignment of common characters
+ * is carried out in all lanes at once. As in the scalar implementation,
+ * the shorter string of each pair is scanned for matches.
+ * @param x String
+ * @param y Strings
+ * @param n Number of strings
+ * @param out Distances
+ */
+static void FN(jaro) (hstring_t x, hstring_t *y, int n, float *out)
+{
+    VEC_T zero = { 0 }, slen = zero, half = zero, to = zero;
+    VEC_T match = zero, trans = zero, cnt = zero, found, c, m, *st, *tt, *idx;
+    hstring_t s[LANES], t[LANES];
+    int i, j, l, smax = 0, tmax = 0, hmax = 0, imax = 0;
+
+    /* Make the first string of each pair the shorter one */
+    for (l = 0; l < n; l++) {
+        s[l] = x.len > y[l].len ? y[l] : x;
+        t[l] = x.len > y[l].len ? x : y[l];
+        slen[l] = s[l].len;
+        half[l] = (s[l].len + 1) / 2;
+        to[l] = MIN(s[l].len + half[l], t[l].len);
+        smax = MAX(smax, s[l].len);
+        tmax = MAX(tmax, t[l].len);
+        hmax = MAX(hmax, half[l]);
+        imax = MAX(imax, to[l]);
+    }
+
+    st = lanes_alloc(2 * smax + tmax);
+    if (!st) {
+        for (l = 0; l < n; l++)
+            out[l] = NAN;
+        return;
+    }
+    idx = st + smax;
+    tt = idx + smax;
+
+    FN(transpose) (st, s, n, smax);
+    FN(transpose) (tt, t, n, tmax);
+    memset(idx, 0, smax * sizeof(VEC_T));
+
+    /* Assign common characters within the allowed range */
+    for (i = 0; i < imax; i++) {
+        found = (VEC_T) (to <= zero + (LANE_T) i);
+        for (j = MAX(0, i - hmax); j < MIN(smax, i + hmax + 1); j++) {
+            c = (VEC_T) (st[j] == tt[i]) & (VEC_T) (idx[j] == zero) &
+                (VEC_T) (half >= zero + (LANE_T) abs(i - j)) &
+                (VEC_T) (slen > zero + (LANE_T) j) & ~found;
+            match -= c;
+            idx[j] |= match & c;
+            found |= c;
+        }
+    }
+
+    /* Count transpositions */
+    for (j = 0; j < smax; j++) {
+        m = (VEC_T) (idx[j] != zero);
+        cnt -= m;
+        trans -= m & (VEC_T) (idx[j] != cnt);
+    }
+
+    for (l = 0; l < n; l++) {
+        float md = (float) match[l];
+        if (s[l].len == 0)
+            out[l] = t[l].len == 0 ? 0.0 : 1.0;
+        else if (match[l] == 0)
+            out[l] = 1.0;
+        else
+            out[l] = 1.0 - (md / s[l].len + md / t[l].len + 1.0 -
+                            (int) trans[l] / md / 2.0) / 3.0;
+    }
+}
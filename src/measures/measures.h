@@ -13,6 +13,25 @@
 #define MEASURES_H
 
 #include "hstring.h"
+#include "hmatrix.h"
+#include "vcache.h"
+
+/**
+ * Instance of a similarity measure. An instance holds the selected
+ * measure with its parameters together with the configuration, the value
+ * cache and the settings of preprocessing it uses. Several instances can
+ * be used at the same time.
+ */
+typedef struct hmeasure
+{
+    int idx;                    /**< Index of measure */
+    config_t *cfg;              /**< Configuration */
+    vcache_t *cache;            /**< Value cache */
+    hprep_t *prep;              /**< Settings of preprocessing */
+    cfg_int global_cache;       /**< Flag for global cache */
+    void *param;                /**< Parameters of measure */
+    struct hmeasure *sub;       /**< Nested measure or NULL */
+} hmeasure_t;
 
 /**
  * Structure for measure interface
@@ -22,15 +41,36 @@ typedef struct
     /** Name of measure */
     char *name;
     /** Init function */
-    void (*measure_config) ();
+    void (*measure_config) (hmeasure_t *);
     /** Comparison function */
-    float (*measure_compare) (hstring_t, hstring_t);
+    float (*measure_compare) (hmeasure_t *, hstring_t, hstring_t);
+    /** Comparison of one string with several strings (optional) */
+    void (*measure_compare_batch) (hmeasure_t *, hstring_t, hstring_t *,
+                                   int, float *);
+    /** Computation of a full matrix (optional) */
+    void (*measure_compare_all) (hmeasure_t *, hmatrix_t *, hstring_t *);
 } measure_t;
 
 /* Module functions */
 int measure_match(const char *);
 char *measure_config(const char *);
 double measure_compare(hstring_t, hstring_t);
+void measure_compare_batch(hstring_t, hstring_t *, int, float *);
+int measure_compare_all(hmatrix_t *, hstring_t *);
 void measure_fprint(FILE *);
+hmeasure_t *measure_default();
+
+/* Reentrant versions */
+void measure_init_r(hmeasure_t *, config_t *, vcache_t *, hprep_t *);
+char *measure_config_r(hmeasure_t *, const char *);
+double measure_compare_r(hmeasure_t *, hstring_t, hstring_t);
+void measure_compare_batch_r(hmeasure_t *, hstring_t, hstring_t *, int,
+                             float *);
+int measure_compare_all_r(hmeasure_t *, hmatrix_t *, hstring_t *);
+void measure_destroy_r(hmeasure_t *);
+
+/* Functions for measure modules */
+void *measure_param(hmeasure_t *, const void *, size_t);
+hmeasure_t *measure_nested(hmeasure_t *, const char *);
 
 #endif /* MEASURES_H */
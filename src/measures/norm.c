@@ -82,7 +82,9 @@ knorm_t knorm_get(const char *str)
 }
 
 /**
- * Normalize a similarity value using a kernel function
+ * Normalize a similarity value using a kernel function. The values of
+ * the kernel for the strings themselves are cached.
+ * @param m Instance of measure
  * @param n Normalization type
  * @param k Similarity value
  * @param x String
@@ -90,8 +92,8 @@ knorm_t knorm_get(const char *str)
  * @param kernel Kernel function
  * @return Normalized similarity value
  */
-float knorm(knorm_t n, float k, hstring_t x, hstring_t y,
-            float (*kernel) (hstring_t, hstring_t))
+float knorm(hmeasure_t *m, knorm_t n, float k, hstring_t x, hstring_t y,
+            float (*kernel) (hmeasure_t *, hstring_t, hstring_t))
 {
     uint64_t xk, yk;
     float xv, yv;
@@ -100,15 +102,15 @@ float knorm(knorm_t n, float k, hstring_t x, hstring_t y,
     switch (n) {
     case KN_L2:
         xk = hstring_hash1(x);
-        if (!vcache_load(xk, &xv, ID_NORM)) {
-            xv = kernel(x, x);
-            vcache_store(xk, xv, ID_NORM);
+        if (!vcache_load_r(m->cache, xk, &xv, ID_NORM)) {
+            xv = kernel(m, x, x);
+            vcache_store_r(m->cache, xk, xv, ID_NORM);
         }
 
         yk = hstring_hash1(y);
-        if (!vcache_load(yk, &yv, ID_NORM)) {
-            yv = kernel(y, y);
-            vcache_store(yk, yv, ID_NORM);
+        if (!vcache_load_r(m->cache, yk, &yv, ID_NORM)) {
+            yv = kernel(m, y, y);
+            vcache_store_r(m->cache, yk, yv, ID_NORM);
         }
         return k / sqrt(xv * yv);
     case KN_NONE:
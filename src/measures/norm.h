@@ -13,6 +13,7 @@
 #define NORM_H
 
 #include "hstring.h"
+#include "measures.h"
 
 /* Length normalizations */
 typedef enum
@@ -34,7 +35,7 @@ typedef enum
 } knorm_t;
 
 knorm_t knorm_get(const char *str);
-float knorm(knorm_t n, float k, hstring_t x, hstring_t y,
-            float (*kernel) (hstring_t, hstring_t));
+float knorm(hmeasure_t *m, knorm_t n, float k, hstring_t x, hstring_t y,
+            float (*kernel) (hmeasure_t *, hstring_t, hstring_t));
 
 #endif /* NORM_H */
@@ -15,6 +15,17 @@
 #include "uthash.h"
 
 #include "sim_coefficient.h"
+#include "scratch.h"
+
+/* Hash tables are allocated from scratch memory */
+#undef uthash_tbl_malloc
+#undef uthash_tbl_free
+#undef uthash_bkt_malloc
+#undef uthash_bkt_free
+#define uthash_tbl_malloc(sz)   scratch_alloc(sz)
+#define uthash_tbl_free(ptr)
+#define uthash_bkt_malloc(sz)   scratch_alloc(sz)
+#define uthash_bkt_free(ptr)
 
 /**
  * @addtogroup measures
@@ -36,27 +47,40 @@ typedef struct
     UT_hash_handle hh;  /**< uthash handle */
 } bag_t;
 
-/* Local variables */
-static int binary = FALSE;
+/**
+ * Parameters of the measure
+ */
+typedef struct
+{
+    int binary;                 /**< Flag for binary matching */
+} param_t;
 
-/* External variables */
-extern config_t cfg;
+/* Default parameters */
+static const param_t defaults = { FALSE };
 
-void sim_coefficient_config()
+/**
+ * Initializes the similarity measure
+ * @param m Instance of measure
+ */
+void sim_coefficient_config(hmeasure_t *m)
 {
+    param_t *p = measure_param(m, &defaults, sizeof(param_t));
     const char *str;
 
     /* Matching */
-    config_lookup_string(&cfg, "measures.sim_coefficient.matching", &str);
+    config_lookup_string(m->cfg, "measures.sim_coefficient.matching", &str);
 
     if (!strcasecmp(str, "cnt")) {
-        binary = FALSE;
+        p->binary = FALSE;
     } else if (!strcasecmp(str, "bin")) {
-        binary = TRUE;
+        p->binary = TRUE;
     } else {
         warning("Unknown matching '%s'. Using 'cnt' instead.", str);
-        binary = FALSE;
+        p->binary = FALSE;
     }
+
+    /* Signatures of symbols */
+    hstring_sig_config_r(m->prep, 1);
 }
 
 /**
@@ -73,7 +97,7 @@ static bag_t *bag_create(hstring_t x)
         HASH_FIND(hh, xh, &s, sizeof(sym_t), bag);
 
         if (!bag) {
-            bag = malloc(sizeof(bag_t));
+            bag = scratch_alloc(sizeof(bag_t));
             bag->sym = s;
             bag->cnt = 0;
             HASH_ADD(hh, xh, sym, sizeof(sym_t), bag);
@@ -85,27 +109,14 @@ static bag_t *bag_create(hstring_t x)
     return xh;
 }
 
-/** 
- * Free the memory of histogram
- * @param xh Histogram
- */
-static void bag_destroy(bag_t * xh)
-{
-    /* Clear hash table */
-    while (xh) {
-        bag_t *bag = xh;
-        HASH_DEL(xh, bag);
-        free(bag);
-    }
-}
-
 /**
  * Computes the matches and mismatches
+ * @param binary Flag for binary matching
  * @param x first string 
  * @param y second string
  * @return matches
  */
-static match_t match(hstring_t x, hstring_t y)
+static match_t match(int binary, hstring_t x, hstring_t y)
 {
     bag_t *xh, *yh, *xb, *yb;
     match_t m;
@@ -148,20 +159,16 @@ static match_t match(hstring_t x, hstring_t y)
         m.c += missing;
     }
 
-    bag_destroy(xh);
-    bag_destroy(yh);
     return m;
 }
 
 /**
  * Computes the Jaccard coefficient 
- * @param x String x
- * @param y String y
+ * @param m Matches and mismatches
  * @return coefficient
  */
-float sim_jaccard_compare(hstring_t x, hstring_t y)
+static float coef_jaccard(match_t m)
 {
-    match_t m = match(x, y);
     if (m.b == 0 && m.c == 0)
         return 1;
 
@@ -170,13 +177,11 @@ float sim_jaccard_compare(hstring_t x, hstring_t y)
 
 /**
  * Computes the Simpson coefficient 
- * @param x String x
- * @param y String y
+ * @param m Matches and mismatches
  * @return coefficient
  */
-float sim_simpson_compare(hstring_t x, hstring_t y)
+static float coef_simpson(match_t m)
 {
-    match_t m = match(x, y);
     if (m.b == 0 && m.c == 0)
         return 1;
 
@@ -185,13 +190,11 @@ float sim_simpson_compare(hstring_t x, hstring_t y)
 
 /**
  * Computes the Braun-Blanquet coefficient 
- * @param x String x
- * @param y String y
+ * @param m Matches and mismatches
  * @return coefficient
  */
-float sim_braun_compare(hstring_t x, hstring_t y)
+static float coef_braun(match_t m)
 {
-    match_t m = match(x, y);
     if (m.b == 0 && m.c == 0)
         return 1;
 
@@ -200,13 +203,11 @@ float sim_braun_compare(hstring_t x, hstring_t y)
 
 /**
  * Computes the Dice efficient 
- * @param x String x
- * @param y String y
+ * @param m Matches and mismatches
  * @return coefficient
  */
-float sim_dice_compare(hstring_t x, hstring_t y)
+static float coef_dice(match_t m)
 {
-    match_t m = match(x, y);
     if (m.b == 0 && m.c == 0)
         return 1;
 
@@ -215,13 +216,11 @@ float sim_dice_compare(hstring_t x, hstring_t y)
 
 /**
  * Computes the Sokal-Sneath efficient 
- * @param x String x
- * @param y String y
+ * @param m Matches and mismatches
  * @return coefficient
  */
-float sim_sokal_compare(hstring_t x, hstring_t y)
+static float coef_sokal(match_t m)
 {
-    match_t m = match(x, y);
     if (m.b == 0 && m.c == 0)
         return 1;
 
@@ -230,13 +229,11 @@ float sim_sokal_compare(hstring_t x, hstring_t y)
 
 /**
  * Computes the Kulczynski (2nd) efficient 
- * @param x String x
- * @param y String y
+ * @param m Matches and mismatches
  * @return coefficient
  */
-float sim_kulczynski_compare(hstring_t x, hstring_t y)
+static float coef_kulczynski(match_t m)
 {
-    match_t m = match(x, y);
     if (m.b == 0 && m.c == 0)
         return 1;
 
@@ -245,18 +242,488 @@ float sim_kulczynski_compare(hstring_t x, hstring_t y)
 
 /**
  * Computes the Otsuka efficient 
- * @param x String x
- * @param y String y
+ * @param m Matches and mismatches
  * @return coefficient
  */
-float sim_otsuka_compare(hstring_t x, hstring_t y)
+static float coef_otsuka(match_t m)
 {
-    match_t m = match(x, y);
     if (m.b == 0 && m.c == 0)
         return 1;
 
     return m.a / sqrt((m.a + m.b) * (m.a + m.c));
 }
 
+/* Coefficients of the measures */
+static struct
+{
+    const char *name;
+    coef_t coef;
+} coefs[] = {
+    {"sim_jaccard", coef_jaccard},
+    {"sim_simpson", coef_simpson},
+    {"sim_braun", coef_braun},
+    {"sim_dice", coef_dice},
+    {"sim_sokal", coef_sokal},
+    {"sim_kulczynski", coef_kulczynski},
+    {"sim_otsuka", coef_otsuka},
+    {NULL, NULL}
+};
+
+/**
+ * Return the coefficient of a similarity measure. This allows to compute
+ * the coefficient from matches that have been determined otherwise.
+ * @param name Name of similarity measure
+ * @return coefficient or NULL if not found
+ */
+coef_t sim_coefficient_get(const char *name)
+{
+    for (int i = 0; coefs[i].name; i++)
+        if (!strcmp(coefs[i].name, name))
+            return coefs[i].coef;
+    return NULL;
+}
+
+/**
+ * Check whether binary matching is used
+ * @param m Instance of measure
+ * @return true if binary, false otherwise
+ */
+int sim_coefficient_binary(hmeasure_t *m)
+{
+    param_t *p = m->param;
+    return p->binary;
+}
+
+/**
+ * Computes a coefficient of two strings. Non-empty strings with disjoint
+ * signatures have no matches, for which all coefficients are zero.
+ * @param m Instance of measure
+ * @param x String x
+ * @param y String y
+ * @param coef Coefficient
+ * @return coefficient
+ */
+static float compare(hmeasure_t *m, hstring_t x, hstring_t y, coef_t coef)
+{
+    param_t *p = m->param;
+
+    if (x.len > 0 && y.len > 0 && hstring_sig_disjoint(x, y, 1))
+        return 0;
+
+    return coef(match(p->binary, x, y));
+}
+
+/**
+ * Computes the Jaccard coefficient
+ * @param m Instance of measure
+ * @param x String x
+ * @param y String y
+ * @return coefficient
+ */
+float sim_jaccard_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    return compare(m, x, y, coef_jaccard);
+}
+
+/**
+ * Computes the Simpson coefficient
+ * @param m Instance of measure
+ * @param x String x
+ * @param y String y
+ * @return coefficient
+ */
+float sim_simpson_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    return compare(m, x, y, coef_simpson);
+}
+
+/**
+ * Computes the Braun-Blanquet coefficient
+ * @param m Instance of measure
+ * @param x String x
+ * @param y String y
+ * @return coefficient
+ */
+float sim_braun_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    return compare(m, x, y, coef_braun);
+}
+
+/**
+ * Computes the Dice coefficient
+ * @param m Instance of measure
+ * @param x String x
+ * @param y String y
+ * @return coefficient
+ */
+float sim_dice_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    return compare(m, x, y, coef_dice);
+}
+
+/**
+ * Computes the Sokal-Sneath coefficient
+ * @param m Instance of measure
+ * @param x String x
+ * @param y String y
+ * @return coefficient
+ */
+float sim_sokal_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    return compare(m, x, y, coef_sokal);
+}
+
+/**
+ * Computes the Kulczynski (2nd) coefficient
+ * @param m Instance of measure
+ * @param x String x
+ * @param y String y
+ * @return coefficient
+ */
+float sim_kulczynski_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    return compare(m, x, y, coef_kulczynski);
+}
+
+/**
+ * Computes the Otsuka coefficient
+ * @param m Instance of measure
+ * @param x String x
+ * @param y String y
+ * @return coefficient
+ */
+float sim_otsuka_compare(hmeasure_t *m, hstring_t x, hstring_t y)
+{
+    return compare(m, x, y, coef_otsuka);
+}
+
+/**
+ * Entry of the inverted index of symbols
+ */
+typedef struct
+{
+    sym_t sym;                  /**< Symbol or character */
+    int id;                     /**< Index of string */
+    float cnt;                  /**< Count of symbol */
+} posting_t;
+
+/**
+ * Compare two symbols
+ * @param a First symbol
+ * @param b Second symbol
+ * @return order of symbols
+ */
+static int cmp_sym(const void *a, const void *b)
+{
+    sym_t x = *(const sym_t *) a, y = *(const sym_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * Compare two postings by symbol and index of string
+ * @param a First posting
+ * @param b Second posting
+ * @return order of postings
+ */
+static int cmp_posting(const void *a, const void *b)
+{
+    const posting_t *x = a, *y = b;
+
+    if (x->sym != y->sym)
+        return x->sym < y->sym ? -1 : 1;
+    return x->id - y->id;
+}
+
+/**
+ * Extract the distinct symbols of a string with their counts. The
+ * postings are allocated from scratch memory.
+ * @param x String
+ * @param id Index of string
+ * @param num Number of distinct symbols (output)
+ * @return postings sorted by symbol
+ */
+static posting_t *extract_syms(hstring_t x, int id, int *num)
+{
+    sym_t *syms = scratch_alloc(MAX(x.len, 1) * sizeof(sym_t));
+    posting_t *p = scratch_alloc(MAX(x.len, 1) * sizeof(posting_t));
+    int i, j = 0;
+
+    for (i = 0; i < x.len; i++)
+        syms[i] = hstring_get(x, i);
+    qsort(syms, x.len, sizeof(sym_t), cmp_sym);
+
+    for (i = 0; i < x.len; i++) {
+        if (j > 0 && p[j - 1].sym == syms[i]) {
+            p[j - 1].cnt++;
+            continue;
+        }
+        p[j].sym = syms[i];
+        p[j].id = id;
+        p[j++].cnt = 1;
+    }
+
+    *num = j;
+    return p;
+}
+
+/**
+ * Return the size of a string as used by the coefficients: the number
+ * of distinct symbols for binary matching and the number of symbols
+ * otherwise.
+ * @param m Instance of measure
+ * @param x String
+ * @return size of string
+ */
+float sim_coefficient_size(hmeasure_t *m, hstring_t x)
+{
+    param_t *p = m->param;
+    scratch_mark_t mark;
+    int num;
+
+    if (!p->binary)
+        return x.len;
+
+    mark = scratch_mark();
+    extract_syms(x, 0, &num);
+    scratch_release(mark);
+    return num;
+}
+
+/**
+ * Find the first posting of a symbol
+ * @param idx Inverted index
+ * @param n Number of postings
+ * @param sym Symbol
+ * @return position of first posting or n if not found
+ */
+static long index_find(posting_t *idx, long n, sym_t sym)
+{
+    long lo = 0, hi = n;
+
+    while (lo < hi) {
+        long mid = lo + (hi - lo) / 2;
+        if (idx[mid].sym < sym)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo < n && idx[lo].sym == sym ? lo : n;
+}
+
+/**
+ * Build an inverted index of the symbols of the column strings
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param num Number of postings (output)
+ * @return postings sorted by symbol (to be freed)
+ */
+static posting_t *index_create(hmatrix_t *m, hstring_t *s, long *num)
+{
+    int cn = m->col.end - m->col.start;
+    long *offs, total = 0, k;
+    posting_t *idx;
+
+    offs = malloc((cn + 1) * sizeof(long));
+    if (!offs)
+        fatal("Could not allocate memory for symbol index");
+
+    for (int c = 0; c < cn; c++) {
+        offs[c] = total;
+        total += s[m->col.start + c].len;
+    }
+    offs[cn] = total;
+
+    idx = malloc(MAX(total, 1) * sizeof(posting_t));
+    if (!idx)
+        fatal("Could not allocate memory for symbol index");
+
+    /* Count the symbols of each string in parallel */
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+    for (int c = 0; c < cn; c++) {
+        scratch_mark_t mark = scratch_mark();
+        int c0 = m->col.start + c, xn, j;
+        posting_t *p = extract_syms(s[c0], c0, &xn);
+
+        memcpy(idx + offs[c], p, xn * sizeof(posting_t));
+        for (j = xn; j < s[c0].len; j++)
+            idx[offs[c] + j].id = -1;
+        scratch_release(mark);
+    }
+
+    /* Compact and sort postings */
+    for (k = 0, *num = 0; k < total; k++)
+        if (idx[k].id >= 0)
+            idx[(*num)++] = idx[k];
+    qsort(idx, *num, sizeof(posting_t), cmp_posting);
+
+    free(offs);
+    return idx;
+}
+
+/**
+ * Compute a coefficient for all pairs of a matrix. The symbols of the
+ * column strings are stored in an inverted index and the number of
+ * matching symbols of a row is accumulated by walking the postings of its
+ * symbols. The mismatches follow from the sizes of the strings, such
+ * that no hash tables are built for pairs. The values are identical to
+ * pairwise comparisons.
+ * @param hm Instance of measure
+ * @param m Matrix object
+ * @param s Array of strings
+ * @param coef Coefficient or NULL for the number of matching symbols
+ */
+void sim_coefficient_compare_all(hmeasure_t *hm, hmatrix_t *m, hstring_t *s,
+                                 coef_t coef)
+{
+    param_t *p = hm->param;
+    int binary = p->binary;
+    int cn = m->col.end - m->col.start;
+    posting_t *idx;
+    float *sizes;
+    long num;
+
+    idx = index_create(m, s, &num);
+    info_msg(1, "Indexed %ld symbol postings of %d strings.", num, cn);
+
+    sizes = malloc(MAX(cn, 1) * sizeof(float));
+    if (!sizes)
+        fatal("Could not allocate memory for coefficients");
+    for (int c = 0; c < cn; c++)
+        sizes[c] = binary ? 0 : s[m->col.start + c].len;
+    if (binary)
+        for (long k = 0; k < num; k++)
+            sizes[idx[k].id - m->col.start]++;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+        float *acc = malloc(MAX(cn, 1) * sizeof(float));
+        if (!acc)
+            fatal("Could not allocate memory for coefficients");
+
+#ifdef HAVE_OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+        for (int r = m->row.start; r < m->row.end; r++) {
+            scratch_mark_t mark = scratch_mark();
+            posting_t *y;
+            float ys;
+            int yn;
+
+            memset(acc, 0, cn * sizeof(float));
+            y = extract_syms(s[r], r, &yn);
+            ys = binary ? yn : s[r].len;
+
+            /* Accumulate matching symbols over shared symbols */
+            for (int i = 0; i < yn; i++) {
+                long e = index_find(idx, num, y[i].sym);
+                for (; e < num && idx[e].sym == y[i].sym; e++)
+                    acc[idx[e].id - m->col.start] +=
+                        binary ? 1 : fmin(idx[e].cnt, y[i].cnt);
+            }
+            scratch_release(mark);
+
+            for (int c = m->col.start; c < m->col.end; c++) {
+                match_t x;
+
+                /* Lower triangle is stored with the upper triangle */
+                if (m->triangular && r < c)
+                    continue;
+                if (!isnan(hmatrix_get(m, c, r)))
+                    continue;
+
+                x.a = acc[c - m->col.start];
+                x.b = sizes[c - m->col.start] - x.a;
+                x.c = ys - x.a;
+                hmatrix_set(m, c, r, coef ? coef(x) : x.a);
+            }
+        }
+        free(acc);
+    }
+
+    free(idx);
+    free(sizes);
+}
+
+/**
+ * Computes the Jaccard coefficient for all pairs of a matrix
+ * @param hm Instance of measure
+ * @param m Matrix object
+ * @param s Array of strings
+ */
+void sim_jaccard_compare_all(hmeasure_t *hm, hmatrix_t *m, hstring_t *s)
+{
+    sim_coefficient_compare_all(hm, m, s, coef_jaccard);
+}
+
+/**
+ * Computes the Simpson coefficient for all pairs of a matrix
+ * @param hm Instance of measure
+ * @param m Matrix object
+ * @param s Array of strings
+ */
+void sim_simpson_compare_all(hmeasure_t *hm, hmatrix_t *m, hstring_t *s)
+{
+    sim_coefficient_compare_all(hm, m, s, coef_simpson);
+}
+
+/**
+ * Computes the Braun-Blanquet coefficient for all pairs of a matrix
+ * @param hm Instance of measure
+ * @param m Matrix object
+ * @param s Array of strings
+ */
+void sim_braun_compare_all(hmeasure_t *hm, hmatrix_t *m, hstring_t *s)
+{
+    sim_coefficient_compare_all(hm, m, s, coef_braun);
+}
+
+/**
+ * Computes the Dice coefficient for all pairs of a matrix
+ * @param hm Instance of measure
+ * @param m Matrix object
+ * @param s Array of strings
+ */
+void sim_dice_compare_all(hmeasure_t *hm, hmatrix_t *m, hstring_t *s)
+{
+    sim_coefficient_compare_all(hm, m, s, coef_dice);
+}
+
+/**
+ * Computes the Sokal-Sneath coefficient for all pairs of a matrix
+ * @param hm Instance of measure
+ * @param m Matrix object
+ * @param s Array of strings
+ */
+void sim_sokal_compare_all(hmeasure_t *hm, hmatrix_t *m, hstring_t *s)
+{
+    sim_coefficient_compare_all(hm, m, s, coef_sokal);
+}
+
+/**
+ * Computes the Kulczynski coefficient for all pairs of a matrix
+ * @param hm Instance of measure
+ * @param m Matrix object
+ * @param s Array of strings
+ */
+void sim_kulczynski_compare_all(hmeasure_t *hm, hmatrix_t *m, hstring_t *s)
+{
+    sim_coefficient_compare_all(hm, m, s, coef_kulczynski);
+}
+
+/**
+ * Computes the Otsuka coefficient for all pairs of a matrix
+ * @param hm Instance of measure
+ * @param m Matrix object
+ * @param s Array of strings
+ */
+void sim_otsuka_compare_all(hmeasure_t *hm, hmatrix_t *m, hstring_t *s)
+{
+    sim_coefficient_compare_all(hm, m, s, coef_otsuka);
+}
 
 /** @} */
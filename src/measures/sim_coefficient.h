@@ -13,6 +13,8 @@
 #define SIM_COEFFICIENTS_H
 
 #include "hstring.h"
+#include "hmatrix.h"
+#include "measures.h"
 
 typedef struct
 {
@@ -21,27 +23,42 @@ typedef struct
     float c;    /**< Number of right mismatches */
 } match_t;
 
-void sim_coefficient_config();
+void sim_coefficient_config(hmeasure_t *);
+
+/* Coefficients of matches */
+typedef float (*coef_t) (match_t);
+coef_t sim_coefficient_get(const char *);
+int sim_coefficient_binary(hmeasure_t *);
+float sim_coefficient_size(hmeasure_t *, hstring_t);
+void sim_coefficient_compare_all(hmeasure_t *, hmatrix_t *, hstring_t *,
+                                 coef_t);
 
 #define sim_jaccard_config sim_coefficient_config
-float sim_jaccard_compare(hstring_t x, hstring_t y);
+float sim_jaccard_compare(hmeasure_t *, hstring_t, hstring_t);
+void sim_jaccard_compare_all(hmeasure_t *, hmatrix_t *, hstring_t *);
 
 #define sim_simpson_config sim_coefficient_config
-float sim_simpson_compare(hstring_t x, hstring_t y);
+float sim_simpson_compare(hmeasure_t *, hstring_t, hstring_t);
+void sim_simpson_compare_all(hmeasure_t *, hmatrix_t *, hstring_t *);
 
 #define sim_braun_config sim_coefficient_config
-float sim_braun_compare(hstring_t x, hstring_t y);
+float sim_braun_compare(hmeasure_t *, hstring_t, hstring_t);
+void sim_braun_compare_all(hmeasure_t *, hmatrix_t *, hstring_t *);
 
 #define sim_dice_config sim_coefficient_config
-float sim_dice_compare(hstring_t x, hstring_t y);
+float sim_dice_compare(hmeasure_t *, hstring_t, hstring_t);
+void sim_dice_compare_all(hmeasure_t *, hmatrix_t *, hstring_t *);
 
 #define sim_sokal_config sim_coefficient_config
-float sim_sokal_compare(hstring_t x, hstring_t y);
+float sim_sokal_compare(hmeasure_t *, hstring_t, hstring_t);
+void sim_sokal_compare_all(hmeasure_t *, hmatrix_t *, hstring_t *);
 
 #define sim_kulczynski_config sim_coefficient_config
-float sim_kulczynski_compare(hstring_t x, hstring_t y);
+float sim_kulczynski_compare(hmeasure_t *, hstring_t, hstring_t);
+void sim_kulczynski_compare_all(hmeasure_t *, hmatrix_t *, hstring_t *);
 
 #define sim_otsuka_config sim_coefficient_config
-float sim_otsuka_compare(hstring_t x, hstring_t y);
+float sim_otsuka_compare(hmeasure_t *, hstring_t, hstring_t);
+void sim_otsuka_compare_all(hmeasure_t *, hmatrix_t *, hstring_t *);
 
 #endif /* SIM_COEFFICIENTS_H */
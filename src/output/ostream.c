@@ -0,0 +1,390 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/**
+ * @addtogroup output
+ * <hr>
+ * Buffered output streams for the text-based output modules. If
+ * compression is enabled, the output is split into blocks that are
+ * deflated independently by multiple threads and concatenated as members
+ * of a standard gzip stream, similar to the tool pigz. Alternatively,
+ * the output can be compressed using zstd with multiple worker threads.
+ * @{
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "output.h"
+#include "ostream.h"
+
+/* External variables */
+extern config_t cfg;
+
+/**
+ * Write a buffer to the stream destination
+ * @param o Output stream
+ * @param buf Buffer
+ * @param len Length of buffer
+ */
+static void ostream_fdwrite(ostream_t *o, const void *buf, size_t len)
+{
+    if (o->error || output_fdwrite(o->fd, buf, len))
+        return;
+
+    error("Could not write to output file");
+    o->error = TRUE;
+}
+
+/**
+ * Compress a block as a complete gzip member
+ * @param o Output stream
+ * @param in Input block
+ * @param len Length of input block (updated to length of member)
+ * @return gzip member (to be freed) or NULL on error
+ */
+static char *gzip_member(ostream_t *o, char *in, size_t *len)
+{
+    z_stream zs;
+    char *out;
+    size_t size;
+
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, o->level, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+        return NULL;
+
+    size = deflateBound(&zs, *len);
+    out = malloc(size);
+    if (!out) {
+        deflateEnd(&zs);
+        return NULL;
+    }
+
+    zs.next_in = (Bytef *) in;
+    zs.avail_in = *len;
+    zs.next_out = (Bytef *) out;
+    zs.avail_out = size;
+
+    if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+        deflateEnd(&zs);
+        free(out);
+        return NULL;
+    }
+
+    *len = zs.total_out;
+    deflateEnd(&zs);
+    return out;
+}
+
+/**
+ * Compress all queued blocks in parallel and write the resulting gzip
+ * members in order.
+ * @param o Output stream
+ */
+static void gzip_flush(ostream_t *o)
+{
+    int i;
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (i = 0; i < o->num; i++) {
+        char *z = gzip_member(o, o->blocks[i], &o->lens[i]);
+        free(o->blocks[i]);
+        o->blocks[i] = z;
+    }
+
+    for (i = 0; i < o->num; i++) {
+        if (!o->blocks[i]) {
+            error("Could not compress block of output");
+            o->error = TRUE;
+        } else {
+            ostream_fdwrite(o, o->blocks[i], o->lens[i]);
+        }
+        free(o->blocks[i]);
+        o->members++;
+    }
+
+    o->num = 0;
+}
+
+#ifdef HAVE_ZSTD
+/**
+ * Compress a block using zstd and write the compressed data
+ * @param o Output stream
+ * @param buf Block of data
+ * @param len Length of block
+ * @param mode End directive of zstd
+ */
+static void zstd_flush(ostream_t *o, char *buf, size_t len,
+                       ZSTD_EndDirective mode)
+{
+    ZSTD_inBuffer in = { buf, len, 0 };
+    size_t size = ZSTD_CStreamOutSize(), r;
+    char *out = malloc(size);
+
+    if (!out) {
+        error("Could not allocate memory for zstd");
+        o->error = TRUE;
+        return;
+    }
+
+    do {
+        ZSTD_outBuffer zo = { out, size, 0 };
+        r = ZSTD_compressStream2(o->zstd, &zo, &in, mode);
+        if (ZSTD_isError(r)) {
+            error("zstd compression failed: %s", ZSTD_getErrorName(r));
+            o->error = TRUE;
+            break;
+        }
+        ostream_fdwrite(o, out, zo.pos);
+    } while (mode == ZSTD_e_end ? r != 0 : in.pos < in.size);
+
+    free(out);
+}
+#endif
+
+/**
+ * Hand over the current block depending on the mode of the stream
+ * @param o Output stream
+ * @param last Flag indicating the end of the stream
+ * @return true on success, false otherwise
+ */
+static int ostream_flush(ostream_t *o, int last)
+{
+    switch (o->mode) {
+    case OSTREAM_GZIP:
+        if (o->len > 0 || (last && o->members == 0 && o->num == 0)) {
+            o->blocks[o->num] = o->buf;
+            o->lens[o->num++] = o->len;
+            o->buf = malloc(OSTREAM_BLOCK_SIZE);
+            if (!o->buf) {
+                error("Could not allocate memory for output");
+                o->error = TRUE;
+            }
+        }
+        if (o->num == o->max || last)
+            gzip_flush(o);
+        break;
+#ifdef HAVE_ZSTD
+    case OSTREAM_ZSTD:
+        zstd_flush(o, o->buf, o->len, last ? ZSTD_e_end : ZSTD_e_continue);
+        break;
+#endif
+    default:
+        ostream_fdwrite(o, o->buf, o->len);
+        break;
+    }
+
+    o->len = 0;
+    return !o->error;
+}
+
+/**
+ * Open an output stream. Compression is configured using the parameters
+ * "compress", "compress_level" and "compressor" of the output group.
+ * @param fn File name or NULL for standard output
+ * @return output stream or NULL on error
+ */
+ostream_t *ostream_open(char *fn)
+{
+    int zlib = FALSE;
+    cfg_int level = 9;
+    const char *compressor = "gzip";
+    ostream_t *o;
+
+    config_lookup_bool(&cfg, "output.compress", &zlib);
+    config_lookup_int(&cfg, "output.compress_level", &level);
+    config_lookup_string(&cfg, "output.compressor", &compressor);
+
+    o = calloc(1, sizeof(ostream_t));
+    if (!o) {
+        error("Could not allocate output stream");
+        return NULL;
+    }
+
+    o->level = level;
+    o->max = 1;
+    if (!zlib) {
+        o->mode = OSTREAM_PLAIN;
+    } else if (!strcasecmp(compressor, "gzip")) {
+        o->mode = OSTREAM_GZIP;
+        o->level = MIN(MAX(level, 0), 9);
+#ifdef HAVE_OPENMP
+        o->max = 2 * omp_get_max_threads();
+#endif
+    } else if (!strcasecmp(compressor, "zstd")) {
+#ifdef HAVE_ZSTD
+        o->mode = OSTREAM_ZSTD;
+#else
+        error("Harry has been compiled without zstd support.");
+        free(o);
+        return NULL;
+#endif
+    } else {
+        error("Unknown compressor '%s'.", compressor);
+        free(o);
+        return NULL;
+    }
+
+    o->buf = malloc(OSTREAM_BLOCK_SIZE);
+    o->blocks = calloc(o->max, sizeof(char *));
+    o->lens = calloc(o->max, sizeof(size_t));
+    if (!o->buf || !o->blocks || !o->lens) {
+        error("Could not allocate output stream");
+        goto err;
+    }
+
+#ifdef HAVE_ZSTD
+    if (o->mode == OSTREAM_ZSTD) {
+        int threads = 1;
+#ifdef HAVE_OPENMP
+        threads = omp_get_max_threads();
+#endif
+        o->zstd = ZSTD_createCCtx();
+        if (!o->zstd) {
+            error("Could not create zstd context");
+            goto err;
+        }
+        ZSTD_CCtx_setParameter(o->zstd, ZSTD_c_compressionLevel, level);
+        /* Fails silently if zstd has been built without threads */
+        if (threads > 1)
+            ZSTD_CCtx_setParameter(o->zstd, ZSTD_c_nbWorkers, threads);
+    }
+#endif
+
+    if (fn) {
+        o->fd = open(fn, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    } else {
+        fflush(stdout);
+        o->fd = STDOUT_FILENO;
+    }
+
+    if (o->fd < 0) {
+        error("Could not open output file '%s'.", fn);
+        goto err;
+    }
+
+    return o;
+
+  err:
+#ifdef HAVE_ZSTD
+    if (o->zstd)
+        ZSTD_freeCCtx(o->zstd);
+#endif
+    free(o->buf);
+    free(o->blocks);
+    free(o->lens);
+    free(o);
+    return NULL;
+}
+
+/**
+ * Write data to an output stream
+ * @param o Output stream
+ * @param buf Buffer
+ * @param len Length of buffer
+ * @return true on success, false otherwise
+ */
+int ostream_write(ostream_t *o, const void *buf, size_t len)
+{
+    const char *ptr = buf;
+    size_t n;
+
+    while (len > 0 && !o->error) {
+        n = MIN(len, OSTREAM_BLOCK_SIZE - o->len);
+        memcpy(o->buf + o->len, ptr, n);
+        o->len += n;
+        ptr += n;
+        len -= n;
+
+        if (o->len == OSTREAM_BLOCK_SIZE)
+            ostream_flush(o, FALSE);
+    }
+
+    return !o->error;
+}
+
+/**
+ * Print formatted data to an output stream
+ * @param o Output stream
+ * @param fmt Format string
+ * @return number of written characters or -1 on error
+ */
+int ostream_printf(ostream_t *o, const char *fmt, ...)
+{
+    va_list ap;
+    char *tmp;
+    int n;
+
+    if (o->error)
+        return -1;
+
+    va_start(ap, fmt);
+    n = vsnprintf(o->buf + o->len, OSTREAM_BLOCK_SIZE - o->len, fmt, ap);
+    va_end(ap);
+
+    if (n < 0)
+        return -1;
+
+    /* Fast path: the data fits into the current block */
+    if (o->len + n < OSTREAM_BLOCK_SIZE) {
+        o->len += n;
+        return n;
+    }
+
+    tmp = malloc(n + 1);
+    if (!tmp) {
+        error("Could not allocate memory for output");
+        return -1;
+    }
+
+    va_start(ap, fmt);
+    vsnprintf(tmp, n + 1, fmt, ap);
+    va_end(ap);
+
+    ostream_write(o, tmp, n);
+    free(tmp);
+    return o->error ? -1 : n;
+}
+
+/**
+ * Flush and close an output stream
+ * @param o Output stream
+ * @return true on success, false otherwise
+ */
+int ostream_close(ostream_t *o)
+{
+    int i, r;
+
+    if (!o)
+        return FALSE;
+
+    r = ostream_flush(o, TRUE);
+    if (o->fd != STDOUT_FILENO)
+        close(o->fd);
+
+#ifdef HAVE_ZSTD
+    if (o->zstd)
+        ZSTD_freeCCtx(o->zstd);
+#endif
+    for (i = 0; i < o->num; i++)
+        free(o->blocks[i]);
+    free(o->blocks);
+    free(o->lens);
+    free(o->buf);
+    free(o);
+
+    return r;
+}
+
+/** @} */
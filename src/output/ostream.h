@@ -0,0 +1,53 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef OSTREAM_H
+#define OSTREAM_H
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/** Size of blocks compressed by one thread */
+#define OSTREAM_BLOCK_SIZE      (1024 * 1024)
+
+/* Modes of output streams */
+#define OSTREAM_PLAIN           0
+#define OSTREAM_GZIP            1
+#define OSTREAM_ZSTD            2
+
+/**
+ * Buffered output stream with optional parallel compression
+ */
+typedef struct
+{
+    int fd;                     /**< File descriptor */
+    int mode;                   /**< Mode of stream */
+    int level;                  /**< Compression level */
+    char *buf;                  /**< Current block */
+    size_t len;                 /**< Length of current block */
+    char **blocks;              /**< Queue of full blocks */
+    size_t *lens;               /**< Lengths of queued blocks */
+    int num;                    /**< Number of queued blocks */
+    int max;                    /**< Maximum number of queued blocks */
+    long members;               /**< Number of written gzip members */
+    int error;                  /**< Error flag */
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx *zstd;            /**< Context for zstd */
+#endif
+} ostream_t;
+
+ostream_t *ostream_open(char *);
+int ostream_write(ostream_t *, const void *, size_t);
+int ostream_printf(ostream_t *, const char *, ...);
+int ostream_close(ostream_t *);
+
+#endif /* OSTREAM_H */
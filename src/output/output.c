@@ -30,6 +30,9 @@
 #include "output_json.h"
 #include "output_matlab.h"
 #include "output_raw.h"
+#include "output_npy.h"
+#include "output_chunk.h"
+#include "output_shm.h"
 
 /**
  * Structure for output interface
@@ -77,6 +80,22 @@ void output_config(const char *format)
         func.output_open = output_raw_open;
         func.output_write = output_raw_write;
         func.output_close = output_raw_close;
+    } else if (!strcasecmp(format, "npy")) {
+        func.output_open = output_npy_open;
+        func.output_write = output_npy_write;
+        func.output_close = output_npy_close;
+    } else if (!strcasecmp(format, "npz")) {
+        func.output_open = output_npz_open;
+        func.output_write = output_npy_write;
+        func.output_close = output_npy_close;
+    } else if (!strcasecmp(format, "chunk")) {
+        func.output_open = output_chunk_open;
+        func.output_write = output_chunk_write;
+        func.output_close = output_chunk_close;
+    } else if (!strcasecmp(format, "shm")) {
+        func.output_open = output_shm_open;
+        func.output_write = output_shm_write;
+        func.output_close = output_shm_close;
     } else {
         error("Unknown ouptut format '%s', using 'text' instead.", format);
         output_config("text");
@@ -111,4 +130,92 @@ void output_close(void)
     func.output_close();
 }
 
+/**
+ * Determine the number of rows in a band of the matrix. Bands are the
+ * unit of bulk writing, such that each band fills roughly one buffer of
+ * OUTPUT_BAND_SIZE bytes.
+ * @param m Matrix of similarity values
+ * @return number of rows per band
+ */
+int output_band_rows(hmatrix_t *m)
+{
+    long cols = m->col.end - m->col.start;
+    long rows = OUTPUT_BAND_SIZE / (sizeof(float) * MAX(cols, 1));
+    return (int) MAX(MIN(rows, m->row.end - m->row.start), 1);
+}
+
+/**
+ * Convert a band of rows to a buffer of floats. The rows are converted
+ * in parallel and rounded to the given precision. The buffer needs to
+ * hold at least (end - start) * cols floats and receives the rows in
+ * row-major order.
+ * @param m Matrix of similarity values
+ * @param start First row of band (inclusive)
+ * @param end Last row of band (exclusive)
+ * @param p Precision as number of decimal places or 0
+ * @param buf Buffer for floats
+ * @return number of converted values
+ */
+long output_get_rows(hmatrix_t *m, int start, int end, int p, float *buf)
+{
+    assert(m && buf && start <= end);
+    long cols = m->col.end - m->col.start;
+    long n = cols, rs = m->row.start;
+    double s = pow(10, p);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (int i = start; i < end; i++) {
+        float *row = buf + (i - start) * cols;
+        long j, k, r = i - rs;
+
+        if (!m->triangular) {
+            memcpy(row, m->values + r * cols, cols * sizeof(float));
+        } else {
+            /* Walk down the column until reaching the diagonal */
+            for (j = 0, k = r; j < r; j++) {
+                row[j] = m->values[k];
+                k += n - j - 1;
+            }
+            /* Continue along the row of the triangle */
+            k = r * n - r * (r - 1) / 2;
+            memcpy(row + r, m->values + k, (cols - r) * sizeof(float));
+        }
+
+        if (p == 0)
+            continue;
+
+        for (j = 0; j < cols; j++)
+            row[j] = round(row[j] * s) / s;
+    }
+
+    return (end - start) * cols;
+}
+
+/**
+ * Write a buffer to a file descriptor. The function repeats the call
+ * to write() until all data has been written or an error occurs.
+ * @param fd File descriptor
+ * @param buf Buffer to write
+ * @param len Length of buffer
+ * @return true on success, false otherwise
+ */
+int output_fdwrite(int fd, const void *buf, size_t len)
+{
+    const char *ptr = buf;
+
+    while (len > 0) {
+        ssize_t r = write(fd, ptr, len);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return FALSE;
+        ptr += r;
+        len -= r;
+    }
+
+    return TRUE;
+}
+
 /** @} */
@@ -22,4 +22,12 @@ int output_open(char *);
 int output_write(hmatrix_t *);
 void output_close(void);
 
+/** Size of bands for bulk writing in bytes */
+#define OUTPUT_BAND_SIZE        (16 * 1024 * 1024)
+
+/* Bulk writing */
+int output_band_rows(hmatrix_t *);
+long output_get_rows(hmatrix_t *, int, int, int, float *);
+int output_fdwrite(int, const void *, size_t);
+
 #endif /* OUTPUT_H */
@@ -0,0 +1,203 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/**
+ * @addtogroup output
+ * <hr>
+ * <em>chunk</em>: The matrix of similarity/dissimilarity measures is
+ * written to a file in the chunked format. The matrix is split into bands
+ * of rows that are compressed in parallel if compression is enabled. An
+ * index of the bands at the end of the file enables random access to
+ * rows and submatrices. See hchunk.c for details of the format.
+ * @{
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "output.h"
+#include "harry.h"
+#include "hchunk.h"
+#include "output_chunk.h"
+
+/* External variables */
+extern config_t cfg;
+
+/* Local variables */
+static cfg_int precision = 0;
+static int zlib = 0;
+static cfg_int level = 9;
+static int fd = -1;
+
+/**
+ * Prepare a band for writing. The values of the band are copied, rounded
+ * and optionally compressed. Bands that do not shrink are stored as is.
+ * @param m Matrix of similarity values
+ * @param h Header of chunked file
+ * @param b Index of band
+ * @param e Index entry of band (size and length are set)
+ * @return buffer with band data (to be freed) or NULL on error
+ */
+static char *chunk_band(hmatrix_t *m, hchunk_header_t *h, int b,
+                        hchunk_entry_t *e)
+{
+    uint64_t k, n = hchunk_band_length(h, b);
+    float *v, *src = m->values + hchunk_band_offset(h, b);
+    double s = pow(10, precision);
+    uLongf len;
+    Bytef *z;
+
+    e->length = n * sizeof(float);
+    e->size = e->length;
+
+    v = malloc(MAX(e->length, 1));
+    if (!v)
+        return NULL;
+
+    if (precision == 0)
+        memcpy(v, src, e->length);
+    else
+        for (k = 0; k < n; k++)
+            v[k] = round(src[k] * s) / s;
+
+    if (!zlib)
+        return (char *) v;
+
+    len = compressBound(e->length);
+    z = malloc(len);
+    if (!z || compress2(z, &len, (Bytef *) v, e->length, level) != Z_OK ||
+        len >= e->length) {
+        free(z);
+        return (char *) v;
+    }
+
+    free(v);
+    e->size = len;
+    return (char *) z;
+}
+
+/**
+ * Opens a file for writing chunked format
+ * @param fn File name
+ * @return true on success, false otherwise
+ */
+int output_chunk_open(char *fn)
+{
+    config_lookup_int(&cfg, "output.precision", &precision);
+    config_lookup_bool(&cfg, "output.compress", &zlib);
+    config_lookup_int(&cfg, "output.compress_level", &level);
+    level = MIN(MAX(level, 0), 9);
+
+    fd = open(fn, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        error("Could not open output file '%s'.", fn);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Write similarity matrix to output. Each thread prepares and compresses
+ * one band, while the bands are written in order by the master thread.
+ * @param m Matrix of similarity values
+ * @return Number of written values
+ */
+int output_chunk_write(hmatrix_t *m)
+{
+    hchunk_header_t h;
+    hchunk_entry_t *index;
+    char **bufs;
+    uint64_t pos = sizeof(h);
+    int b, i, batch = 1, ret = 0;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, HCHUNK_MAGIC, 8);
+    h.version = HCHUNK_VERSION;
+    h.dtype = HCHUNK_FLOAT32;
+    h.flags = (m->triangular ? HCHUNK_TRIANGULAR : 0) |
+        (zlib ? HCHUNK_ZLIB : 0);
+    h.rows = m->row.end - m->row.start;
+    h.cols = m->col.end - m->col.start;
+    h.row_start = m->row.start;
+    h.col_start = m->col.start;
+    h.band_rows = MAX(MIN(CHUNK_BAND_SIZE / MAX(h.cols, 1), h.rows), 1);
+    h.num_bands = (h.rows + h.band_rows - 1) / h.band_rows;
+
+#ifdef HAVE_OPENMP
+    batch = 2 * omp_get_max_threads();
+#endif
+
+    index = calloc(MAX(h.num_bands, 1), sizeof(hchunk_entry_t));
+    bufs = calloc(batch, sizeof(char *));
+    if (!index || !bufs) {
+        error("Could not allocate memory for chunked output");
+        goto err;
+    }
+
+    /* Write preliminary header */
+    if (!output_fdwrite(fd, &h, sizeof(h)))
+        goto err;
+
+    for (b = 0; b < (int) h.num_bands; b += batch) {
+        int n = MIN(batch, (int) h.num_bands - b);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+        for (i = 0; i < n; i++)
+            bufs[i] = chunk_band(m, &h, b + i, &index[b + i]);
+
+        for (i = 0; i < n; i++) {
+            hchunk_entry_t *e = &index[b + i];
+            if (!bufs[i] || !output_fdwrite(fd, bufs[i], e->size)) {
+                error("Failed to write band %d", b + i);
+                goto err;
+            }
+            e->offset = pos;
+            pos += e->size;
+            ret += e->length / sizeof(float);
+            free(bufs[i]);
+            bufs[i] = NULL;
+        }
+    }
+
+    /* Write index and update header */
+    h.index = pos;
+    if (!output_fdwrite(fd, index, sizeof(hchunk_entry_t) * h.num_bands) ||
+        pwrite(fd, &h, sizeof(h), 0) != sizeof(h)) {
+        error("Failed to write index of chunked file");
+        goto err;
+    }
+
+    free(index);
+    free(bufs);
+    return ret;
+
+  err:
+    for (i = 0; bufs && i < batch; i++)
+        free(bufs[i]);
+    free(index);
+    free(bufs);
+    return 0;
+}
+
+/**
+ * Closes an open output file.
+ */
+void output_chunk_close()
+{
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+}
+
+/** @} */
@@ -21,6 +21,7 @@
 #include "common.h"
 #include "util.h"
 #include "output.h"
+#include "ostream.h"
 #include "harry.h"
 
 
@@ -28,21 +29,13 @@
 extern config_t cfg;
 
 /* Local variables */
-static void *z = NULL;
+static ostream_t *z = NULL;
 
 static cfg_int precision = 0;
-static int zlib = 0;
 static int save_indices = 0;
 static int save_labels = 0;
 static int save_sources = 0;
 
-#define output_printf(z, ...) (\
-   zlib ? \
-       gzprintf((gzFile) z, __VA_ARGS__) \
-   : \
-       fprintf((FILE *) z, __VA_ARGS__) \
-)
-
 /**
  * Opens a file for writing json format
  * @param fn File name
@@ -56,19 +49,15 @@ int output_json_open(char *fn)
     config_lookup_bool(&cfg, "output.save_indices", &save_indices);
     config_lookup_bool(&cfg, "output.save_labels", &save_labels);
     config_lookup_bool(&cfg, "output.save_sources", &save_sources);
-    config_lookup_bool(&cfg, "output.compress", &zlib);
 
-    if (zlib)
-        z = gzopen(fn, "w9");
-    else
-        z = fopen(fn, "w");
+    z = ostream_open(fn);
 
     if (!z) {
         error("Could not open output file '%s'.", fn);
         return FALSE;
     }
 
-    output_printf(z, "{\n");
+    ostream_printf(z, "{\n");
 
     return TRUE;
 }
@@ -84,69 +73,69 @@ int output_json_write(hmatrix_t *m)
     int i, j, k = 0;
 
     if (save_indices) {
-        output_printf(z, "  \"col_indices\": [");
+        ostream_printf(z, "  \"col_indices\": [");
         for (j = m->col.start; j < m->col.end; j++) {
-            output_printf(z, "%d", j);
+            ostream_printf(z, "%d", j);
             if (j < m->col.end - 1)
-                output_printf(z, ", ");
+                ostream_printf(z, ", ");
         }
-        output_printf(z, "],\n  \"row_indices\": [");
+        ostream_printf(z, "],\n  \"row_indices\": [");
         for (j = m->row.start; j < m->row.end; j++) {
-            output_printf(z, "%d", j);
+            ostream_printf(z, "%d", j);
             if (j < m->row.end - 1)
-                output_printf(z, ", ");
+                ostream_printf(z, ", ");
         }
-        output_printf(z, "],\n");
+        ostream_printf(z, "],\n");
     }
 
     if (save_labels) {
-        output_printf(z, "  \"col_labels\": [");
+        ostream_printf(z, "  \"col_labels\": [");
         for (j = m->col.start; j < m->col.end; j++) {
-            output_printf(z, " %g", m->labels[j]);
+            ostream_printf(z, " %g", m->labels[j]);
             if (j < m->col.end - 1)
-                output_printf(z, ", ");
+                ostream_printf(z, ", ");
         }
-        output_printf(z, "],\n  \"row_labels\": [");
+        ostream_printf(z, "],\n  \"row_labels\": [");
         for (j = m->row.start; j < m->row.end; j++) {
-            output_printf(z, "%g", m->labels[j]);
+            ostream_printf(z, "%g", m->labels[j]);
             if (j < m->row.end - 1)
-                output_printf(z, ", ");
+                ostream_printf(z, ", ");
         }
-        output_printf(z, "],\n");
+        ostream_printf(z, "],\n");
     }
 
     if (save_sources) {
-        output_printf(z, "  \"col_sources\": [");
+        ostream_printf(z, "  \"col_sources\": [");
         for (j = m->col.start; j < m->col.end; j++) {
-            output_printf(z, "\"%s\"", m->srcs[j]);
+            ostream_printf(z, "\"%s\"", m->srcs[j]);
             if (j < m->row.end - 1)
-                output_printf(z, ", ");
+                ostream_printf(z, ", ");
         }
-        output_printf(z, "],\n  \"row_sources\": [");
+        ostream_printf(z, "],\n  \"row_sources\": [");
         for (j = m->row.start; j < m->row.end; j++) {
-            output_printf(z, "\"%s\"", m->srcs[j]);
+            ostream_printf(z, "\"%s\"", m->srcs[j]);
             if (j < m->row.end - 1)
-                output_printf(z, ", ");
+                ostream_printf(z, ", ");
         }
-        output_printf(z, "],\n");
+        ostream_printf(z, "],\n");
     }
 
-    output_printf(z, "  \"matrix\": [\n");
+    ostream_printf(z, "  \"matrix\": [\n");
     for (i = m->row.start; i < m->row.end; i++) {
-        output_printf(z, "    [");
+        ostream_printf(z, "    [");
         for (j = m->col.start; j < m->col.end; j++) {
             float val = hround(hmatrix_get(m, j, i), precision);
-            output_printf(z, "%g", val);
+            ostream_printf(z, "%g", val);
             if (j < m->col.end - 1)
-                output_printf(z, ", ");
+                ostream_printf(z, ", ");
             k++;
         }
-        output_printf(z, "]");
+        ostream_printf(z, "]");
         if (i < m->row.end - 1)
-            output_printf(z, ",");
-        output_printf(z, "\n");
+            ostream_printf(z, ",");
+        ostream_printf(z, "\n");
     }
-    output_printf(z, "  ]\n");
+    ostream_printf(z, "  ]\n");
     return k;
 }
 
@@ -155,12 +144,10 @@ int output_json_write(hmatrix_t *m)
  */
 void output_json_close()
 {
-    output_printf(z, "}\n");
+    ostream_printf(z, "}\n");
 
-    if (zlib)
-        gzclose(z);
-    else
-        fclose(z);
+    ostream_close(z);
+    z = NULL;
 }
 
 /** @} */
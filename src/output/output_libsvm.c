@@ -21,6 +21,7 @@
 #include "common.h"
 #include "util.h"
 #include "output.h"
+#include "ostream.h"
 #include "harry.h"
 
 
@@ -28,18 +29,9 @@
 extern config_t cfg;
 
 /* Local variables */
-static void *z = NULL;
-static int zlib = 0;
+static ostream_t *z = NULL;
 static cfg_int precision = 0;
 
-/* Dirty hack to support compression */
-#define output_printf(z, ...) (\
-   zlib ? \
-       gzprintf((gzFile) z, __VA_ARGS__) \
-   : \
-       fprintf((FILE *) z, __VA_ARGS__) \
-)
-
 /**
  * Opens a file for writing libsvm format
  * @param fn File name
@@ -49,13 +41,9 @@ int output_libsvm_open(char *fn)
 {
     assert(fn);
 
-    config_lookup_bool(&cfg, "output.compress", &zlib);
     config_lookup_int(&cfg, "output.precision", &precision);
 
-    if (zlib)
-        z = gzopen(fn, "w9");
-    else
-        z = fopen(fn, "w");
+    z = ostream_open(fn);
 
     if (!z) {
         error("Could not open output file '%s'.", fn);
@@ -76,17 +64,17 @@ int output_libsvm_write(hmatrix_t *m)
     int i, j, r, k = 0;
 
     for (i = m->row.start; i < m->row.end; i++) {
-        output_printf(z, "%d 0:%d", (int) m->labels[i], i + 1);
+        ostream_printf(z, "%d 0:%d", (int) m->labels[i], i + 1);
         for (j = m->col.start; j < m->col.end; j++) {
             float val = hround(hmatrix_get(m, j, i), precision);
-            r = output_printf(z, " %d:%g", j + 1, val);
+            r = ostream_printf(z, " %d:%g", j + 1, val);
             if (r < 0) {
                 error("Could not write to output file");
                 return -k;
             }
             k++;
         }
-        output_printf(z, "\n");
+        ostream_printf(z, "\n");
     }
     return k;
 }
@@ -96,12 +84,8 @@ int output_libsvm_write(hmatrix_t *m)
  */
 void output_libsvm_close()
 {
-    if (z) {
-        if (zlib)
-            gzclose(z);
-        else
-            fclose(z);
-    }
+    ostream_close(z);
+    z = NULL;
 }
 
 /** @} */
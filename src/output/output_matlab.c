@@ -14,7 +14,8 @@
  * <hr>
  * <em>matlab</em>: The similarity matrix is exported as a matlab file
  * version 5. Depending on the configura.starton the indices, sources and
- * labels are also exported.
+ * labels are also exported. If compression is enabled, all data elements
+ * are stored as zlib-compressed elements (miCOMPRESSED).
  * @{
  */
 
@@ -34,6 +35,15 @@ static cfg_int precision = 0;
 static int save_indices = 0;
 static int save_labels = 0;
 static int save_sources = 0;
+static int zlib = 0;
+static cfg_int level = 9;
+
+/* Buffer for compressed elements */
+static char *mbuf = NULL;
+static size_t mlen = 0;
+
+/** Size of chunks for deflating */
+#define CHUNK_SIZE      (1024 * 1024)
 
 /**
  * Pads the output stream
@@ -197,6 +207,9 @@ int output_matlab_open(char *fn)
     config_lookup_bool(&cfg, "output.save_indices", &save_indices);
     config_lookup_bool(&cfg, "output.save_labels", &save_labels);
     config_lookup_bool(&cfg, "output.save_sources", &save_sources);
+    config_lookup_bool(&cfg, "output.compress", &zlib);
+    config_lookup_int(&cfg, "output.compress_level", &level);
+    level = MIN(MAX(level, 0), 9);
 
     f = fopen(fn, "w");
     if (!f) {
@@ -221,38 +234,113 @@ int output_matlab_open(char *fn)
 }
 
 /**
- * Write a similarity matrix in matlab format
+ * Emits a block of data to the output file. If a stream is given, the
+ * block is deflated and the compressed data is written.
+ * @param zs Deflate stream or NULL
+ * @param buf Block of data
+ * @param len Length of block
+ * @param flush Deflate flush mode
+ * @return number of bytes written to file
+ */
+static long emit(z_stream *zs, void *buf, size_t len, int flush)
+{
+    static char out[CHUNK_SIZE];
+    long r = 0;
+    size_t n;
+
+    if (!zs)
+        return fwrite(buf, 1, len, f);
+
+    zs->next_in = buf;
+    zs->avail_in = len;
+    do {
+        zs->next_out = (Bytef *) out;
+        zs->avail_out = CHUNK_SIZE;
+        deflate(zs, flush);
+        n = CHUNK_SIZE - zs->avail_out;
+        r += fwrite(out, 1, n, f);
+    } while (zs->avail_out == 0);
+
+    return r;
+}
+
+/**
+ * Write a similarity matrix in matlab format. The header of the element
+ * is prepared in memory, such that its size is known before the data is
+ * written in large bands of rows. If compression is enabled, the element
+ * is deflated on the fly.
  * @param m Matrix of similarity values
  * @return Number of written bytes
  */
 static int fwrite_matrix(hmatrix_t *m)
 {
-    int r = 0, x, y, i, j;
+    int i, band;
+    long r = 0, x, y, len, hlen, pad;
+    z_stream zs, *z = NULL;
+    char zero[8] = { 0 };
+    char *hbuf = NULL;
+    size_t hsize = 0;
+    float *buf;
+    FILE *h;
 
     x = m->col.end - m->col.start;
     y = m->row.end - m->row.start;
+    pad = (8 - (x * y * sizeof(float)) % 8) % 8;
 
-    /* Write tag */
-    fwrite_uint32(MAT_TYPE_ARRAY, f);
-    fwrite_uint32(0, f);
-
-    /* Write header */
-    r += fwrite_array_flags(0, MAT_CLASS_SINGLE, 0, f);
-    r += fwrite_array_dim(x, y, f);
-    r += fwrite_array_name("matrix", f);
-    r += fwrite_uint32(MAT_TYPE_SINGLE, f);
-    r += fwrite_uint32(x * y * sizeof(float), f);
+    /* Prepare header */
+    h = open_memstream(&hbuf, &hsize);
+    if (!h) {
+        error("Could not allocate header of matlab matrix");
+        return 0;
+    }
+    fwrite_uint32(MAT_TYPE_ARRAY, h);
+    fwrite_uint32(0, h);
+    hlen = fwrite_array_flags(0, MAT_CLASS_SINGLE, 0, h);
+    hlen += fwrite_array_dim(x, y, h);
+    hlen += fwrite_array_name("matrix", h);
+    hlen += fwrite_uint32(MAT_TYPE_SINGLE, h);
+    hlen += fwrite_uint32(x * y * sizeof(float), h);
+    fclose(h);
+    ((uint32_t *) hbuf)[1] = hlen + x * y * sizeof(float) + pad;
+
+    band = output_band_rows(m);
+    buf = malloc(sizeof(float) * band * x);
+    if (!buf) {
+        error("Could not allocate buffer for matlab matrix");
+        free(hbuf);
+        return 0;
+    }
 
-    /* Write data */
-    for (i = m->row.start; i < m->row.end; i++) {
-        for (j = m->col.start; j < m->col.end; j++) {
-            float val = hround(hmatrix_get(m, j, i), precision);
-            r += fwrite_float(val, f);
+    if (zlib) {
+        z = &zs;
+        memset(z, 0, sizeof(z_stream));
+        if (deflateInit(z, level) != Z_OK) {
+            error("Could not initialize zlib compression");
+            free(hbuf);
+            free(buf);
+            return 0;
         }
+        fwrite_uint32(MAT_TYPE_COMPRESSED, f);
+        fwrite_uint32(0, f);
     }
-    r += fpad(f);
 
-    /* Update size in tag */
+    /* Write header and data in bands */
+    r += emit(z, hbuf, hsize, Z_NO_FLUSH);
+    for (i = m->row.start; i < m->row.end; i += band) {
+        len = output_get_rows(m, i, MIN(i + band, m->row.end),
+                              precision, buf);
+        r += emit(z, buf, sizeof(float) * len, Z_NO_FLUSH);
+    }
+    r += emit(z, zero, pad, z ? Z_FINISH : Z_NO_FLUSH);
+
+    free(hbuf);
+    free(buf);
+
+    if (!z)
+        return r;
+
+    /* Update size in tag of compressed element */
+    deflateEnd(z);
     fseek(f, -(r + 4), SEEK_CUR);
     fwrite_uint32(r, f);
     fseek(f, r, SEEK_CUR);
@@ -264,9 +352,10 @@ static int fwrite_matrix(hmatrix_t *m)
  * Write range in matlab format
  * @param ra Range structure
  * @param name Name of range
+ * @param f File pointer
  * @return Number of written bytes
  */
-static int fwrite_range(range_t ra, char *name)
+static int fwrite_range(range_t ra, char *name, FILE *f)
 {
     int r = 0, i;
 
@@ -299,9 +388,11 @@ static int fwrite_range(range_t ra, char *name)
  * @param ra Range structure
  * @param labels Array of all labels
  * @param name Name of labels
+ * @param f File pointer
  * @return Number of written bytes
  */
-static int fwrite_labels(range_t ra, float *labels, char *name)
+static int fwrite_labels(range_t ra, float *labels, char *name,
+                         FILE *f)
 {
     int r = 0, i;
 
@@ -334,9 +425,11 @@ static int fwrite_labels(range_t ra, float *labels, char *name)
  * @param ra Range structure
  * @param sources Array of all sources
  * @param name Name of sources
+ * @param f File pointer
  * @return Number of written bytes
  */
-static int fwrite_sources(range_t ra, char **sources, char *name)
+static int fwrite_sources(range_t ra, char **sources, char *name,
+                          FILE *f)
 {
     int r = 0, i;
 
@@ -363,6 +456,59 @@ static int fwrite_sources(range_t ra, char **sources, char *name)
 }
 
 
+/**
+ * Starts a data element. If compression is enabled, the element is
+ * written to a memory buffer first.
+ * @return File pointer for element
+ */
+static FILE *element_begin()
+{
+    FILE *e;
+
+    if (!zlib)
+        return f;
+
+    e = open_memstream(&mbuf, &mlen);
+    if (!e) {
+        warning("Could not allocate buffer, skipping compression");
+        return f;
+    }
+    return e;
+}
+
+/**
+ * Ends a data element. If compression is enabled, the element is
+ * compressed and written to the output file.
+ * @param e File pointer of element
+ * @param r Number of bytes of element
+ * @return Number of written bytes
+ */
+static int element_end(FILE *e, int r)
+{
+    uLongf len;
+    Bytef *buf;
+
+    if (e == f)
+        return r;
+
+    fclose(e);
+    len = compressBound(mlen);
+    buf = malloc(len);
+    if (!buf || compress2(buf, &len, (Bytef *) mbuf, mlen, level) != Z_OK) {
+        error("Could not compress matlab element");
+        len = r = 0;
+    } else {
+        fwrite_uint32(MAT_TYPE_COMPRESSED, f);
+        fwrite_uint32(len, f);
+        r = fwrite(buf, 1, len, f) + 8;
+    }
+
+    free(buf);
+    free(mbuf);
+    mbuf = NULL;
+    return r;
+}
+
 /**
  * Write similarity matrix to output
  * @param m Matrix/triangle of similarity values
@@ -371,26 +517,33 @@ static int fwrite_sources(range_t ra, char **sources, char *name)
 int output_matlab_write(hmatrix_t *m)
 {
     int r = 0;
+    FILE *e;
 
     /* Write similarity matrix */
     r += fwrite_matrix(m);
 
     /* Save indices as vectors */
     if (save_indices) {
-        r += fwrite_range(m->col, "x_indices");
-        r += fwrite_range(m->row, "y_indices");
+        e = element_begin();
+        r += element_end(e, fwrite_range(m->col, "x_indices", e));
+        e = element_begin();
+        r += element_end(e, fwrite_range(m->row, "y_indices", e));
     }
 
     /* Save labels as vectors */
     if (save_labels) {
-        r += fwrite_labels(m->col, m->labels, "x_labels");
-        r += fwrite_labels(m->row, m->labels, "y_labels");
+        e = element_begin();
+        r += element_end(e, fwrite_labels(m->col, m->labels, "x_labels", e));
+        e = element_begin();
+        r += element_end(e, fwrite_labels(m->row, m->labels, "y_labels", e));
     }
 
     /* Save sources as cell array */
     if (save_sources) {
-        r += fwrite_sources(m->col, m->srcs, "x_sources");
-        r += fwrite_sources(m->row, m->srcs, "y_sources");
+        e = element_begin();
+        r += element_end(e, fwrite_sources(m->col, m->srcs, "x_sources", e));
+        e = element_begin();
+        r += element_end(e, fwrite_sources(m->row, m->srcs, "y_sources", e));
     }
 
     return r;
@@ -405,6 +558,7 @@ void output_matlab_close()
         return;
 
     fclose(f);
+    f = NULL;
 }
 
 /** @} */
@@ -23,6 +23,7 @@
 #define MAT_TYPE_INT64      12
 #define MAT_TYPE_UINT64     13
 #define MAT_TYPE_ARRAY      14
+#define MAT_TYPE_COMPRESSED 15
 
 #define MAT_CLASS_CELL      1
 #define MAT_CLASS_STRUCT    2
@@ -0,0 +1,485 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/**
+ * @addtogroup output
+ * <hr>
+ * <em>npy</em>: The matrix of similarity/dissimilarity measures is written
+ * to a file in the NumPy format (version 1.0). The matrix is stored as a
+ * C-ordered array of 32-bit floats, such that it can be memory-mapped
+ * using numpy.load(fn, mmap_mode='r'). Triangular matrices are expanded
+ * in parallel on write.
+ *
+ * <em>npz</em>: The matrix and, depending on the configuration, indices,
+ * labels and sources are stored as uncompressed npy files in a zip
+ * archive. The archive is compatible with numpy.load().
+ *
+ * @{
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "output.h"
+#include "harry.h"
+#include "output_npy.h"
+
+/* External variables */
+extern config_t cfg;
+
+/* Local variables */
+static cfg_int precision = 0;
+static int save_indices = 0;
+static int save_labels = 0;
+static int save_sources = 0;
+static int npz = FALSE;
+static int fd = -1;
+
+/* Zip archive state */
+static npy_entry_t entries[NPZ_MAX_ENTRIES];
+static int num_entries = 0;
+static uint64_t pos = 0;
+static uint32_t crc = 0;
+
+/**
+ * Writes a block of data to the output file. If the zip archive is
+ * written, the checksum of the current entry is updated.
+ * @param buf Block of data
+ * @param len Length of block
+ * @return true on success, false otherwise
+ */
+static int npy_write(const void *buf, size_t len)
+{
+    if (!output_fdwrite(fd, buf, len)) {
+        error("Failed to write npy data");
+        return FALSE;
+    }
+
+    if (npz)
+        crc = crc32(crc, buf, len);
+    pos += len;
+    return TRUE;
+}
+
+/**
+ * Writes the header of an npy array. The header is padded with spaces,
+ * such that the array data starts at a multiple of 64 bytes.
+ * @param buf Buffer of NPY_HEADER_SIZE bytes
+ * @param descr Description of dtype
+ * @param rows Number of rows
+ * @param cols Number of columns or -1 for a vector
+ * @return length of header
+ */
+static int npy_header(char *buf, const char *descr, long rows, long cols)
+{
+    uint16_t one = 1;
+    int len;
+
+    memcpy(buf, "\x93NUMPY\x01\x00", 8);
+    if (cols < 0)
+        len = snprintf(buf + 10, NPY_HEADER_SIZE - 10,
+                       "{'descr': '%s', 'fortran_order': False, "
+                       "'shape': (%ld,), }", descr, rows);
+    else
+        len = snprintf(buf + 10, NPY_HEADER_SIZE - 10,
+                       "{'descr': '%s', 'fortran_order': False, "
+                       "'shape': (%ld, %ld), }", descr, rows, cols);
+
+    /* Pad to 64 bytes including newline */
+    len += 10;
+    while ((len + 1) % 64 != 0)
+        buf[len++] = ' ';
+    buf[len++] = '\n';
+
+    buf[8] = (len - 10) & 0xff;
+    buf[9] = (len - 10) >> 8;
+
+    /* Data is written in native byte order */
+    if (*((char *) &one) == 0 && buf[21] == '<')
+        buf[21] = '>';
+
+    return len;
+}
+
+/**
+ * Writes a little-endian integer to a buffer
+ * @param buf Buffer
+ * @param v Value
+ * @param n Number of bytes
+ * @return pointer after integer
+ */
+static char *put_int(char *buf, uint64_t v, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        buf[i] = (v >> (8 * i)) & 0xff;
+    return buf + n;
+}
+
+/**
+ * Starts an entry in the zip archive by writing its local header. The
+ * checksum is patched when the entry is finished.
+ * @param name Name of entry
+ * @param size Size of entry in bytes
+ * @return true on success, false otherwise
+ */
+static int npz_begin(char *name, uint64_t size)
+{
+    char buf[128], *p = buf;
+    npy_entry_t *e;
+    int zip64 = size >= 0xffffffff;
+
+    if (!npz)
+        return TRUE;
+
+    assert(num_entries < NPZ_MAX_ENTRIES);
+    e = &entries[num_entries++];
+    snprintf(e->name, sizeof(e->name), "%s.npy", name);
+    e->size = size;
+    e->offset = pos;
+
+    p = put_int(p, 0x04034b50, 4);
+    p = put_int(p, zip64 ? 45 : 20, 2);
+    p = put_int(p, 0, 2);       /* flags */
+    p = put_int(p, 0, 2);       /* stored */
+    p = put_int(p, 0, 2);       /* time */
+    p = put_int(p, 0x21, 2);    /* date: 1980-01-01 */
+    p = put_int(p, 0, 4);       /* crc, patched later */
+    p = put_int(p, zip64 ? 0xffffffff : size, 4);
+    p = put_int(p, zip64 ? 0xffffffff : size, 4);
+    p = put_int(p, strlen(e->name), 2);
+    p = put_int(p, zip64 ? 20 : 0, 2);
+    memcpy(p, e->name, strlen(e->name));
+    p += strlen(e->name);
+
+    if (zip64) {
+        p = put_int(p, 0x0001, 2);
+        p = put_int(p, 16, 2);
+        p = put_int(p, size, 8);
+        p = put_int(p, size, 8);
+    }
+
+    if (!npy_write(buf, p - buf))
+        return FALSE;
+
+    crc = 0;
+    return TRUE;
+}
+
+/**
+ * Finishes an entry in the zip archive by patching its checksum.
+ * @return true on success, false otherwise
+ */
+static int npz_end()
+{
+    char buf[4];
+    npy_entry_t *e;
+
+    if (!npz)
+        return TRUE;
+
+    e = &entries[num_entries - 1];
+    e->crc = crc;
+    put_int(buf, crc, 4);
+    if (pwrite(fd, buf, 4, e->offset + 14) != 4) {
+        error("Failed to update checksum in npz file");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Writes the central directory of the zip archive. Zip64 records are
+ * added if the archive exceeds 4 GB.
+ * @return true on success, false otherwise
+ */
+static int npz_finish()
+{
+    char buf[256], *p;
+    uint64_t start = pos, size;
+    int i, n, zip64;
+
+    for (i = 0; i < num_entries; i++) {
+        npy_entry_t *e = &entries[i];
+        n = strlen(e->name);
+        zip64 = e->size >= 0xffffffff || e->offset >= 0xffffffff;
+
+        p = put_int(buf, 0x02014b50, 4);
+        p = put_int(p, zip64 ? 45 : 20, 2);
+        p = put_int(p, zip64 ? 45 : 20, 2);
+        p = put_int(p, 0, 2);
+        p = put_int(p, 0, 2);
+        p = put_int(p, 0, 2);
+        p = put_int(p, 0x21, 2);
+        p = put_int(p, e->crc, 4);
+        p = put_int(p, zip64 ? 0xffffffff : e->size, 4);
+        p = put_int(p, zip64 ? 0xffffffff : e->size, 4);
+        p = put_int(p, n, 2);
+        p = put_int(p, zip64 ? 28 : 0, 2);
+        p = put_int(p, 0, 2);   /* comment */
+        p = put_int(p, 0, 2);   /* disk */
+        p = put_int(p, 0, 2);   /* internal attributes */
+        p = put_int(p, 0, 4);   /* external attributes */
+        p = put_int(p, zip64 ? 0xffffffff : e->offset, 4);
+        memcpy(p, e->name, n);
+        p += n;
+
+        if (zip64) {
+            p = put_int(p, 0x0001, 2);
+            p = put_int(p, 24, 2);
+            p = put_int(p, e->size, 8);
+            p = put_int(p, e->size, 8);
+            p = put_int(p, e->offset, 8);
+        }
+
+        if (!npy_write(buf, p - buf))
+            return FALSE;
+    }
+
+    size = pos - start;
+    p = buf;
+    if (start >= 0xffffffff) {
+        /* Zip64 end of central directory record and locator */
+        p = put_int(p, 0x06064b50, 4);
+        p = put_int(p, 44, 8);
+        p = put_int(p, 45, 2);
+        p = put_int(p, 45, 2);
+        p = put_int(p, 0, 4);
+        p = put_int(p, 0, 4);
+        p = put_int(p, num_entries, 8);
+        p = put_int(p, num_entries, 8);
+        p = put_int(p, size, 8);
+        p = put_int(p, start, 8);
+        p = put_int(p, 0x07064b50, 4);
+        p = put_int(p, 0, 4);
+        p = put_int(p, pos, 8);
+        p = put_int(p, 1, 4);
+    }
+
+    p = put_int(p, 0x06054b50, 4);
+    p = put_int(p, 0, 2);
+    p = put_int(p, 0, 2);
+    p = put_int(p, num_entries, 2);
+    p = put_int(p, num_entries, 2);
+    p = put_int(p, size, 4);
+    p = put_int(p, MIN(start, 0xffffffff), 4);
+    p = put_int(p, 0, 2);
+
+    return npy_write(buf, p - buf);
+}
+
+/**
+ * Writes a vector as npy array
+ * @param name Name of array in archive
+ * @param descr Description of dtype
+ * @param data Array data
+ * @param num Number of elements
+ * @param size Size of an element
+ * @return number of written elements
+ */
+static int npy_vector(char *name, char *descr, void *data, int num, int size)
+{
+    char hdr[NPY_HEADER_SIZE];
+    int len = npy_header(hdr, descr, num, -1);
+
+    if (!npz_begin(name, len + (uint64_t) num * size))
+        return 0;
+    if (!npy_write(hdr, len) || !npy_write(data, (size_t) num * size))
+        return 0;
+    if (!npz_end())
+        return 0;
+
+    return num;
+}
+
+/**
+ * Writes a range of indices as npy array
+ * @param ra Range structure
+ * @param name Name of array
+ * @return number of written elements
+ */
+static int npy_range(range_t ra, char *name)
+{
+    int i, r, n = ra.end - ra.start;
+    uint32_t *data = malloc(sizeof(uint32_t) * MAX(n, 1));
+
+    if (!data) {
+        error("Could not allocate memory for indices");
+        return 0;
+    }
+
+    for (i = 0; i < n; i++)
+        data[i] = ra.start + i;
+
+    r = npy_vector(name, "<u4", data, n, sizeof(uint32_t));
+    free(data);
+    return r;
+}
+
+/**
+ * Writes sources as npy array of fixed-length byte strings
+ * @param ra Range structure
+ * @param srcs Array of all sources
+ * @param name Name of array
+ * @return number of written elements
+ */
+static int npy_sources(range_t ra, char **srcs, char *name)
+{
+    int i, r, l = 1, n = ra.end - ra.start;
+    char descr[32], *data;
+
+    for (i = ra.start; i < ra.end; i++)
+        if (srcs[i])
+            l = MAX(l, (int) strlen(srcs[i]));
+
+    data = calloc(MAX(n, 1), l);
+    if (!data) {
+        error("Could not allocate memory for sources");
+        return 0;
+    }
+
+    for (i = ra.start; i < ra.end; i++)
+        if (srcs[i])
+            memcpy(data + (i - ra.start) * l, srcs[i], strlen(srcs[i]));
+
+    snprintf(descr, sizeof(descr), "|S%d", l);
+    r = npy_vector(name, descr, data, n, l);
+    free(data);
+    return r;
+}
+
+/**
+ * Writes the similarity matrix as npy array. The rows are converted in
+ * bands and written using few large calls to write().
+ * @param m Matrix of similarity values
+ * @return number of written values
+ */
+static int npy_matrix(hmatrix_t *m)
+{
+    char hdr[NPY_HEADER_SIZE];
+    long rows, cols, len;
+    int i, band, ret = 0, hlen;
+    float *buf;
+
+    rows = m->row.end - m->row.start;
+    cols = m->col.end - m->col.start;
+    hlen = npy_header(hdr, "<f4", rows, cols);
+
+    if (!npz_begin("matrix", hlen + (uint64_t) rows * cols * sizeof(float)))
+        return 0;
+    if (!npy_write(hdr, hlen))
+        return 0;
+
+    band = output_band_rows(m);
+    buf = malloc(sizeof(float) * band * cols);
+    if (!buf) {
+        error("Could not allocate buffer for npy matrix");
+        return 0;
+    }
+
+    for (i = m->row.start; i < m->row.end; i += band) {
+        len = output_get_rows(m, i, MIN(i + band, m->row.end),
+                              precision, buf);
+        if (!npy_write(buf, sizeof(float) * len))
+            break;
+        ret += len;
+    }
+
+    free(buf);
+    if (!npz_end())
+        return 0;
+
+    return ret;
+}
+
+/**
+ * Opens a file for writing npy format
+ * @param fn File name
+ * @return true on success, false otherwise
+ */
+int output_npy_open(char *fn)
+{
+    config_lookup_int(&cfg, "output.precision", &precision);
+    config_lookup_bool(&cfg, "output.save_indices", &save_indices);
+    config_lookup_bool(&cfg, "output.save_labels", &save_labels);
+    config_lookup_bool(&cfg, "output.save_sources", &save_sources);
+
+    fd = open(fn, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        error("Could not open output file '%s'.", fn);
+        return FALSE;
+    }
+
+    pos = 0;
+    num_entries = 0;
+    return TRUE;
+}
+
+/**
+ * Opens a file for writing npz format
+ * @param fn File name
+ * @return true on success, false otherwise
+ */
+int output_npz_open(char *fn)
+{
+    npz = TRUE;
+    return output_npy_open(fn);
+}
+
+/**
+ * Write similarity matrix to output
+ * @param m Matrix of similarity values
+ * @return Number of written values
+ */
+int output_npy_write(hmatrix_t *m)
+{
+    int r = npy_matrix(m);
+
+    if (!npz)
+        return r;
+
+    /* Save indices as vectors */
+    if (save_indices) {
+        npy_range(m->col, "x_indices");
+        npy_range(m->row, "y_indices");
+    }
+
+    /* Save labels as vectors */
+    if (save_labels) {
+        npy_vector("x_labels", "<f4", m->labels + m->col.start,
+                   m->col.end - m->col.start, sizeof(float));
+        npy_vector("y_labels", "<f4", m->labels + m->row.start,
+                   m->row.end - m->row.start, sizeof(float));
+    }
+
+    /* Save sources as vectors */
+    if (save_sources) {
+        npy_sources(m->col, m->srcs, "x_sources");
+        npy_sources(m->row, m->srcs, "y_sources");
+    }
+
+    npz_finish();
+    return r;
+}
+
+/**
+ * Closes an open output file.
+ */
+void output_npy_close()
+{
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+    npz = FALSE;
+}
+
+/** @} */
@@ -0,0 +1,37 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef OUTPUT_NPY_H
+#define OUTPUT_NPY_H
+
+/** Maximum size of npy header */
+#define NPY_HEADER_SIZE     256
+/** Maximum number of entries in npz archive */
+#define NPZ_MAX_ENTRIES     8
+
+/**
+ * Entry of npz archive
+ */
+typedef struct
+{
+    char name[32];              /**< Name of entry */
+    uint32_t crc;               /**< CRC32 checksum */
+    uint64_t size;              /**< Size of entry */
+    uint64_t offset;            /**< Offset of local header */
+} npy_entry_t;
+
+/* npy output module */
+int output_npy_open(char *);
+int output_npz_open(char *);
+int output_npy_write(hmatrix_t *);
+void output_npy_close(void);
+
+#endif /* OUTPUT_NPY_H */
@@ -0,0 +1,105 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/**
+ * @addtogroup output
+ * <hr>
+ * Output of sparse pairs in text format. Joins only determine the pairs
+ * of strings passing a threshold. Each pair is written as one line with
+ * the index of the column string, the index of the row string and the
+ * similarity value. The output format "null" discards the pairs.
+ * @{
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "output.h"
+#include "ostream.h"
+#include "output_pairs.h"
+#include "harry.h"
+
+/* External variables */
+extern config_t cfg;
+
+/* Local variables */
+static ostream_t *z = NULL;
+static cfg_int precision = 0;
+static const char *separator = ",";
+
+/**
+ * Opens a file for writing sparse pairs
+ * @param fn File name or "-" for standard output
+ * @return true if successful, false otherwise
+ */
+int output_pairs_open(char *fn)
+{
+    const char *format;
+
+    assert(fn);
+
+    config_lookup_string(&cfg, "output.output_format", &format);
+    config_lookup_string(&cfg, "output.separator", &separator);
+    config_lookup_int(&cfg, "output.precision", &precision);
+
+    if (!strcasecmp(format, "null"))
+        return TRUE;
+    if (strcasecmp(format, "text") && strcasecmp(format, "stdout"))
+        warning("Pairs are written in text format instead of '%s'.",
+                format);
+
+    z = ostream_open(strcmp(fn, "-") ? fn : NULL);
+    if (!z) {
+        error("Could not open output file '%s'.", fn);
+        return FALSE;
+    }
+
+    ostream_printf(z, "# Harry %s - Output module for sparse pairs\n",
+                   PACKAGE_VERSION);
+    return TRUE;
+}
+
+/**
+ * Write sparse pairs to output
+ * @param p List of pairs
+ * @return Number of written pairs
+ */
+long output_pairs_write(hpairs_t *p)
+{
+    long i;
+
+    assert(p);
+    if (!z)
+        return p->num;
+
+    for (i = 0; i < p->num; i++) {
+        hpair_t *e = p->pairs + i;
+        if (ostream_printf(z, "%d%s%d%s%g\n", e->x, separator, e->y,
+                           separator, hround(e->v, precision)) < 0) {
+            error("Could not write to output file");
+            return -i;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * Closes an open output file.
+ */
+void output_pairs_close()
+{
+    if (z)
+        ostream_close(z);
+    z = NULL;
+}
+
+/** @} */
@@ -0,0 +1,22 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef OUTPUT_PAIRS_H
+#define OUTPUT_PAIRS_H
+
+#include "hpairs.h"
+
+/* Output of sparse pairs */
+int output_pairs_open(char *);
+long output_pairs_write(hpairs_t *);
+void output_pairs_close(void);
+
+#endif /* OUTPUT_PAIRS_H */
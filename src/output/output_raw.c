@@ -13,7 +13,7 @@
  * @addtogroup output
  * <hr>
  * <em>raw</em>: The matrix of similarity/dissimilarity measures is written
- * to standard output in raw format.
+ * to a file or standard output in raw format.
  *
  * This module is designed for efficiently interfacing with other
  * environments.  The raw format of a similarity matrix has the form
@@ -38,18 +38,27 @@ extern config_t cfg;
 
 /* Local variables */
 static cfg_int precision = 0;
+static int fd = -1;
 
 /**
- * Opens a file for writing raw format
- * @param fn File name (bogus)
+ * Opens a file for writing raw format. If the file name is "=" or "-",
+ * the matrix is written to standard output.
+ * @param fn File name
  * @return true on sucess, false otherwise
  */
 int output_raw_open(char *fn)
 {
     config_lookup_int(&cfg, "output.precision", &precision);
 
-    if (!stdout) {
-        error("Could not open <stdout>");
+    if (!strcmp(fn, "=") || !strcmp(fn, "-")) {
+        fflush(stdout);
+        fd = STDOUT_FILENO;
+    } else {
+        fd = open(fn, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    }
+
+    if (fd < 0) {
+        error("Could not open output file '%s'", fn);
         return FALSE;
     }
 
@@ -57,40 +66,46 @@ int output_raw_open(char *fn)
 }
 
 /**
- * Write similarity matrux to output
+ * Write similarity matrux to output. The matrix is converted in bands of
+ * rows that are written using few large calls to write().
  * @param m Matrix of similarity values
  * @return Number of written values
  */
 int output_raw_write(hmatrix_t *m)
 {
     assert(m);
-    uint32_t ret, rows, cols, fsize, i, j;
+    uint32_t hdr[3];
+    int i, band, ret = 0;
+    float *buf;
+    long len;
 
-    rows = m->row.end - m->row.start;
-    cols = m->col.end - m->col.start;
-    fsize = sizeof(float);
+    hdr[0] = m->row.end - m->row.start;
+    hdr[1] = m->col.end - m->col.start;
+    hdr[2] = sizeof(float);
 
-    ret = fwrite(&rows, sizeof(rows), 1, stdout);
-    ret += fwrite(&cols, sizeof(cols), 1, stdout);
-    ret += fwrite(&fsize, sizeof(fsize), 1, stdout);
-    if (ret != 3) {
-        error("Failed to write raw matrix header to stdout");
+    if (!output_fdwrite(fd, hdr, sizeof(hdr))) {
+        error("Failed to write raw matrix header");
         return 0;
     }
 
-    for (i = m->row.start; i < m->row.end; i++) {
-        for (j = m->col.start; j < m->col.end; j++) {
-            float val = hround(hmatrix_get(m, j, i), precision);
-            ret = fwrite(&val, sizeof(float), 1, stdout);
-            if (ret != 1) {
-                error("Failed to write raw matrix data to stdout");
-                return ret;
-            }
-        }
+    band = output_band_rows(m);
+    buf = malloc(sizeof(float) * band * hdr[1]);
+    if (!buf) {
+        error("Could not allocate buffer for raw matrix");
+        return 0;
     }
 
+    for (i = m->row.start; i < m->row.end; i += band) {
+        len = output_get_rows(m, i, MIN(i + band, m->row.end),
+                              precision, buf);
+        if (!output_fdwrite(fd, buf, sizeof(float) * len)) {
+            error("Failed to write raw matrix data");
+            break;
+        }
+        ret += len;
+    }
 
-
+    free(buf);
     return ret;
 }
 
@@ -99,7 +114,9 @@ int output_raw_write(hmatrix_t *m)
  */
 void output_raw_close()
 {
-    /* Do nothing */
+    if (fd >= 0 && fd != STDOUT_FILENO)
+        close(fd);
+    fd = -1;
 }
 
 /** @} */
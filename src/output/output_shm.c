@@ -0,0 +1,135 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+/**
+ * @addtogroup output
+ * <hr>
+ * <em>shm</em>: The matrix of similarity/dissimilarity measures is written
+ * to a POSIX shared-memory segment, such that a local process can map the
+ * matrix without copying it through a pipe.  The segment has the form
+ * <pre>
+ * | header (64 bytes) | array (float) ... |
+ * </pre>
+ * where the header is described by shm_header_t.  The segment is not
+ * removed by Harry, that is, the consumer needs to unlink it.
+ * @{
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "output.h"
+#include "harry.h"
+#include "output_shm.h"
+
+#ifdef HAVE_SHM_OPEN
+#include <sys/mman.h>
+#endif
+
+/* External variables */
+extern config_t cfg;
+
+/* Local variables */
+static cfg_int precision = 0;
+static char *name = NULL;
+
+/**
+ * Opens a shared-memory segment for writing. The segment is created when
+ * the matrix is written, as its size is not known before.
+ * @param fn Name of segment, e.g. "/harry"
+ * @return true on success, false otherwise
+ */
+int output_shm_open(char *fn)
+{
+    config_lookup_int(&cfg, "output.precision", &precision);
+
+#ifndef HAVE_SHM_OPEN
+    error("Shared memory is not supported on this platform.");
+    return FALSE;
+#endif
+
+    if (fn[0] != '/' || strchr(fn + 1, '/')) {
+        error("Invalid name of shared memory '%s'.", fn);
+        return FALSE;
+    }
+
+    name = strdup(fn);
+    return name != NULL;
+}
+
+/**
+ * Write similarity matrix to a shared-memory segment. The rows are
+ * converted in parallel directly into the mapped segment.
+ * @param m Matrix of similarity values
+ * @return Number of written values
+ */
+int output_shm_write(hmatrix_t *m)
+{
+    int ret = 0;
+#ifdef HAVE_SHM_OPEN
+    shm_header_t h;
+    size_t size;
+    char *seg;
+    int fd;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SHM_MAGIC, 8);
+    h.version = SHM_VERSION;
+    h.hsize = SHM_HEADER_SIZE;
+    h.rows = m->row.end - m->row.start;
+    h.cols = m->col.end - m->col.start;
+    h.fsize = sizeof(float);
+    h.row_start = m->row.start;
+    h.col_start = m->col.start;
+
+    size = SHM_HEADER_SIZE + (size_t) h.rows * h.cols * sizeof(float);
+
+    fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0) {
+        error("Could not open shared memory '%s'.", name);
+        return 0;
+    }
+
+    if (ftruncate(fd, size) < 0) {
+        error("Could not resize shared memory '%s'.", name);
+        close(fd);
+        shm_unlink(name);
+        return 0;
+    }
+
+    seg = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (seg == MAP_FAILED) {
+        error("Could not map shared memory '%s'.", name);
+        shm_unlink(name);
+        return 0;
+    }
+
+    memset(seg, 0, SHM_HEADER_SIZE);
+    memcpy(seg, &h, sizeof(h));
+    ret = output_get_rows(m, m->row.start, m->row.end, precision,
+                          (float *) (seg + SHM_HEADER_SIZE));
+
+    munmap(seg, size);
+#endif
+    return ret;
+}
+
+/**
+ * Closes the output. The segment is kept for the consumer.
+ */
+void output_shm_close()
+{
+    free(name);
+    name = NULL;
+}
+
+/** @} */
@@ -0,0 +1,42 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef OUTPUT_SHM_H
+#define OUTPUT_SHM_H
+
+/** Magic string of shared-memory segments */
+#define SHM_MAGIC           "HARRYSHM"
+/** Version of segment layout */
+#define SHM_VERSION         1
+/** Size of header, such that the matrix is aligned */
+#define SHM_HEADER_SIZE     64
+
+/**
+ * Header of shared-memory segment
+ */
+typedef struct
+{
+    char magic[8];              /**< Magic string */
+    uint32_t version;           /**< Version of layout */
+    uint32_t hsize;             /**< Size of header in bytes */
+    uint32_t rows;              /**< Number of rows */
+    uint32_t cols;              /**< Number of columns */
+    uint32_t fsize;             /**< Size of a float in bytes */
+    uint32_t row_start;         /**< Index of first row */
+    uint32_t col_start;         /**< Index of first column */
+} shm_header_t;
+
+/* Shared-memory output module */
+int output_shm_open(char *);
+int output_shm_write(hmatrix_t *);
+void output_shm_close(void);
+
+#endif /* OUTPUT_SHM_H */
@@ -21,6 +21,7 @@
 #include "common.h"
 #include "util.h"
 #include "output.h"
+#include "ostream.h"
 #include "harry.h"
 
 
@@ -31,20 +32,11 @@ extern config_t cfg;
 static int save_indices = 0;
 static int save_labels = 0;
 static int save_sources = 0;
-static int zlib = 0;
 static cfg_int precision = 0;
 
-static void *z = NULL;
+static ostream_t *z = NULL;
 static const char *separator = ",";
 
-/* Dirty hack to support compression */
-#define output_printf(z, ...) (\
-   zlib ? \
-       gzprintf((gzFile) z, __VA_ARGS__) \
-   : \
-       fprintf((FILE *) z, __VA_ARGS__) \
-)
-
 
 /**
  * Opens a file for writing stdout format
@@ -56,16 +48,10 @@ int output_stdout_open(char *fn)
     config_lookup_bool(&cfg, "output.save_indices", &save_indices);
     config_lookup_bool(&cfg, "output.save_labels", &save_labels);
     config_lookup_bool(&cfg, "output.save_sources", &save_sources);
-    config_lookup_bool(&cfg, "output.compress", &zlib);
     config_lookup_string(&cfg, "output.separator", &separator);
     config_lookup_int(&cfg, "output.precision", &precision);
 
-    /* Init source */
-    if (zlib) {
-        z = gzdopen(2, "w9");
-    } else {
-        z = stdout;
-    }
+    z = ostream_open(NULL);
 
     if (!z) {
         error("Could not open output file '%s'.", fn);
@@ -73,11 +59,8 @@ int output_stdout_open(char *fn)
     }
 
     /* Write harry header */
-    if (zlib) {
-        harry_zversion(z, "# ", "Output module for stdout format");
-    } else {
-        harry_version(z, "# ", "Output module for stdout format");
-    }
+    ostream_printf(z, "# Harry %s - Output module for stdout format\n",
+                   PACKAGE_VERSION);
 
     return TRUE;
 }
@@ -93,57 +76,57 @@ int output_stdout_write(hmatrix_t *m)
     int i, j, r, k = 0;
 
     if (save_indices) {
-        output_printf(z, "#");
+        ostream_printf(z, "#");
         for (j = m->col.start; j < m->col.end; j++) {
-            output_printf(z, " %d", j);
+            ostream_printf(z, " %d", j);
         }
-        output_printf(z, "\n");
+        ostream_printf(z, "\n");
     }
 
     if (save_labels) {
-        output_printf(z, "#");
+        ostream_printf(z, "#");
         for (j = m->col.start; j < m->col.end; j++) {
-            output_printf(z, " %g", m->labels[j]);
+            ostream_printf(z, " %g", m->labels[j]);
         }
-        output_printf(z, "\n");
+        ostream_printf(z, "\n");
     }
 
     if (save_sources) {
-        output_printf(z, "#");
+        ostream_printf(z, "#");
         for (j = m->col.start; j < m->col.end; j++) {
-            output_printf(z, " %s", m->srcs[j]);
+            ostream_printf(z, " %s", m->srcs[j]);
         }
-        output_printf(z, "\n");
+        ostream_printf(z, "\n");
     }
 
     for (i = m->row.start; i < m->row.end; i++) {
         for (j = m->col.start; j < m->col.end; j++) {
             float val = hround(hmatrix_get(m, j, i), precision);
-            r = output_printf(z, "%g", val);
+            r = ostream_printf(z, "%g", val);
             if (r < 0) {
                 error("Could not write to output file");
                 return -k;
             }
 
             if (j < m->col.end - 1)
-                output_printf(z, "%s", separator);
+                ostream_printf(z, "%s", separator);
 
             k++;
         }
 
         if (save_indices || save_labels || save_sources)
-            output_printf(z, " #");
+            ostream_printf(z, " #");
 
         if (save_indices)
-            output_printf(z, " %d", i);
+            ostream_printf(z, " %d", i);
 
         if (save_labels)
-            output_printf(z, " %g", m->labels[i]);
+            ostream_printf(z, " %g", m->labels[i]);
 
         if (save_sources)
-            output_printf(z, " %s", m->srcs[i]);
+            ostream_printf(z, " %s", m->srcs[i]);
 
-        output_printf(z, "\n");
+        ostream_printf(z, "\n");
     }
 
     return k;
@@ -154,10 +137,8 @@ int output_stdout_write(hmatrix_t *m)
  */
 void output_stdout_close()
 {
-    if (zlib)
-        gzclose(z);
-    else
-        fclose(z);
+    ostream_close(z);
+    z = NULL;
 }
 
 /** @} */
@@ -21,6 +21,7 @@
 #include "common.h"
 #include "util.h"
 #include "output.h"
+#include "ostream.h"
 #include "harry.h"
 
 
@@ -28,8 +29,7 @@
 extern config_t cfg;
 
 /* Local variables */
-static void *z = NULL;
-static int zlib = 0;
+static ostream_t *z = NULL;
 static int save_indices = 0;
 static int save_labels = 0;
 static int save_sources = 0;
@@ -37,13 +37,6 @@ static cfg_int precision = 0;
 
 static const char *separator = ",";
 
-#define output_printf(z, ...) (\
-   zlib ? \
-       gzprintf((gzFile) z, __VA_ARGS__) \
-   : \
-       fprintf((FILE *) z, __VA_ARGS__) \
-)
-
 /**
  * Opens a file for writing text format
  * @param fn File name
@@ -57,13 +50,9 @@ int output_text_open(char *fn)
     config_lookup_bool(&cfg, "output.save_labels", &save_labels);
     config_lookup_bool(&cfg, "output.save_sources", &save_sources);
     config_lookup_string(&cfg, "output.separator", &separator);
-    config_lookup_bool(&cfg, "output.compress", &zlib);
     config_lookup_int(&cfg, "output.precision", &precision);
 
-    if (zlib)
-        z = gzopen(fn, "w9");
-    else
-        z = fopen(fn, "w");
+    z = ostream_open(fn);
 
     if (!z) {
         error("Could not open output file '%s'.", fn);
@@ -71,10 +60,8 @@ int output_text_open(char *fn)
     }
 
     /* Write harry header */
-    if (zlib)
-        harry_zversion(z, "# ", "Output module for text format");
-    else
-        harry_version(z, "# ", "Output module for text format");
+    ostream_printf(z, "# Harry %s - Output module for text format\n",
+                   PACKAGE_VERSION);
 
     return TRUE;
 }
@@ -90,57 +77,57 @@ int output_text_write(hmatrix_t *m)
     int i, j, r, k = 0;
 
     if (save_indices) {
-        output_printf(z, "#");
+        ostream_printf(z, "#");
         for (j = m->col.start; j < m->col.end; j++) {
-            output_printf(z, " %d", j);
+            ostream_printf(z, " %d", j);
         }
-        output_printf(z, "\n");
+        ostream_printf(z, "\n");
     }
 
     if (save_labels) {
-        output_printf(z, "#");
+        ostream_printf(z, "#");
         for (j = m->col.start; j < m->col.end; j++) {
-            output_printf(z, " %g", m->labels[j]);
+            ostream_printf(z, " %g", m->labels[j]);
         }
-        output_printf(z, "\n");
+        ostream_printf(z, "\n");
     }
 
     if (save_sources) {
-        output_printf(z, "#");
+        ostream_printf(z, "#");
         for (j = m->col.start; j < m->col.end; j++) {
-            output_printf(z, " %s", m->srcs[j]);
+            ostream_printf(z, " %s", m->srcs[j]);
         }
-        output_printf(z, "\n");
+        ostream_printf(z, "\n");
     }
 
     for (i = m->row.start; i < m->row.end; i++) {
         for (j = m->col.start; j < m->col.end; j++) {
             float val = hround(hmatrix_get(m, j, i), precision);
-            r = output_printf(z, "%g", val);
+            r = ostream_printf(z, "%g", val);
             if (r < 0) {
                 error("Could not write to output file");
                 return -k;
             }
 
             if (j < m->col.end - 1)
-                output_printf(z, "%s", separator);
+                ostream_printf(z, "%s", separator);
 
             k++;
         }
 
         if (save_indices || save_labels || save_sources)
-            output_printf(z, " #");
+            ostream_printf(z, " #");
 
         if (save_indices)
-            output_printf(z, " %d", i);
+            ostream_printf(z, " %d", i);
 
         if (save_labels)
-            output_printf(z, " %g", m->labels[i]);
+            ostream_printf(z, " %g", m->labels[i]);
 
         if (save_sources)
-            output_printf(z, " %s", m->srcs[i]);
+            ostream_printf(z, " %s", m->srcs[i]);
 
-        output_printf(z, "\n");
+        ostream_printf(z, "\n");
     }
 
     return k;
@@ -151,12 +138,8 @@ int output_text_write(hmatrix_t *m)
  */
 void output_text_close()
 {
-    if (z) {
-        if (zlib)
-            gzclose(z);
-        else
-            fclose(z);
-    }
+    ostream_close(z);
+    z = NULL;
 }
 
 /** @} */
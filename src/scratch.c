@@ -0,0 +1,179 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "scratch.h"
+
+/**
+ * @defgroup scratch Scratch memory
+ * Per-thread arenas for temporary memory of the similarity measures. Each
+ * thread allocates from its own arena without locking. The memory is
+ * returned at once by releasing the arena to a mark taken before a
+ * comparison, such that the blocks of an arena are reused and no memory
+ * is freed during the computation.
+ * @{
+ */
+
+/* Arena of the current thread */
+static scratch_t arena;
+#ifdef HAVE_OPENMP
+#pragma omp threadprivate(arena)
+#endif
+
+/* List of arenas for statistics */
+static scratch_t *arenas = NULL;
+
+/**
+ * Allocate a new block for the current arena. Empty blocks following the
+ * current one are reused if they are large enough.
+ * @param size Minimum size of block
+ * @return block or NULL on error
+ */
+static scratch_block_t *scratch_grow(size_t size)
+{
+    scratch_block_t *b, *cur = arena.cur;
+    size_t min = cur ? 2 * cur->size : SCRATCH_BLOCK;
+
+    /* Reuse next block */
+    if (cur && cur->next && cur->next->size >= size)
+        return cur->next;
+
+    b = calloc(1, sizeof(scratch_block_t));
+    if (!b)
+        return NULL;
+
+    b->size = MAX(size, min);
+    if (posix_memalign((void **) &b->data, SCRATCH_ALIGN, b->size)) {
+        free(b);
+        return NULL;
+    }
+
+    /* Insert block after current one */
+    if (!cur) {
+        b->next = arena.first;
+        arena.first = b;
+#ifdef HAVE_OPENMP
+#pragma omp critical (scratch)
+#endif
+        if (arena.blocks == 0) {
+            arena.next = arenas;
+            arenas = &arena;
+        }
+    } else {
+        b->next = cur->next;
+        cur->next = b;
+    }
+
+    arena.blocks++;
+    return b;
+}
+
+/**
+ * Allocate memory from the arena of the current thread. The memory is
+ * valid until the arena is released to an earlier mark.
+ * @param size Size of memory
+ * @return memory or NULL on error
+ */
+void *scratch_alloc(size_t size)
+{
+    scratch_block_t *b = arena.cur;
+    void *p;
+
+    size = (size + SCRATCH_ALIGN - 1) & ~((size_t) SCRATCH_ALIGN - 1);
+
+    if (!b || b->used + size > b->size) {
+        b = scratch_grow(size);
+        if (!b) {
+            error("Could not allocate scratch memory");
+            return NULL;
+        }
+        b->used = 0;
+        arena.cur = b;
+    }
+
+    p = b->data + b->used;
+    b->used += size;
+    arena.used += size;
+    arena.peak = MAX(arena.peak, arena.used);
+    arena.allocs++;
+
+    return p;
+}
+
+/**
+ * Allocate zeroed memory from the arena of the current thread.
+ * @param num Number of elements
+ * @param size Size of elements
+ * @return memory or NULL on error
+ */
+void *scratch_calloc(size_t num, size_t size)
+{
+    void *p = scratch_alloc(num * size);
+    if (p)
+        memset(p, 0, num * size);
+    return p;
+}
+
+/**
+ * Mark the current position in the arena of the current thread
+ * @return mark
+ */
+scratch_mark_t scratch_mark()
+{
+    scratch_mark_t m;
+
+    m.block = arena.cur;
+    m.pos = arena.cur ? arena.cur->used : 0;
+    m.used = arena.used;
+    return m;
+}
+
+/**
+ * Release all memory allocated in the arena of the current thread after
+ * a mark. The blocks are kept for later allocations.
+ * @param m Mark
+ */
+void scratch_release(scratch_mark_t m)
+{
+    /* Following blocks are emptied when they are reached again */
+    if (!m.block)
+        m.block = arena.first;
+    if (m.block)
+        m.block->used = m.pos;
+
+    arena.cur = m.block;
+    arena.used = m.used;
+}
+
+/**
+ * Display statistics of the scratch arenas
+ */
+void scratch_info()
+{
+    long allocs = 0, blocks = 0;
+    size_t peak = 0;
+    int num = 0;
+    scratch_t *a;
+
+    for (a = arenas; a; a = a->next, num++) {
+        allocs += a->allocs;
+        blocks += a->blocks;
+        peak += a->peak;
+    }
+
+    info_msg(1, "Scratch stats: %ld allocations in %d arenas, "
+             "%ld blocks, %.1fMb peak.", allocs, num, blocks,
+             peak / (1024.0 * 1024.0));
+}
+
+/** @} */
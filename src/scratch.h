@@ -0,0 +1,61 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+/** Alignment of scratch memory */
+#define SCRATCH_ALIGN           32
+/** Size of first block of an arena */
+#define SCRATCH_BLOCK           (64 * 1024)
+
+/**
+ * Block of scratch memory
+ */
+typedef struct scratch_block
+{
+    char *data;                 /**< Memory of block */
+    size_t size;                /**< Size of block */
+    size_t used;                /**< Used bytes of block */
+    struct scratch_block *next; /**< Next block */
+} scratch_block_t;
+
+/**
+ * Scratch arena of one thread
+ */
+typedef struct scratch
+{
+    scratch_block_t *first;     /**< First block */
+    scratch_block_t *cur;       /**< Current block */
+    size_t used;                /**< Used bytes of all blocks */
+    size_t peak;                /**< Peak of used bytes */
+    long allocs;                /**< Number of allocations */
+    long blocks;                /**< Number of allocated blocks */
+    struct scratch *next;       /**< Next arena of all threads */
+} scratch_t;
+
+/**
+ * Position in a scratch arena
+ */
+typedef struct
+{
+    scratch_block_t *block;     /**< Current block */
+    size_t pos;                 /**< Used bytes of current block */
+    size_t used;                /**< Used bytes of all blocks */
+} scratch_mark_t;
+
+void *scratch_alloc(size_t);
+void *scratch_calloc(size_t, size_t);
+scratch_mark_t scratch_mark();
+void scratch_release(scratch_mark_t);
+void scratch_info();
+
+#endif /* SCRATCH_H */
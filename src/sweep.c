@@ -0,0 +1,572 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "measures.h"
+#include "sweep.h"
+
+/**
+ * @defgroup sweep Parameter sweeps
+ * Computation of several variants of a similarity measure from one pass
+ * over the strings. The raw values of the measure are computed once for
+ * all pairs of strings together with a few values per string, such as the
+ * lengths of the strings, the kernel values of the strings with
+ * themselves and the distances to the empty string. The variants given by
+ * the parameter "sweep" are then derived from these values without
+ * comparing strings again.
+ *
+ * A sweep is a list of variants separated by semicolons. Each variant is
+ * a list of assignments separated by commas, for example
+ * "type=rbf,gamma=0.1; type=rbf,gamma=1; type=poly,degree=2,norm=l2".
+ * Parameters that are not assigned keep their configured value.
+ * @{
+ */
+
+/* External variables */
+extern config_t cfg;
+
+/**
+ * Families of measures supporting sweeps
+ */
+typedef enum
+{
+    SW_PLAIN,                   /* Conversion only */
+    SW_LNORM,                   /* Length normalization */
+    SW_KNORM,                   /* Kernel normalization */
+    SW_DSK,                     /* Distance substitution kernel */
+    SW_DKERN,                   /* Kernel-based distance */
+    SW_COEF,                    /* Similarity coefficient */
+} family_t;
+
+static struct
+{
+    const char *name;
+    family_t family;
+} families[] = {
+    {"dist_bag", SW_LNORM},
+    {"dist_damerau", SW_LNORM},
+    {"dist_hamming", SW_LNORM},
+    {"dist_levenshtein", SW_LNORM},
+    {"dist_osa", SW_LNORM},
+    {"kern_spectrum", SW_KNORM},
+    {"kern_subsequence", SW_KNORM},
+    {"kern_wdegree", SW_KNORM},
+    {"kern_distance", SW_DSK},
+    {"dist_kernel", SW_DKERN},
+    {"sim_braun", SW_COEF},
+    {"sim_dice", SW_COEF},
+    {"sim_jaccard", SW_COEF},
+    {"sim_kulczynski", SW_COEF},
+    {"sim_otsuka", SW_COEF},
+    {"sim_simpson", SW_COEF},
+    {"sim_sokal", SW_COEF},
+    {NULL, SW_PLAIN}
+};
+
+/* Variants of the sweep */
+static variant_t *variants = NULL;
+static int num = 0;
+static family_t family = SW_PLAIN;
+static const char *measure = NULL;
+
+/* Values per string: lengths (sizes for coefficients), distances to the
+ * empty string and values of the strings with themselves */
+static int *lens = NULL;
+static float *empty = NULL;
+static float *self = NULL;
+static int offset = 0;
+
+/**
+ * Parse string for conversion of similarity values
+ * @param str String for conversion
+ * @return conversion type
+ */
+static convert_t convert_get(const char *str)
+{
+    if (!strcasecmp(str, "none")) {
+        return CV_NONE;
+    } else if (!strcasecmp(str, "complement")) {
+        return CV_COMPLEMENT;
+    } else if (!strcasecmp(str, "exp")) {
+        return CV_EXP;
+    } else if (!strcasecmp(str, "reciprocal")) {
+        return CV_RECIPROCAL;
+    }
+
+    warning("Unknown conversion '%s'. Using 'none' instead.", str);
+    return CV_NONE;
+}
+
+/**
+ * Convert a similarity value to a dissimilarity value or vice versa
+ * @param c Conversion type
+ * @param v Similarity value
+ * @return converted value
+ */
+static float convert(convert_t c, float v)
+{
+    switch (c) {
+    case CV_COMPLEMENT:
+        return 1 - v;
+    case CV_EXP:
+        return exp(-v);
+    case CV_RECIPROCAL:
+        return 1 / (1 + v);
+    case CV_NONE:
+    default:
+        return v;
+    }
+}
+
+/**
+ * Parse string for a similarity coefficient. The prefix "sim_" of the
+ * measure may be omitted.
+ * @param str String for coefficient
+ * @return coefficient or NULL if unknown
+ */
+static coef_t coef_get(const char *str)
+{
+    char name[64];
+
+    if (strncasecmp(str, "sim_", 4))
+        snprintf(name, sizeof(name), "sim_%s", str);
+    else
+        snprintf(name, sizeof(name), "%s", str);
+
+    return sim_coefficient_get(name);
+}
+
+/**
+ * Assign a parameter of a variant
+ * @param v Variant
+ * @param str Assignment of the form "key=value"
+ * @return true on success, false otherwise
+ */
+static int variant_set(variant_t *v, char *str)
+{
+    char *val = strchr(str, '=');
+
+    if (!val) {
+        error("Invalid assignment '%s' in sweep.", str);
+        return FALSE;
+    }
+
+    *val++ = 0;
+    strtrim(str);
+    strtrim(val);
+
+    if (!strcasecmp(str, "convert")) {
+        v->convert = convert_get(val);
+    } else if (!strcasecmp(str, "norm") && family == SW_LNORM) {
+        v->lnorm = lnorm_get(val);
+    } else if (!strcasecmp(str, "norm") && family != SW_PLAIN) {
+        v->knorm = knorm_get(val);
+    } else if (!strcasecmp(str, "type") && family == SW_DSK) {
+        v->subst = subst_get(val);
+    } else if (!strcasecmp(str, "gamma") && family == SW_DSK) {
+        v->gamma = atof(val);
+    } else if (!strcasecmp(str, "degree") && family == SW_DSK) {
+        v->degree = atof(val);
+    } else if (!strcasecmp(str, "squared") && family == SW_DKERN) {
+        v->squared = !strcasecmp(val, "true") || !strcmp(val, "1");
+    } else if (!strcasecmp(str, "coef") && family == SW_COEF) {
+        v->coef = coef_get(val);
+        if (!v->coef) {
+            error("Unknown coefficient '%s' in sweep.", val);
+            return FALSE;
+        }
+    } else {
+        error("Parameter '%s' not supported in sweep of '%s'.", str,
+              measure);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Initialize the variants from the configuration of the measure
+ * @param v Variant
+ */
+static void variant_init(variant_t *v)
+{
+    const char *str;
+    char path[256];
+
+    memset(v, 0, sizeof(variant_t));
+    v->convert = CV_NONE;
+
+    switch (family) {
+    case SW_LNORM:
+    case SW_KNORM:
+        snprintf(path, sizeof(path), "measures.%s.norm", measure);
+        config_lookup_string(&cfg, path, &str);
+        if (family == SW_LNORM)
+            v->lnorm = lnorm_get(str);
+        else
+            v->knorm = knorm_get(str);
+        break;
+    case SW_DSK:
+        config_lookup_string(&cfg, "measures.kern_distance.type", &str);
+        v->subst = subst_get(str);
+        config_lookup_float(&cfg, "measures.kern_distance.gamma",
+                            &v->gamma);
+        config_lookup_float(&cfg, "measures.kern_distance.degree",
+                            &v->degree);
+        config_lookup_string(&cfg, "measures.kern_distance.norm", &str);
+        v->knorm = knorm_get(str);
+        break;
+    case SW_DKERN:
+        config_lookup_bool(&cfg, "measures.dist_kernel.squared",
+                           &v->squared);
+        config_lookup_string(&cfg, "measures.dist_kernel.norm", &str);
+        v->knorm = knorm_get(str);
+        break;
+    case SW_COEF:
+        v->coef = sim_coefficient_get(measure);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * Initialize a sweep. The variants are parsed from the parameter "sweep"
+ * of the measures.
+ * @param name Name of similarity measure
+ * @return number of variants, 0 if disabled or -1 on error
+ */
+int sweep_init(const char *name)
+{
+    const char *str;
+    char *spec, *v, *a, *sv, *sa;
+    variant_t base;
+    int i;
+
+    config_lookup_string(&cfg, "measures.sweep", &str);
+    if (strlen(str) == 0)
+        return 0;
+
+    measure = name;
+    for (i = 0; families[i].name; i++)
+        if (!strcmp(families[i].name, name))
+            break;
+    family = families[i].family;
+
+    /* Variants start from the configuration */
+    variant_init(&base);
+
+    config_lookup_string(&cfg, "measures.sweep", &str);
+    spec = strdup(str);
+    if (!spec) {
+        error("Could not allocate memory for sweep");
+        return -1;
+    }
+
+    for (v = strtok_r(spec, ";", &sv); v; v = strtok_r(NULL, ";", &sv)) {
+        variant_t var = base;
+
+        strtrim(v);
+        if (strlen(v) == 0)
+            continue;
+
+        snprintf(var.desc, SWEEP_DESC_LEN, "%s", v);
+        for (a = strtok_r(v, ",", &sa); a; a = strtok_r(NULL, ",", &sa))
+            if (!variant_set(&var, a))
+                goto err;
+
+        variants = realloc(variants, (num + 1) * sizeof(variant_t));
+        if (!variants) {
+            error("Could not allocate memory for sweep");
+            goto err;
+        }
+        variants[num++] = var;
+    }
+
+    free(spec);
+    return num;
+
+  err:
+    free(spec);
+    sweep_destroy();
+    return -1;
+}
+
+/**
+ * Configure the measure of the base pass. Normalizations are disabled,
+ * such that the raw values are computed.
+ * @param path Buffer for path of normalization
+ * @param norm Configured normalization (to be freed) or NULL
+ * @return name of measure
+ */
+static const char *base_config(char *path, char **norm)
+{
+    const char *str;
+
+    *norm = NULL;
+    switch (family) {
+    case SW_LNORM:
+    case SW_KNORM:
+        snprintf(path, 256, "measures.%s.norm", measure);
+        config_lookup_string(&cfg, path, &str);
+        *norm = strdup(str);
+        config_set_string(&cfg, path, "none");
+        return measure_config(measure);
+    case SW_DSK:
+        config_lookup_string(&cfg, "measures.kern_distance.dist", &str);
+        return measure_config(str);
+    case SW_DKERN:
+        config_lookup_string(&cfg, "measures.dist_kernel.kern", &str);
+        return measure_config(str);
+    default:
+        return measure;
+    }
+}
+
+/**
+ * Compute the base pass of a sweep. The matrix is filled with the raw
+ * values of the measure and the values per string are computed if needed
+ * by a variant.
+ * @param mat Matrix of similarity values
+ * @param strs Array of strings
+ */
+void sweep_compute(hmatrix_t *mat, hstring_t *strs)
+{
+    const char *str;
+    char path[256], *norm;
+    int i, lo, hi, origin = FALSE, diag = FALSE;
+
+    str = base_config(path, &norm);
+
+#ifdef HAVE_OPENMP
+    info_msg(1, "Computing base measure '%s' for %d variants with %d "
+             "threads.", str, num, omp_get_max_threads());
+#else
+    info_msg(1, "Computing base measure '%s' for %d variants.", str, num);
+#endif
+    /* Coefficients are derived from the number of matching symbols */
+    if (family == SW_COEF)
+        sim_coefficient_compare_all(measure_default(), mat, strs, NULL);
+    else if (!measure_compare_all(mat, strs))
+        hmatrix_compute(mat, strs, measure_compare_batch);
+
+    for (i = 0; i < num; i++) {
+        origin |= family == SW_DSK && (variants[i].subst == DS_LINEAR ||
+                                       variants[i].subst == DS_POLY);
+        diag |= family == SW_DKERN || (family != SW_LNORM &&
+                                       variants[i].knorm == KN_L2);
+    }
+
+    lo = MIN(mat->col.start, mat->row.start);
+    hi = MAX(mat->col.end, mat->row.end);
+    offset = lo;
+
+    lens = calloc(MAX(hi - lo, 1), sizeof(int));
+    empty = calloc(MAX(hi - lo, 1), sizeof(float));
+    self = calloc(MAX(hi - lo, 1), sizeof(float));
+    if (!lens || !empty || !self)
+        fatal("Could not allocate memory for sweep");
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (i = lo; i < hi; i++) {
+        hstring_t o;
+        o = hstring_empty(o, strs[i].type);
+        if (family == SW_COEF)
+            lens[i - lo] = sim_coefficient_size(measure_default(), strs[i]);
+        else
+            lens[i - lo] = strs[i].len;
+        if (origin)
+            empty[i - lo] = measure_compare(strs[i], o);
+        if (diag)
+            self[i - lo] = measure_compare(strs[i], strs[i]);
+    }
+
+    /* Restore configuration of the measure */
+    if (norm) {
+        config_set_string(&cfg, path, norm);
+        free(norm);
+    }
+    measure_config(measure);
+}
+
+/**
+ * Derive a value of a variant from the base pass
+ * @param v Variant
+ * @param f Raw value of the measure
+ * @param x Index of first string
+ * @param y Index of second string
+ * @param kd Kernel values of the strings with themselves or NULL
+ * @return value of the variant
+ */
+static float variant_value(variant_t *v, float f, int x, int y, float *kd)
+{
+    hstring_t a, b;
+    float k1, k2, d;
+    match_t m;
+
+    switch (family) {
+    case SW_LNORM:
+        a.len = lens[x];
+        b.len = lens[y];
+        f = lnorm(v->lnorm, f, a, b);
+        break;
+    case SW_KNORM:
+        if (v->knorm == KN_L2)
+            f = f / sqrt(self[x] * self[y]);
+        break;
+    case SW_DSK:
+        f = subst_kernel(v->subst, v->gamma, v->degree, f, empty[x],
+                         empty[y]);
+        if (kd)
+            f = f / sqrt(kd[x] * kd[y]);
+        break;
+    case SW_DKERN:
+        k1 = self[x];
+        k2 = self[y];
+        if (v->knorm == KN_L2) {
+            f = f / sqrt(k1 * k2);
+            k1 = k1 / sqrt(k1 * k1);
+            k2 = k2 / sqrt(k2 * k2);
+        }
+        d = k1 + k2 - 2 * f;
+        f = v->squared ? d : sqrt(d);
+        break;
+    case SW_COEF:
+        m.a = f;
+        m.b = lens[x] - f;
+        m.c = lens[y] - f;
+        f = v->coef(m);
+        break;
+    default:
+        break;
+    }
+
+    return convert(v->convert, f);
+}
+
+/**
+ * Derive the matrix of a variant from the base pass
+ * @param mat Matrix of raw values
+ * @param n Index of variant
+ * @return values of the variant (to be freed) or NULL on error
+ */
+float *sweep_apply(hmatrix_t *mat, int n)
+{
+    variant_t *v = variants + n;
+    hmatrix_t out = *mat;
+    float *kd = NULL;
+    int i, size = MAX(mat->col.end, mat->row.end) - offset;
+
+    out.values = malloc(sizeof(float) * mat->size);
+    if (!out.values) {
+        error("Could not allocate matrix for variant");
+        return NULL;
+    }
+
+    /* Substituted kernel values of the strings with themselves */
+    if (family == SW_DSK && v->knorm == KN_L2) {
+        kd = malloc(sizeof(float) * MAX(size, 1));
+        if (!kd) {
+            error("Could not allocate memory for variant");
+            free(out.values);
+            return NULL;
+        }
+        for (i = 0; i < size; i++)
+            kd[i] = subst_kernel(v->subst, v->gamma, v->degree, self[i],
+                                 empty[i], empty[i]);
+    }
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (int c = mat->col.start; c < mat->col.end; c++) {
+        for (int r = mat->row.start; r < mat->row.end; r++) {
+            float f;
+
+            /* Lower triangle is stored with the upper triangle */
+            if (mat->triangular && r < c)
+                continue;
+
+            f = variant_value(v, hmatrix_get(mat, c, r), c - offset,
+                              r - offset, kd);
+            hmatrix_set(&out, c, r, f);
+        }
+    }
+
+    free(kd);
+    return out.values;
+}
+
+/**
+ * Return the name of the output of a variant. The index of the variant is
+ * appended to the name of the output before its extension. Standard
+ * output is used for all variants.
+ * @param output Name of output
+ * @param n Index of variant
+ * @return name of output (to be freed)
+ */
+char *sweep_output(const char *output, int n)
+{
+    const char *base, *ext = NULL;
+    size_t len = strlen(output) + 16;
+    char *name = malloc(len);
+
+    if (!name)
+        fatal("Could not allocate memory for name of output");
+
+    if (!strcmp(output, "-") || !strcmp(output, "=")) {
+        snprintf(name, len, "%s", output);
+        return name;
+    }
+
+    base = strrchr(output, '/');
+    base = base ? base + 1 : output;
+    if (*base)
+        ext = strchr(base + 1, '.');
+    if (!ext)
+        ext = output + strlen(output);
+
+    snprintf(name, len, "%.*s-%d%s", (int) (ext - output), output, n + 1,
+             ext);
+    return name;
+}
+
+/**
+ * Return the description of a variant
+ * @param n Index of variant
+ * @return description
+ */
+const char *sweep_desc(int n)
+{
+    return variants[n].desc;
+}
+
+/**
+ * Destroy a sweep and free its memory
+ */
+void sweep_destroy()
+{
+    free(variants);
+    free(lens);
+    free(empty);
+    free(self);
+    variants = NULL;
+    lens = NULL;
+    empty = self = NULL;
+    family = SW_PLAIN;
+    num = 0;
+}
+
+/** @} */
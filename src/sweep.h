@@ -0,0 +1,56 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "hstring.h"
+#include "hmatrix.h"
+#include "norm.h"
+#include "kern_distance.h"
+#include "sim_coefficient.h"
+
+/** Maximum length of the description of a variant */
+#define SWEEP_DESC_LEN  256
+
+/* Conversions of similarity values */
+typedef enum
+{
+    CV_NONE,
+    CV_COMPLEMENT,
+    CV_EXP,
+    CV_RECIPROCAL
+} convert_t;
+
+/**
+ * Variant of a similarity measure derived from the base pass
+ */
+typedef struct
+{
+    char desc[SWEEP_DESC_LEN];  /**< Description of variant */
+    subst_t subst;              /**< Substitution type */
+    double gamma;               /**< Scaling factor */
+    double degree;              /**< Polynomial degree */
+    knorm_t knorm;              /**< Kernel normalization */
+    lnorm_t lnorm;              /**< Length normalization */
+    int squared;                /**< Squared kernel-based distance */
+    convert_t convert;          /**< Conversion of values */
+    coef_t coef;                /**< Similarity coefficient */
+} variant_t;
+
+int sweep_init(const char *);
+void sweep_compute(hmatrix_t *, hstring_t *);
+float *sweep_apply(hmatrix_t *, int);
+char *sweep_output(const char *, int);
+const char *sweep_desc(int);
+void sweep_destroy();
+
+#endif /* SWEEP_H */
@@ -41,6 +41,18 @@ static double pb_start = -1;
 static double log_start = -1;
 
 
+/**
+ * Prints version and copyright information to a file stream
+ * @param f File pointer
+ * @param p Prefix character
+ * @param m Message
+ * @return number of written characters
+ */
+int harry_version(FILE *f, char *p, char *m)
+{
+    return fprintf(f, "%sHarry %s - %s\n", p, PACKAGE_VERSION, m);
+}
+
 /**
  * Print a formated info message with timestamp.
  * @param v Verbosity level of message
@@ -19,147 +19,197 @@
 /* External variables */
 extern config_t cfg;
 
-/* Cache structure */
-static entry_t *cache = NULL;
-static long space = 0;
-static long size = 0;
-
-/* Cache statistics */
-static double hits = 0;
-static double misses = 0;
-
-/* Read-write cache for lock */
-static rwlock_t rwlock;
+/* Default cache */
+static vcache_t global;
 
 /**
  * @defgroup vcache Value cache 
- * Cache for similarity values based on uthash. 
+ * Cache for similarity values based on uthash. The functions without
+ * suffix work on a default cache, while the reentrant versions work on
+ * a given cache, for example, one for each context of the library API.
  * @author Konrad Rieck (konrad@mlsec.org)
  * @{
  */
 
 /**
- * Init value cache
+ * Return the default cache
+ * @return default cache
  */
-void vcache_init()
+vcache_t *vcache_default()
+{
+    return &global;
+}
+
+/**
+ * Init a value cache
+ * @param vc Value cache
+ * @param c Configuration
+ */
+void vcache_init_r(vcache_t *vc, config_t *c)
 {
     cfg_int csize;
-    config_lookup_int(&cfg, "measures.cache_size", &csize);
+    config_lookup_int(c, "measures.cache_size", &csize);
 
     /* Initialize cache stats */
-    space = floor((csize * 1024 * 1024) / sizeof(entry_t));
-    size = 0;
-    misses = 0;
-    hits = 0;
+    vc->space = floor((csize * 1024 * 1024) / sizeof(entry_t));
+    vc->size = 0;
+    vc->misses = 0;
+    vc->hits = 0;
 
-    info_msg(1, "Initializing cache with %dMb (%d entries)", csize, space);
+    info_msg(1, "Initializing cache with %dMb (%d entries)", csize,
+             vc->space);
 
-    cache = calloc(space, sizeof(entry_t));
-    if (!cache)
+    vc->cache = calloc(vc->space, sizeof(entry_t));
+    if (!vc->cache)
         error("Failed to allocate value cache");
 
     /* Initialize lock */
-    rwlock_init(&rwlock);
+    rwlock_init(&vc->rwlock);
+}
+
+/**
+ * Init default value cache
+ */
+void vcache_init()
+{
+    vcache_init_r(&global, &cfg);
 }
 
 /**
  * Store a similarity value. The value is associated with 64 bit key that
  * can be computed from a string, a sequence of symbols or even a pair
  * of strings. Collisions may occur, but are not likely. 
+ * @param vc Value cache
  * @param key Key for similarity value
  * @param value Value to store
  * @param id ID of task
  * @return true on success, false otherwise
  */
-int vcache_store(uint64_t key, float value, int id)
+int vcache_store_r(vcache_t *vc, uint64_t key, float value, int id)
 {
     int idx;
 
-    idx = (key ^ id) % space;
+    idx = (key ^ id) % vc->space;
 
-    rwlock_set_wlock(&rwlock);
+    rwlock_set_wlock(&vc->rwlock);
 
-    if (cache[idx].key == 0)
-        size++;
+    if (vc->cache[idx].key == 0)
+        vc->size++;
 
-    cache[idx].key = key;
-    cache[idx].val = value;
-    cache[idx].id = id;
-    rwlock_unset_wlock(&rwlock);
+    vc->cache[idx].key = key;
+    vc->cache[idx].val = value;
+    vc->cache[idx].id = id;
+    rwlock_unset_wlock(&vc->rwlock);
 
     return TRUE;
 }
 
+/**
+ * Store a similarity value in the default cache
+ * @param key Key for similarity value
+ * @param value Value to store
+ * @param id ID of task
+ * @return true on success, false otherwise
+ */
+int vcache_store(uint64_t key, float value, int id)
+{
+    return vcache_store_r(&global, key, value, id);
+}
+
 /**
  * Load a similarity value. The value is associated with 64 bit key.
+ * @param vc Value cache
  * @param key Key for similarity value
  * @param value Pointer to space for value
  * @param id ID of task
  * @return true on success, false otherwise 
  */
-int vcache_load(uint64_t key, float *value, int id)
+int vcache_load_r(vcache_t *vc, uint64_t key, float *value, int id)
 {
     int ret, idx;
 
-    idx = (key ^ id) % space;
-    rwlock_set_rlock(&rwlock);
-    if (cache[idx].key == key && cache[idx].id == id) {
-        *value = cache[idx].val;
+    idx = (key ^ id) % vc->space;
+    rwlock_set_rlock(&vc->rwlock);
+    if (vc->cache[idx].key == key && vc->cache[idx].id == id) {
+        *value = vc->cache[idx].val;
         ret = TRUE;
-        hits++;
+        vc->hits++;
     } else {
         ret = FALSE;
-        misses++;
+        vc->misses++;
     }
 
-    rwlock_unset_rlock(&rwlock);
+    rwlock_unset_rlock(&vc->rwlock);
     return ret;
 }
 
 /**
- * Display some information about cache usage 
+ * Load a similarity value from the default cache
+ * @param key Key for similarity value
+ * @param value Pointer to space for value
+ * @param id ID of task
+ * @return true on success, false otherwise 
+ */
+int vcache_load(uint64_t key, float *value, int id)
+{
+    return vcache_load_r(&global, key, value, id);
+}
+
+/**
+ * Display some information about usage of the default cache
  */
 void vcache_info()
 {
-    float used = (size * sizeof(entry_t)) / (1024.0 * 1024.0);
-    float free = (space * sizeof(entry_t)) / (1024.0 * 1024.0);
+    float used = (global.size * sizeof(entry_t)) / (1024.0 * 1024.0);
+    float free = (global.space * sizeof(entry_t)) / (1024.0 * 1024.0);
 
     info_msg(1,
              "Cache stats: %.1fMb used by %d entries, hits %3.0f%%, %.1fMb free.",
-             used, size, 100 * hits / (hits + misses), free);
+             used, global.size,
+             100 * global.hits / (global.hits + global.misses), free);
 }
 
 /**
- * Get used memory in megabytes
+ * Get used memory of the default cache in megabytes
  * @return used memory
  */
 float vcache_get_used()
 {
-    return (size * sizeof(entry_t)) / (1024.0 * 1024.0);
+    return (global.size * sizeof(entry_t)) / (1024.0 * 1024.0);
 }
 
 /**
- * Get hit rate
+ * Get hit rate of the default cache
  * @return hit rate
  */
 float vcache_get_hitrate()
 {
-    const double total = (hits + misses);
-    return (total <= 0 ? 0 : 100 * hits / (hits + misses));
+    const double total = (global.hits + global.misses);
+    return (total <= 0 ? 0 : 100 * global.hits / total);
 }
 
 /**
- * Destroy the value cache 
+ * Destroy a value cache 
+ * @param vc Value cache
  */
-void vcache_destroy()
+void vcache_destroy_r(vcache_t *vc)
 {
     info_msg(1, "Clearing cache and freeing memory");
 
     /* Destroy lock */
-    rwlock_destroy(&rwlock);
+    rwlock_destroy(&vc->rwlock);
 
     /* Clear hash table */
-    free(cache);
+    free(vc->cache);
+    vc->cache = NULL;
+}
+
+/**
+ * Destroy the default value cache 
+ */
+void vcache_destroy()
+{
+    vcache_destroy_r(&global);
 }
 
 /** @} */
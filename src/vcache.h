@@ -12,6 +12,8 @@
 #ifndef VCACHE_H
 #define VCACHE_H
 
+#include "rwlock.h"
+
 /** Task identifiers */
 #define ID_COMPARE              1       /* Global comparison cache */
 #define ID_DIST_COMPRESS	2       /* Compression distance */
@@ -26,6 +28,21 @@ typedef struct
     float val;          /**< Cached similarity value */
 } entry_t;
 
+/**
+ * Value cache
+ */
+typedef struct
+{
+    entry_t *cache;     /**< Table of entries */
+    long space;         /**< Number of entries in table */
+    long size;          /**< Number of used entries */
+    double hits;        /**< Cache hits */
+    double misses;      /**< Cache misses */
+    rwlock_t rwlock;    /**< Read-write lock */
+} vcache_t;
+
+/* Default cache */
+vcache_t *vcache_default();
 void vcache_init();
 int vcache_load(uint64_t key, float *value, int);
 int vcache_store(uint64_t key, float value, int);
@@ -34,4 +51,10 @@ void vcache_destroy();
 float vcache_get_hitrate();
 float vcache_get_used();
 
+/* Reentrant versions */
+void vcache_init_r(vcache_t *, config_t *);
+int vcache_load_r(vcache_t *, uint64_t key, float *value, int);
+int vcache_store_r(vcache_t *, uint64_t key, float value, int);
+void vcache_destroy_r(vcache_t *);
+
 #endif
@@ -0,0 +1,62 @@
+#!/bin/sh
+# Harry - A Tool for Measuring String Similarity
+# Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+# --
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the GNU General Public License as published by the
+# Free Software Foundation; either version 3 of the License, or (at your
+# option) any later version.  This program is distributed without any
+# warranty. See the GNU General Public License for more details.
+# --
+# Microbenchmark of the compressors of the compression distance. The
+# throughput of each compressor is measured using the benchmark mode of
+# Harry. Compressors not compiled into Harry are skipped. By default,
+# random strings are generated, such that pairs of strings are rarely
+# compared twice and the value cache is bypassed.
+#
+
+# Check for directories
+test -z "$TMPDIR" && TMPDIR="/tmp"
+test -z "$BUILDDIR" && BUILDDIR=".."
+test -z "$SRCDIR" && SRCDIR=".."
+test -z "$DURATION" && DURATION=5
+test -z "$LEVEL" && LEVEL=9
+
+HARRY=$BUILDDIR/src/harry
+CONFIG=$TMPDIR/harry-$$.cfg
+OUTPUT=$TMPDIR/harry-$$.txt
+DATA=$TMPDIR/harry-$$.dat
+
+# Generate random strings with repeated words
+if test -n "$1" ; then
+    cp "$1" $DATA
+else
+    awk 'BEGIN { srand(1); for (i = 0; i < 10000; i++) {
+        n = 50 + int(rand() * 1000); s = "";
+        while (length(s) < n) s = s sprintf("w%d ", int(rand() * 200));
+        print s; } }' > $DATA
+fi
+
+for COMP in zlib zstd lz4 bzip2 ; do
+    cat > $CONFIG << END
+measures = {
+    granularity = "bytes";
+    dist_compression = {
+        compressor = "$COMP";
+        level = $LEVEL;
+    };
+};
+END
+
+    $HARRY -c $CONFIG -m dist_compression --benchmark $DURATION \
+           $DATA /dev/null > $OUTPUT 2>&1
+    if grep -q "compiled without" $OUTPUT ; then
+        printf "%-8s not available\n" $COMP
+        continue
+    fi
+
+    CMPS=`grep comparisons $OUTPUT | cut -d ' ' -f 1`
+    printf "%-8s %12d comparisons/s\n" $COMP `expr $CMPS / $DURATION`
+done
+
+rm -f $CONFIG $OUTPUT $DATA
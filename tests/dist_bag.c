@@ -18,6 +18,7 @@
 
 /* Global variables */
 int verbose = 0;
+int log_line = 0;
 config_t cfg;
 
 /*
@@ -111,6 +112,26 @@ int test_compare()
     return err;
 }
 
+/**
+ * Test the skipping of disjoint strings using signatures
+ * @return error flag
+ */
+int test_signature()
+{
+    char *measures[] = { "dist_bag", NULL };
+    char *norms[] = { "none", "max", "avg", NULL };
+    int err;
+
+    printf("Testing signatures of bag distance ");
+
+    config_set_string(&cfg, "measures.granularity", "bytes");
+    err = check_signature(measures, "measures.dist_bag.norm", norms);
+    printf(" done.\n");
+
+    config_set_string(&cfg, "measures.dist_bag.norm", "none");
+    return err;
+}
+
 /**
  * Main test function
  */
@@ -122,6 +143,7 @@ int main(int argc, char **argv)
     config_check(&cfg);
 
     err |= test_compare();
+    err |= test_signature();
 
     config_destroy(&cfg);
     return err;
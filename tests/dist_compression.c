@@ -19,6 +19,7 @@
 
 /* Global variables */
 int verbose = 0;
+int log_line = 0;
 config_t cfg;
 
 /*
@@ -83,6 +84,149 @@ int test_compare()
     return err;
 }
 
+/* Number and length of strings for stream test */
+#define STREAM_NUM      8
+#define STREAM_LEN      10000
+
+/**
+ * Compress a buffer using compress2()
+ * @param buf Buffer
+ * @param len Length of buffer
+ * @return length of compressed data
+ */
+static float compress_len(char *buf, size_t len)
+{
+    uLongf tmp = compressBound(len);
+    Bytef *dst = malloc(tmp);
+
+    compress2(dst, &tmp, (Bytef *) buf, len, 9);
+    free(dst);
+    return tmp;
+}
+
+/**
+ * Test reusable and primed streams against compress2(). Long strings are
+ * used, such that the primed stream is copied for the suffixes.
+ * @return error flag
+ */
+int test_stream()
+{
+    int i, j, k, err = FALSE;
+    hstring_t x[STREAM_NUM];
+    char *buf = malloc(2 * STREAM_LEN + 1);
+
+    printf("Testing compression streams ");
+    measure_config("dist_compression");
+
+    srand(1234);
+    for (i = 0; i < STREAM_NUM; i++) {
+        for (j = 0, k = rand() % STREAM_LEN; j < k; j++)
+            buf[j] = "abcd "[rand() % (j % 7 ? 5 : 2)];
+        buf[k] = 0;
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+    }
+
+    for (i = 0; i < STREAM_NUM && !err; i++) {
+        for (j = 0; j < STREAM_NUM && !err; j++) {
+            float xl, yl, xyl, yxl, d, e;
+
+            xl = compress_len(x[i].str.c, x[i].len);
+            yl = compress_len(x[j].str.c, x[j].len);
+            memcpy(buf, x[j].str.c, x[j].len);
+            memcpy(buf + x[j].len, x[i].str.c, x[i].len);
+            xyl = compress_len(buf, x[i].len + x[j].len);
+            memcpy(buf, x[i].str.c, x[i].len);
+            memcpy(buf + x[i].len, x[j].str.c, x[j].len);
+            yxl = compress_len(buf, x[i].len + x[j].len);
+
+            e = (0.5 * (xyl + yxl) - fmin(xl, yl)) / fmax(xl, yl);
+            d = measure_compare(x[i], x[j]);
+            if (fabs(d - e) > 1e-6) {
+                printf("Error %f != %f\n", d, e);
+                err = TRUE;
+            }
+        }
+        printf(".");
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < STREAM_NUM; i++)
+        hstring_destroy(&x[i]);
+    free(buf);
+
+    return err;
+}
+
+/* Compressors available as backend */
+static char *compressors[] = {
+#ifdef HAVE_ZSTD
+    "zstd",
+#endif
+#ifdef HAVE_LZ4
+    "lz4",
+#endif
+#ifdef HAVE_BZIP2
+    "bzip2",
+#endif
+    "zlib", NULL
+};
+
+/**
+ * Test the compressors available as backend. Identical strings need to
+ * be closer than different strings and the distance must be symmetric.
+ * @return error flag
+ */
+int test_backends()
+{
+    int i, j, k, err = FALSE;
+    hstring_t x[STREAM_NUM];
+    char *buf = malloc(STREAM_LEN + 1);
+
+    printf("Testing compressors ");
+
+    srand(4321);
+    for (i = 0; i < STREAM_NUM; i++) {
+        for (j = 0; j < STREAM_LEN; j++)
+            buf[j] = "abcdefgh "[rand() % 9];
+        buf[j] = 0;
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+    }
+
+    for (k = 0; compressors[k] && !err; k++) {
+        config_set_string(&cfg, "measures.dist_compression.compressor",
+                          compressors[k]);
+        measure_config("dist_compression");
+
+        /* Values of the previous compressor are cached */
+        vcache_destroy();
+        vcache_init();
+
+        for (i = 0; i < STREAM_NUM && !err; i++) {
+            float d = measure_compare(x[i], x[i]);
+            for (j = 0; j < STREAM_NUM && !err; j++) {
+                float e = measure_compare(x[i], x[j]);
+                float f = measure_compare(x[j], x[i]);
+                if (i != j && (e <= d || e != f)) {
+                    printf("Error %s: %f, %f, %f\n", compressors[k], d, e,
+                           f);
+                    err = TRUE;
+                }
+            }
+        }
+        printf(".");
+    }
+    printf(" done.\n");
+
+    config_set_string(&cfg, "measures.dist_compression.compressor", "zlib");
+    for (i = 0; i < STREAM_NUM; i++)
+        hstring_destroy(&x[i]);
+    free(buf);
+
+    return err;
+}
+
 /**
  * Main test function
  */
@@ -96,6 +240,8 @@ int main(int argc, char **argv)
     vcache_init();
 
     err |= test_compare();
+    err |= test_stream();
+    err |= test_backends();
 
     vcache_destroy();
 
@@ -18,6 +18,7 @@
 
 /* Global variables */
 int verbose = 0;
+int log_line = 0;
 config_t cfg;
 
 /*
@@ -18,6 +18,7 @@
 
 /* Global variables */
 int verbose = 0;
+int log_line = 0;
 config_t cfg;
 
 /*
@@ -86,6 +87,57 @@ int test_compare()
     return err;
 }
 
+/* Number of strings for batch test */
+#define BATCH_NUM       100
+
+/**
+ * Test comparison of one string with several strings. Random strings of
+ * different lengths are used to cover all widths of vector lanes.
+ * @return error flag
+ */
+int test_batch()
+{
+    int i, j, k, err = FALSE;
+    hstring_t x[BATCH_NUM];
+    float out[BATCH_NUM];
+    char buf[512];
+
+    printf("Testing batch comparison ");
+    config_set_string(&cfg, "measures.granularity", "bytes");
+    measure_config("dist_jarowinkler");
+
+    srand(1234);
+    for (i = 0; i < BATCH_NUM; i++) {
+        k = rand() % (i % 4 ? 40 : sizeof(buf) - 1);
+        for (j = 0; j < k; j++)
+            buf[j] = 'a' + rand() % 4;
+        buf[k] = 0;
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+    }
+
+    for (i = 0; i < BATCH_NUM && !err; i++) {
+        measure_compare_batch(x[i], x, BATCH_NUM, out);
+        for (j = 0; j < BATCH_NUM; j++) {
+            float d = measure_compare(x[i], x[j]);
+            if (fabs(out[j] - d) > 1e-6) {
+                printf("Error %f != %f\n", out[j], d);
+                hstring_print(x[i]);
+                hstring_print(x[j]);
+                err = TRUE;
+                break;
+            }
+        }
+        printf(".");
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < BATCH_NUM; i++)
+        hstring_destroy(&x[i]);
+
+    return err;
+}
+
 /**
  * Main test function
  */
@@ -97,6 +149,7 @@ int main(int argc, char **argv)
     config_check(&cfg);
 
     err |= test_compare();
+    err |= test_batch();
 
     config_destroy(&cfg);
     return err;
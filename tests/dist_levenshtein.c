@@ -18,6 +18,7 @@
 
 /* Global variables */
 int verbose = 0;
+int log_line = 0;
 config_t cfg;
 
 /*
@@ -116,6 +117,121 @@ int test_compare()
     return err;
 }
 
+/* Number of strings for batch test */
+#define BATCH_NUM       100
+
+/**
+ * Test comparison of one string with several strings. Random strings of
+ * different lengths are used to cover all widths of vector lanes.
+ * @return error flag
+ */
+int test_batch()
+{
+    int i, j, k, err = FALSE;
+    hstring_t x[BATCH_NUM];
+    float out[BATCH_NUM];
+    char buf[512];
+
+    printf("Testing batch comparison ");
+    config_set_string(&cfg, "measures.granularity", "bytes");
+    measure_config("dist_levenshtein");
+
+    srand(1234);
+    for (i = 0; i < BATCH_NUM; i++) {
+        k = rand() % (i % 4 ? 40 : sizeof(buf) - 1);
+        for (j = 0; j < k; j++)
+            buf[j] = 'a' + rand() % 4;
+        buf[k] = 0;
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+    }
+
+    for (i = 0; i < BATCH_NUM && !err; i++) {
+        measure_compare_batch(x[i], x, BATCH_NUM, out);
+        for (j = 0; j < BATCH_NUM; j++) {
+            float d = measure_compare(x[i], x[j]);
+            if (fabs(out[j] - d) > 1e-6) {
+                printf("Error %f != %f\n", out[j], d);
+                hstring_print(x[i]);
+                hstring_print(x[j]);
+                err = TRUE;
+                break;
+            }
+        }
+        printf(".");
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < BATCH_NUM; i++)
+        hstring_destroy(&x[i]);
+
+    return err;
+}
+
+/* Number of strings for sweep test */
+#define SWEEP_NUM       20
+
+/*
+ * Variants of sweep test
+ */
+struct sweep_test
+{
+    char *n;            /**< Norm */
+    int c;              /**< Complement of value */
+} sweeps[] = {
+    {"none", FALSE},
+    {"max", FALSE},
+    {"avg", FALSE},
+    {"max", TRUE},
+    {NULL}
+};
+
+/**
+ * Configure a variant of the sweep test
+ * @param k Index of variant
+ * @return true if the value is complemented
+ */
+static int sweep_variant(int k)
+{
+    config_set_string(&cfg, "measures.dist_levenshtein.norm", sweeps[k].n);
+    measure_config("dist_levenshtein");
+    return sweeps[k].c;
+}
+
+/**
+ * Test variants of a sweep against the direct computation
+ * @return error flag
+ */
+int test_sweep()
+{
+    int i, j, k, err;
+    hstring_t x[SWEEP_NUM];
+    char buf[64];
+
+    printf("Testing sweep of length normalization ");
+
+    srand(4711);
+    for (i = 0; i < SWEEP_NUM; i++) {
+        for (j = 0, k = rand() % 20; j < k; j++)
+            buf[j] = "abc"[rand() % 3];
+        buf[k] = 0;
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+    }
+
+    config_set_string(&cfg, "measures.dist_levenshtein.norm", "min");
+    err = check_sweep("dist_levenshtein", "norm=none; norm=max; "
+                      "norm=avg; norm=max,convert=complement", 4,
+                      sweep_variant, x, SWEEP_NUM, 1e-6);
+    printf(" done.\n");
+
+    for (i = 0; i < SWEEP_NUM; i++)
+        hstring_destroy(&x[i]);
+    config_set_string(&cfg, "measures.dist_levenshtein.norm", "none");
+
+    return err;
+}
+
 /**
  * Main test function
  */
@@ -127,6 +243,8 @@ int main(int argc, char **argv)
     config_check(&cfg);
 
     err |= test_compare();
+    err |= test_batch();
+    err |= test_sweep();
 
     config_destroy(&cfg);
     return err;
@@ -0,0 +1,145 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "harryapi.h"
+
+/* Number of random strings */
+#define NUM_STRS        40
+/* Number of concurrent calls */
+#define NUM_CALLS       16
+
+/* Test strings */
+const char *strs[] = {
+    "abba", "babb", ".a.b.", "a..c.", "x...y..", "...x..y"
+};
+
+/**
+ * Create a context with a measure and granularity
+ * @param measure Name of measure
+ * @param gran Granularity of strings
+ * @return context
+ */
+static harry_ctx_t *ctx_create(char *measure, char *gran)
+{
+    harry_ctx_t *ctx = harry_ctx_new(NULL);
+
+    harry_ctx_set(ctx, "measures.measure", measure);
+    harry_ctx_set(ctx, "measures.granularity", gran);
+    harry_ctx_set(ctx, "measures.token_delim", ".");
+    return ctx;
+}
+
+/**
+ * Check that two contexts keep their own measure and preprocessing
+ * @return error flag
+ */
+int test_contexts()
+{
+    int i, err = FALSE;
+    harry_ctx_t *a, *b;
+    float va[] = { 2, 3, 3 }, vb[] = { 1, 1, 0 };
+
+    printf("Testing independent contexts ");
+    a = ctx_create("dist_levenshtein", "bytes");
+    b = ctx_create("dist_hamming", "tokens");
+    harry_prepare(a, strs, NULL, 6);
+    harry_prepare(b, strs, NULL, 6);
+
+    for (i = 0; i < 3; i++) {
+        float da = harry_compare(a, 2 * i, 2 * i + 1);
+        float db = harry_compare(b, 2 * i, 2 * i + 1);
+
+        printf(".");
+        if (fabs(da - va[i]) > 1e-6 || fabs(db - vb[i]) > 1e-6) {
+            printf("Error %f != %f or %f != %f\n", da, va[i], db, vb[i]);
+            err = TRUE;
+        }
+    }
+
+    harry_ctx_free(a);
+    harry_ctx_free(b);
+    printf(" done.\n");
+
+    return err;
+}
+
+/**
+ * Check concurrent calls on two contexts against serial results
+ * @return error flag
+ */
+int test_concurrent()
+{
+    int i, j, err = FALSE, n = NUM_STRS * NUM_STRS;
+    harry_ctx_t *ctx[2];
+    float *ref[2], *out[NUM_CALLS];
+    char buf[NUM_STRS][16];
+    const char *s[NUM_STRS];
+
+    printf("Testing concurrent calls ");
+    srand(4711);
+    for (i = 0; i < NUM_STRS; i++) {
+        for (j = 0; j < 1 + i % 15; j++)
+            buf[i][j] = 'a' + rand() % 4;
+        buf[i][j] = 0;
+        s[i] = buf[i];
+    }
+
+    ctx[0] = ctx_create("dist_levenshtein", "bytes");
+    ctx[1] = ctx_create("kern_spectrum", "bytes");
+    harry_ctx_set(ctx[0], "measures.global_cache", "1");
+    harry_ctx_set(ctx[1], "measures.num_threads", "2");
+
+    for (i = 0; i < 2; i++) {
+        harry_prepare(ctx[i], s, NULL, NUM_STRS);
+        ref[i] = malloc(n * sizeof(float));
+        harry_compare_block(ctx[i], 0, NUM_STRS, 0, NUM_STRS, ref[i]);
+    }
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for num_threads(4)
+#endif
+    for (i = 0; i < NUM_CALLS; i++) {
+        out[i] = malloc(n * sizeof(float));
+        harry_compare_block(ctx[i % 2], 0, NUM_STRS, 0, NUM_STRS, out[i]);
+    }
+
+    for (i = 0; i < NUM_CALLS; i++) {
+        if (memcmp(out[i], ref[i % 2], n * sizeof(float))) {
+            printf("Error in call %d\n", i);
+            err = TRUE;
+        }
+        free(out[i]);
+        printf(".");
+    }
+
+    for (i = 0; i < 2; i++) {
+        harry_ctx_free(ctx[i]);
+        free(ref[i]);
+    }
+    printf(" done.\n");
+
+    return err;
+}
+
+/**
+ * Main test function
+ */
+int main(int argc, char **argv)
+{
+    int err = FALSE;
+
+    err |= test_contexts();
+    err |= test_concurrent();
+
+    return err;
+}
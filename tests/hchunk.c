@@ -0,0 +1,190 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "hconfig.h"
+#include "util.h"
+#include "hmatrix.h"
+#include "hchunk.h"
+#include "output.h"
+#include "output_chunk.h"
+#include "tests.h"
+
+/* Global variables */
+int verbose = 0;
+int log_line = 0;
+config_t cfg;
+
+/* Number of strings, such that matrices span several bands */
+#define CHUNK_NUM       1500
+
+/* File of chunk tests */
+#define CHUNK_FILE      "check_chunk.hck"
+
+/*
+ * Ranges of chunk tests
+ */
+struct chunk_test
+{
+    char *cols;         /**< Column range */
+    char *rows;         /**< Row range */
+} ranges[] = {
+    {"", ""},
+    {"200:1400", "200:1400"},
+    {"0:1000", "100:1200"},
+    {NULL}
+};
+
+/**
+ * Fill a matrix with symmetric values. Patterned values compress well,
+ * random values are stored uncompressed.
+ * @param m Matrix object
+ * @param random Flag for random values
+ */
+static void fill_matrix(hmatrix_t *m, int random)
+{
+    int c, r;
+
+    srand48(4711);
+    for (r = m->row.start; r < m->row.end; r++) {
+        for (c = m->col.start; c < m->col.end; c++) {
+            if (m->triangular && c < r)
+                continue;
+            if (random)
+                hmatrix_set(m, c, r, drand48());
+            else
+                hmatrix_set(m, c, r, (c + r) % 11 + (c * r) % 5 * 0.25);
+        }
+    }
+}
+
+/**
+ * Compare a submatrix read from a chunked file with the matrix
+ * @param c Chunked file
+ * @param m Matrix object
+ * @param r0 Start of rows
+ * @param r1 End of rows
+ * @param c0 Start of columns
+ * @param c1 End of columns
+ * @return true if equal, false otherwise
+ */
+static int check_submatrix(hchunk_t *c, hmatrix_t *m, int r0, int r1,
+                           int c0, int c1)
+{
+    long w = c1 - c0, i, j;
+    float *out = malloc(MAX((r1 - r0) * w, 1) * sizeof(float));
+    int ok = TRUE;
+
+    if (!out || hchunk_read(c, r0, r1, c0, c1, out) != (r1 - r0) * w) {
+        free(out);
+        return FALSE;
+    }
+
+    for (i = r0; i < r1 && ok; i++) {
+        for (j = c0; j < c1 && ok; j++) {
+            float v = hmatrix_get(m, m->col.start + j, m->row.start + i);
+            if (out[(i - r0) * w + j - c0] != v) {
+                printf("Error: value at (%ld, %ld) differs\n", i, j);
+                ok = FALSE;
+            }
+        }
+    }
+
+    free(out);
+    return ok;
+}
+
+/**
+ * Write a matrix in chunked format and read rows and submatrices back
+ * @param compress Flag for compression of bands
+ * @param random Flag for random values
+ * @return error flag
+ */
+static int test_roundtrip(int compress, int random)
+{
+    int i, k, n, rows, cols, err = FALSE;
+    hstring_t x[CHUNK_NUM];
+    hmatrix_t *m;
+    hchunk_t *c;
+    char buf[64];
+
+    printf("Testing chunked format (compress = %d, random = %d) ",
+           compress, random);
+    config_set_bool(&cfg, "output.compress", compress);
+
+    for (i = 0; i < CHUNK_NUM; i++)
+        x[i] = hstring_init(x[i], "x");
+
+    for (k = 0; ranges[k].cols && !err; k++) {
+        m = hmatrix_init(x, CHUNK_NUM);
+        hmatrix_col_range(m, strcpy(buf, ranges[k].cols));
+        hmatrix_row_range(m, strcpy(buf, ranges[k].rows));
+        if (!hmatrix_alloc(m)) {
+            hmatrix_destroy(m);
+            err = TRUE;
+            break;
+        }
+        fill_matrix(m, random);
+
+        n = output_chunk_open(CHUNK_FILE) ? output_chunk_write(m) : 0;
+        output_chunk_close();
+
+        c = hchunk_open(CHUNK_FILE);
+        if (!c || n == 0 || c->hdr.num_bands < 2 ||
+            !(c->hdr.flags & HCHUNK_TRIANGULAR) != !m->triangular) {
+            err = TRUE;
+        } else {
+            rows = c->hdr.rows;
+            cols = c->hdr.cols;
+
+            /* Full matrix, single rows and submatrices across bands */
+            err |= !check_submatrix(c, m, 0, rows, 0, cols);
+            for (i = 0; i < rows && !err; i += 97)
+                err |= !check_submatrix(c, m, i, i + 1, 0, cols);
+            for (i = 0; i < 20 && !err; i++) {
+                int r0 = lrand48() % rows, c0 = lrand48() % cols;
+                int r1 = r0 + lrand48() % (rows - r0 + 1);
+                int c1 = c0 + lrand48() % (cols - c0 + 1);
+                err |= !check_submatrix(c, m, r0, r1, c0, c1);
+            }
+        }
+
+        hchunk_close(c);
+        hmatrix_destroy(m);
+        printf(".");
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < CHUNK_NUM; i++)
+        hstring_destroy(&x[i]);
+    remove(CHUNK_FILE);
+
+    return err;
+}
+
+/**
+ * Main test function
+ */
+int main(int argc, char **argv)
+{
+    int err = FALSE;
+
+    config_init(&cfg);
+    config_check(&cfg);
+
+    err |= test_roundtrip(FALSE, FALSE);
+    err |= test_roundtrip(TRUE, FALSE);
+    err |= test_roundtrip(TRUE, TRUE);
+
+    config_destroy(&cfg);
+    return err;
+}
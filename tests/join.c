@@ -0,0 +1,633 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details. 
+ */
+
+#include "config.h"
+#include "common.h"
+#include "hconfig.h"
+#include "util.h"
+#include "measures.h"
+#include "hmatrix.h"
+#include "join.h"
+#include "tests.h"
+#include "vcache.h"
+
+/* Global variables */
+int verbose = 0;
+int log_line = 0;
+config_t cfg;
+
+/* Number of strings for join tests */
+#define JOIN_NUM        300
+
+/*
+ * Ranges of join tests
+ */
+struct join_test
+{
+    char *cols;         /**< Column range */
+    char *rows;         /**< Row range */
+} ranges[] = {
+    {"", ""},
+    {"0:100", "100:300"},
+    {"50:250", "0:150"},
+    {NULL}
+};
+
+/**
+ * Generate random strings. Groups of similar strings are created by
+ * mutating a few base strings.
+ * @param x Array of strings
+ * @param n Number of strings
+ */
+static void random_strings(hstring_t *x, int n)
+{
+    char base[8][64], buf[80];
+    int i, j, k, l;
+
+    srand(1234);
+    for (i = 0; i < 8; i++) {
+        for (j = 0, k = rand() % 40; j < k; j++)
+            base[i][j] = "abcd"[rand() % 4];
+        base[i][k] = 0;
+    }
+
+    for (i = 0; i < n; i++) {
+        strcpy(buf, base[rand() % 8]);
+        for (j = rand() % 5; j > 0; j--) {
+            l = strlen(buf);
+            k = rand() % (l + 1);
+            switch (rand() % 3) {
+            case 0:
+                memmove(buf + k + 1, buf + k, l - k + 1);
+                buf[k] = "abcd"[rand() % 4];
+                break;
+            case 1:
+                if (k < l)
+                    memmove(buf + k, buf + k + 1, l - k);
+                break;
+            default:
+                if (k < l)
+                    buf[k] = "abcd"[rand() % 4];
+                break;
+            }
+        }
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+    }
+}
+
+/**
+ * Compare two lists of pairs
+ * @param p First list
+ * @param q Second list
+ * @return true if equal, false otherwise
+ */
+static int pairs_equal(hpairs_t *p, hpairs_t *q)
+{
+    long i;
+
+    if (p->num != q->num) {
+        printf("Error: %ld != %ld pairs\n", p->num, q->num);
+        return FALSE;
+    }
+
+    for (i = 0; i < p->num; i++) {
+        if (p->pairs[i].x != q->pairs[i].x ||
+            p->pairs[i].y != q->pairs[i].y ||
+            fabs(p->pairs[i].v - q->pairs[i].v) > 1e-6) {
+            printf("Error: (%d,%d,%g) != (%d,%d,%g)\n", p->pairs[i].x,
+                   p->pairs[i].y, p->pairs[i].v, q->pairs[i].x,
+                   q->pairs[i].y, q->pairs[i].v);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Run a join with the given method on a matrix
+ * @param m Matrix object
+ * @param x Array of strings
+ * @param method Join method
+ * @param measure Similarity measure
+ * @return list of pairs or NULL on error
+ */
+static hpairs_t *run_join(hmatrix_t *m, hstring_t *x, char *method,
+                          char *measure)
+{
+    config_set_string(&cfg, "measures.join.method", method);
+    if (join_config(measure_config(measure)) != TRUE)
+        return NULL;
+    return join_compute(m, x);
+}
+
+/**
+ * Test a join method against the exhaustive join
+ * @param method Join method
+ * @param measure Similarity measure
+ * @param ts Array of thresholds
+ * @return error flag
+ */
+static int test_method(char *method, char *measure, float *ts)
+{
+    int i, k, err = FALSE;
+    hstring_t x[JOIN_NUM];
+    hpairs_t *p, *q;
+    hmatrix_t *m;
+    char buf[64];
+
+    printf("Testing join '%s' with %s ", method, measure);
+    random_strings(x, JOIN_NUM);
+
+    for (k = 0; ranges[k].cols && !err; k++) {
+        m = hmatrix_init(x, JOIN_NUM);
+        /* Ranges are modified during parsing */
+        hmatrix_col_range(m, strcpy(buf, ranges[k].cols));
+        hmatrix_row_range(m, strcpy(buf, ranges[k].rows));
+
+        for (i = 0; !isnan(ts[i]) && !err; i++) {
+            config_set_float(&cfg, "measures.join.threshold", ts[i]);
+            p = run_join(m, x, "exhaustive", measure);
+            q = run_join(m, x, method, measure);
+            if (!p || !q || !pairs_equal(p, q))
+                err = TRUE;
+            hpairs_destroy(p);
+            hpairs_destroy(q);
+            printf(".");
+        }
+        hmatrix_destroy(m);
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < JOIN_NUM; i++)
+        hstring_destroy(&x[i]);
+    config_set_string(&cfg, "measures.join.method", "none");
+
+    return err;
+}
+
+/**
+ * Test the estimates of MinHash without verification. Every reported
+ * pair needs to pass the threshold, the estimates need to be close to
+ * the coefficient and pairs of identical sets need to be found.
+ * @param ts Array of thresholds
+ * @return error flag
+ */
+static int test_estimate(float *ts)
+{
+    int i, j, k, l, err = FALSE;
+    hstring_t x[JOIN_NUM];
+    hpairs_t *p, *q;
+    hmatrix_t *m;
+    char buf[64];
+
+    printf("Testing estimates of 'minhash' ");
+    random_strings(x, JOIN_NUM);
+    config_set_bool(&cfg, "measures.join.minhash.verify", FALSE);
+
+    for (k = 0; ranges[k].cols && !err; k++) {
+        m = hmatrix_init(x, JOIN_NUM);
+        hmatrix_col_range(m, strcpy(buf, ranges[k].cols));
+        hmatrix_row_range(m, strcpy(buf, ranges[k].rows));
+
+        for (i = 0; !isnan(ts[i]) && !err; i++) {
+            double diff = 0;
+
+            config_set_float(&cfg, "measures.join.threshold", ts[i]);
+            p = run_join(m, x, "exhaustive", "sim_jaccard");
+            q = run_join(m, x, "minhash", "sim_jaccard");
+            if (!p || !q) {
+                err = TRUE;
+                goto next;
+            }
+
+            for (j = 0; j < q->num && !err; j++) {
+                hpair_t *e = q->pairs + j;
+                if (e->v < ts[i]) {
+                    printf("Error: estimate %g below threshold\n", e->v);
+                    err = TRUE;
+                }
+                diff += fabs(e->v - measure_compare(x[e->x], x[e->y]));
+            }
+            if (q->num > 0 && diff / q->num > 0.05) {
+                printf("Error: mean error %g of estimates\n",
+                       diff / q->num);
+                err = TRUE;
+            }
+
+            /* Pairs are sorted by column and row */
+            for (j = 0, l = 0; j < p->num && !err; j++) {
+                hpair_t *e = p->pairs + j;
+                if (e->v < 1)
+                    continue;
+                while (l < q->num && (q->pairs[l].x < e->x ||
+                                      (q->pairs[l].x == e->x &&
+                                       q->pairs[l].y < e->y)))
+                    l++;
+                if (l == q->num || q->pairs[l].x != e->x ||
+                    q->pairs[l].y != e->y) {
+                    printf("Error: (%d,%d) not found\n", e->x, e->y);
+                    err = TRUE;
+                }
+            }
+          next:
+            hpairs_destroy(p);
+            hpairs_destroy(q);
+            printf(".");
+        }
+        hmatrix_destroy(m);
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < JOIN_NUM; i++)
+        hstring_destroy(&x[i]);
+    config_set_bool(&cfg, "measures.join.minhash.verify", TRUE);
+    config_set_string(&cfg, "measures.join.method", "none");
+
+    return err;
+}
+
+/**
+ * Test stored MinHash signatures. Loaded signatures need to yield the
+ * same pairs as computed ones and changed strings need to invalidate the
+ * file.
+ * @param ts Array of thresholds
+ * @return error flag
+ */
+static int test_signatures(float *ts)
+{
+    char *sigs = "measures.join.minhash.signatures";
+    int i, err = FALSE;
+    hstring_t x[JOIN_NUM];
+    hpairs_t *p, *q, *r;
+    hmatrix_t *m;
+
+    printf("Testing stored signatures of 'minhash' ");
+    random_strings(x, JOIN_NUM);
+    m = hmatrix_init(x, JOIN_NUM);
+
+    /* Computed, saved and loaded signatures */
+    for (i = 0; !isnan(ts[i]) && !err; i++) {
+        config_set_float(&cfg, "measures.join.threshold", ts[i]);
+        config_set_string(&cfg, sigs, "");
+        p = run_join(m, x, "minhash", "sim_jaccard");
+        config_set_string(&cfg, sigs, "check_join.sigs");
+        q = run_join(m, x, "minhash", "sim_jaccard");
+        r = run_join(m, x, "minhash", "sim_jaccard");
+        if (!p || !q || !r || !pairs_equal(p, q) || !pairs_equal(p, r))
+            err = TRUE;
+        hpairs_destroy(p);
+        hpairs_destroy(q);
+        hpairs_destroy(r);
+        printf(".");
+    }
+
+    /* Estimates reveal signatures of strings that have changed */
+    config_set_bool(&cfg, "measures.join.minhash.verify", FALSE);
+    for (i = 0; i < 2 && !err; i++) {
+        hstring_destroy(&x[i]);
+        x[i] = hstring_init(x[i], "xyz");
+        x[i] = hstring_preproc(x[i]);
+    }
+    config_set_string(&cfg, sigs, "");
+    p = run_join(m, x, "minhash", "sim_jaccard");
+    config_set_string(&cfg, sigs, "check_join.sigs");
+    q = run_join(m, x, "minhash", "sim_jaccard");
+    if (!p || !q || !pairs_equal(p, q))
+        err = TRUE;
+    hpairs_destroy(p);
+    hpairs_destroy(q);
+    printf(". done.\n");
+
+    hmatrix_destroy(m);
+    for (i = 0; i < JOIN_NUM; i++)
+        hstring_destroy(&x[i]);
+    remove("check_join.sigs");
+    config_set_bool(&cfg, "measures.join.minhash.verify", TRUE);
+    config_set_string(&cfg, sigs, "");
+    config_set_string(&cfg, "measures.join.method", "none");
+
+    return err;
+}
+
+/**
+ * Check nearest neighbors against all pairs. Each column string needs
+ * the maximum number of neighbors and no other row string may be closer
+ * than its worst neighbor.
+ * @param m Matrix object
+ * @param x Array of strings
+ * @param p List of pairs
+ * @param k Number of neighbors
+ * @param dist Flag for distances
+ * @return true if correct, false otherwise
+ */
+static int check_neighbors(hmatrix_t *m, hstring_t *x, hpairs_t *p, int k,
+                           int dist)
+{
+    int c, r, j = 0;
+
+    for (c = m->col.start; c < m->col.end; c++) {
+        int n = 0, avail = 0, first = j;
+        float worst = -1;
+
+        for (; j < p->num && p->pairs[j].x == c; j++, n++)
+            worst = p->pairs[j].v;
+        for (r = m->row.start; r < m->row.end; r++) {
+            int listed = FALSE;
+            float v;
+            if (r == c)
+                continue;
+            avail++;
+            for (int i = first; i < j; i++)
+                listed |= p->pairs[i].y == r;
+            v = measure_compare(x[c], x[r]);
+            if (!listed && n > 0 && (dist ? v < worst : v > worst)) {
+                printf("Error: %d closer to %d than neighbors\n", r, c);
+                return FALSE;
+            }
+        }
+
+        if (n != MIN(k, avail)) {
+            printf("Error: %d neighbors of %d instead of %d\n", n, c,
+                   MIN(k, avail));
+            return FALSE;
+        }
+    }
+
+    return j == p->num;
+}
+
+/**
+ * Test nearest neighbors of a join method against the exhaustive join
+ * @param method Join method
+ * @param measure Similarity measure
+ * @param ks Array of numbers of neighbors (terminated by 0)
+ * @return error flag
+ */
+static int test_neighbors(char *method, char *measure, int *ks)
+{
+    int i, k, err = FALSE;
+    hstring_t x[JOIN_NUM];
+    hpairs_t *p, *q;
+    hmatrix_t *m;
+    char buf[64];
+
+    printf("Testing neighbors of '%s' with %s ", method, measure);
+    random_strings(x, JOIN_NUM);
+
+    for (k = 0; ranges[k].cols && !err; k++) {
+        m = hmatrix_init(x, JOIN_NUM);
+        hmatrix_col_range(m, strcpy(buf, ranges[k].cols));
+        hmatrix_row_range(m, strcpy(buf, ranges[k].rows));
+
+        for (i = 0; ks[i] > 0 && !err; i++) {
+            config_set_int(&cfg, "measures.join.neighbors", ks[i]);
+            p = run_join(m, x, "exhaustive", measure);
+            q = run_join(m, x, method, measure);
+            if (!p || !q || !pairs_equal(p, q) ||
+                !check_neighbors(m, x, p, ks[i],
+                                 !strncmp(measure, "dist_", 5)))
+                err = TRUE;
+            hpairs_destroy(p);
+            hpairs_destroy(q);
+            printf(".");
+        }
+        hmatrix_destroy(m);
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < JOIN_NUM; i++)
+        hstring_destroy(&x[i]);
+    config_set_int(&cfg, "measures.join.neighbors", 0);
+    config_set_string(&cfg, "measures.join.method", "none");
+
+    return err;
+}
+
+/**
+ * Test a stored tree while a parameter of the measure changes. All runs
+ * share one tree file, such that a tree built for a different value of
+ * the parameter must not be reused.
+ * @param measure Similarity measure
+ * @param param Integer parameter of the measure
+ * @param vals Array of values (terminated by 0)
+ * @return error flag
+ */
+static int test_stored(char *measure, char *param, int *vals)
+{
+    int i, err = FALSE;
+    hstring_t x[JOIN_NUM];
+    hpairs_t *p, *q;
+    hmatrix_t *m;
+
+    printf("Testing stored trees with %s ", measure);
+    random_strings(x, JOIN_NUM);
+    config_set_string(&cfg, "measures.join.tree.file", "check_join.tree");
+    config_set_int(&cfg, "measures.join.neighbors", 3);
+
+    m = hmatrix_init(x, JOIN_NUM);
+    for (i = 0; vals[i] > 0 && !err; i++) {
+        config_set_int(&cfg, param, vals[i]);
+        vcache_destroy();
+        vcache_init();
+        p = run_join(m, x, "exhaustive", measure);
+        q = run_join(m, x, "tree", measure);
+        if (!p || !q || !pairs_equal(p, q))
+            err = TRUE;
+        hpairs_destroy(p);
+        hpairs_destroy(q);
+        printf(".");
+    }
+    hmatrix_destroy(m);
+    printf(" done.\n");
+
+    for (i = 0; i < JOIN_NUM; i++)
+        hstring_destroy(&x[i]);
+    remove("check_join.tree");
+    config_set_string(&cfg, "measures.join.tree.file", "");
+    config_set_int(&cfg, "measures.join.neighbors", 0);
+    config_set_string(&cfg, "measures.join.method", "none");
+
+    return err;
+}
+
+/**
+ * Test the recall of an approximate method for nearest neighbors. A
+ * neighbor is correct if it is as close as the k-th exact neighbor.
+ * @param method Join method
+ * @param measure Similarity measure
+ * @param ks Array of numbers of neighbors (terminated by 0)
+ * @param min Minimum recall
+ * @return error flag
+ */
+static int test_recall(char *method, char *measure, int *ks, float min)
+{
+    int i, k, err = FALSE, dist = !strncmp(measure, "dist_", 5);
+    hstring_t x[JOIN_NUM];
+    hpairs_t *p, *q;
+    hmatrix_t *m;
+    char buf[64];
+
+    printf("Testing recall of '%s' with %s ", method, measure);
+    random_strings(x, JOIN_NUM);
+
+    for (k = 0; ranges[k].cols && !err; k++) {
+        m = hmatrix_init(x, JOIN_NUM);
+        hmatrix_col_range(m, strcpy(buf, ranges[k].cols));
+        hmatrix_row_range(m, strcpy(buf, ranges[k].rows));
+
+        for (i = 0; ks[i] > 0 && !err; i++) {
+            long hits = 0;
+            int a = 0, b = 0;
+
+            config_set_int(&cfg, "measures.join.neighbors", ks[i]);
+            p = run_join(m, x, "exhaustive", measure);
+            q = run_join(m, x, method, measure);
+            if (!p || !q || p->num != q->num) {
+                err = TRUE;
+                goto next;
+            }
+
+            /* Pairs are sorted by column and rank */
+            while (a < p->num) {
+                int c = p->pairs[a].x;
+                float worst = 0;
+
+                for (; a < p->num && p->pairs[a].x == c; a++)
+                    worst = p->pairs[a].v;
+                for (; b < q->num && q->pairs[b].x == c; b++)
+                    hits += dist ? q->pairs[b].v <= worst :
+                        q->pairs[b].v >= worst;
+            }
+
+            if (hits < min * p->num) {
+                printf("Error: recall %.3f below %.3f\n",
+                       (double) hits / p->num, min);
+                err = TRUE;
+            }
+          next:
+            hpairs_destroy(p);
+            hpairs_destroy(q);
+            printf(".");
+        }
+        hmatrix_destroy(m);
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < JOIN_NUM; i++)
+        hstring_destroy(&x[i]);
+    config_set_int(&cfg, "measures.join.neighbors", 0);
+    config_set_string(&cfg, "measures.join.method", "none");
+
+    return err;
+}
+
+/**
+ * Main test function
+ */
+int main(int argc, char **argv)
+{
+    int err = FALSE;
+    float lev[] = { 0, 1, 2, 3, 5, NAN };
+    float sim[] = { 0.3, 0.5, 0.8, 1, NAN };
+    float one[] = { 1, NAN };
+    float bits[] = { 0, 3, 8, 20, NAN };
+    float wide[] = { 60, 400, NAN };
+    float jaro[] = { 0, 0.05, 0.1, 0.2, 0.3, NAN };
+    int ks[] = { 1, 3, 10, 0 };
+    int degs[] = { 3, 3, 1, 5, 0 };
+    char *coefs[] = { "sim_jaccard", "sim_dice", "sim_otsuka", "sim_braun",
+        "sim_simpson", "sim_kulczynski", "sim_sokal", NULL
+    };
+    int i;
+
+    config_init(&cfg);
+    config_check(&cfg);
+    vcache_init();
+
+    err |= test_method("passjoin", "dist_levenshtein", lev);
+
+    /* Prefix filtering for coefficients on bytes and tokens */
+    config_set_string(&cfg, "measures.sim_coefficient.matching", "bin");
+    for (i = 0; coefs[i] && !err; i++)
+        err |= test_method("prefix", coefs[i], sim);
+
+    config_set_string(&cfg, "measures.granularity", "tokens");
+    hstring_delim_set("a");
+    for (i = 0; coefs[i] && !err; i++)
+        err |= test_method("prefix", coefs[i], sim);
+
+    /* Identical sets are always found by locality sensitive hashing */
+    err |= test_method("minhash", "sim_jaccard", one);
+    config_set_string(&cfg, "measures.granularity", "bytes");
+    err |= test_method("minhash", "sim_jaccard", one);
+    err |= test_estimate(sim);
+    err |= test_signatures(sim);
+
+    /* Multi-index hashing on bytes and bits */
+    err |= test_method("mih", "dist_hamming", lev);
+    err |= test_method("mih", "dist_hamming", wide);
+    config_set_string(&cfg, "measures.granularity", "bits");
+    err |= test_method("mih", "dist_hamming", bits);
+    err |= test_method("mih", "dist_hamming", wide);
+    config_set_int(&cfg, "measures.join.mih.substrings", 8);
+    err |= test_method("mih", "dist_hamming", bits);
+    config_set_int(&cfg, "measures.join.mih.substrings", 0);
+    config_set_string(&cfg, "measures.granularity", "bytes");
+
+    /* Length and count filters for Jaro on bytes and tokens */
+    err |= test_method("jaro", "dist_jaro", jaro);
+    err |= test_method("jaro", "dist_jarowinkler", jaro);
+    config_set_string(&cfg, "measures.granularity", "tokens");
+    err |= test_method("jaro", "dist_jarowinkler", jaro);
+    config_set_string(&cfg, "measures.granularity", "bytes");
+
+    /* Metric trees for ranges and neighbors */
+    err |= test_method("tree", "dist_levenshtein", lev);
+    err |= test_method("tree", "dist_damerau", lev);
+    err |= test_method("tree", "dist_bag", lev);
+    err |= test_neighbors("exhaustive", "sim_jaccard", ks);
+    err |= test_neighbors("tree", "dist_levenshtein", ks);
+    config_set_string(&cfg, "measures.join.tree.type", "vp");
+    err |= test_neighbors("tree", "dist_levenshtein", ks);
+    config_set_string(&cfg, "measures.join.tree.file", "check_join.tree");
+    err |= test_neighbors("tree", "dist_hamming", ks);
+    err |= test_neighbors("tree", "dist_hamming", ks);
+    remove("check_join.tree");
+    config_set_string(&cfg, "measures.join.tree.file", "");
+    config_set_string(&cfg, "measures.join.tree.type", "auto");
+
+    /* Stored trees with a changing parameter of the kernel */
+    config_set_bool(&cfg, "measures.dist_kernel.squared", FALSE);
+    err |= test_stored("dist_kernel", "measures.kern_wdegree.degree", degs);
+    config_set_int(&cfg, "measures.kern_wdegree.degree", 3);
+    config_set_bool(&cfg, "measures.dist_kernel.squared", TRUE);
+
+    /* Pivot pruning with many and few pivots */
+    err |= test_method("pivot", "dist_levenshtein", lev);
+    err |= test_method("pivot", "dist_damerau", lev);
+    err |= test_neighbors("pivot", "dist_levenshtein", ks);
+    err |= test_neighbors("pivot", "dist_bag", ks);
+    config_set_int(&cfg, "measures.join.pivot.pivots", 1);
+    err |= test_method("pivot", "dist_hamming", lev);
+    err |= test_neighbors("pivot", "dist_hamming", ks);
+    config_set_int(&cfg, "measures.join.pivot.pivots", 16);
+
+    /* NN-descent for metric and non-metric measures */
+    err |= test_recall("nndescent", "dist_levenshtein", ks, 0.9);
+    err |= test_recall("nndescent", "sim_jaccard", ks, 0.9);
+    err |= test_recall("nndescent", "dist_compression", ks, 0.9);
+
+    vcache_destroy();
+    config_destroy(&cfg);
+    return err;
+}
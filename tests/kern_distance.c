@@ -19,6 +19,7 @@
 
 /* Global variables */
 int verbose = 0;
+int log_line = 0;
 config_t cfg;
 
 /*
@@ -98,6 +99,79 @@ int test_compare()
     return err;
 }
 
+/* Number of strings for sweep test */
+#define SWEEP_NUM       20
+
+/*
+ * Variants of sweep test
+ */
+struct sweep_test
+{
+    char *t;            /**< Type */
+    double g;           /**< Gamma */
+    double d;           /**< Degree */
+    char *n;            /**< Norm */
+} sweeps[] = {
+    {"linear", 1.0, 1.0, "none"},
+    {"rbf", 0.1, 1.0, "none"},
+    {"poly", 0.01, 2.0, "l2"},
+    {"neg", 1.0, 1.5, "none"},
+    {"linear", 1.0, 1.0, "l2"},
+    {NULL}
+};
+
+/**
+ * Configure a variant of the sweep test
+ * @param k Index of variant
+ * @return false, as no variant is complemented
+ */
+static int sweep_variant(int k)
+{
+    config_set_string(&cfg, "measures.kern_distance.type", sweeps[k].t);
+    config_set_float(&cfg, "measures.kern_distance.gamma", sweeps[k].g);
+    config_set_float(&cfg, "measures.kern_distance.degree", sweeps[k].d);
+    config_set_string(&cfg, "measures.kern_distance.norm", sweeps[k].n);
+    measure_config("kern_distance");
+    vcache_destroy();
+    vcache_init();
+    return FALSE;
+}
+
+/**
+ * Test variants of a sweep against the direct computation
+ * @return error flag
+ */
+int test_sweep()
+{
+    int i, j, k, err;
+    hstring_t x[SWEEP_NUM];
+    char buf[64];
+
+    printf("Testing sweep of distance substitution kernel ");
+
+    srand(4711);
+    for (i = 0; i < SWEEP_NUM; i++) {
+        for (j = 0, k = rand() % 20; j < k; j++)
+            buf[j] = "abc"[rand() % 3];
+        buf[k] = 0;
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+    }
+
+    config_set_string(&cfg, "measures.kern_distance.dist", "levenshtein");
+    err = check_sweep("kern_distance", "type=linear; "
+                      "type=rbf,gamma=0.1; "
+                      "type=poly,gamma=0.01,degree=2,norm=l2; "
+                      "type=neg,degree=1.5; type=linear,norm=l2", 5,
+                      sweep_variant, x, SWEEP_NUM, 1e-6);
+    printf(" done.\n");
+
+    for (i = 0; i < SWEEP_NUM; i++)
+        hstring_destroy(&x[i]);
+
+    return err;
+}
+
 /**
  * Main test function
  */
@@ -111,6 +185,7 @@ int main(int argc, char **argv)
     vcache_init();
 
     err |= test_compare();
+    err |= test_sweep();
 
     vcache_destroy();
 
@@ -14,13 +14,18 @@
 #include "hconfig.h"
 #include "util.h"
 #include "measures.h"
+#include "hmatrix.h"
 #include "tests.h"
 #include "vcache.h"
 
 /* Global variables */
 int verbose = 0;
+int log_line = 0;
 config_t cfg;
 
+/* Number of strings for matrix tests */
+#define MATRIX_NUM      100
+
 #define LAM (0.5)
 #define LAM2 (LAM * LAM)
 #define LAM4 (LAM2 * LAM2)
@@ -105,6 +110,92 @@ int test_compare()
     return err;
 }
 
+/**
+ * Test the computation of a full matrix using the inverted index
+ * @param error flag
+ */
+int test_matrix()
+{
+    char *norms[] = { "none", "l2", NULL };
+    char *ranges[][2] = { {"", ""}, {"0:40", "30:100"}, {NULL} };
+    int i, j, k, l, err = FALSE;
+    hstring_t x[MATRIX_NUM];
+    hmatrix_t *mat;
+    char buf[64];
+
+    printf("Testing spectrum kernel matrix ");
+
+    config_set_string(&cfg, "measures.granularity", "bytes");
+    config_set_int(&cfg, "measures.kern_spectrum.length", 2);
+    srand(4711);
+    for (i = 0; i < MATRIX_NUM; i++) {
+        for (j = 0, k = rand() % 30; j < k; j++)
+            buf[j] = "abcd"[rand() % 4];
+        buf[k] = 0;
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+    }
+
+    for (l = 0; norms[l] && !err; l++) {
+        config_set_string(&cfg, "measures.kern_spectrum.norm", norms[l]);
+        measure_config("kern_spectrum");
+
+        for (k = 0; ranges[k][0] && !err; k++) {
+            mat = hmatrix_init(x, MATRIX_NUM);
+            /* Ranges are modified during parsing */
+            hmatrix_col_range(mat, strcpy(buf, ranges[k][0]));
+            hmatrix_row_range(mat, strcpy(buf, ranges[k][1]));
+            hmatrix_alloc(mat);
+
+            if (!measure_compare_all(mat, x)) {
+                printf("Error: no matrix computed\n");
+                err = TRUE;
+            }
+
+            for (i = mat->col.start; i < mat->col.end && !err; i++) {
+                for (j = mat->row.start; j < mat->row.end && !err; j++) {
+                    float d = measure_compare(x[i], x[j]);
+                    float e = hmatrix_get(mat, i, j);
+                    if (!(d == e || (isnan(d) && isnan(e)))) {
+                        printf("Error %f != %f\n", e, d);
+                        err = TRUE;
+                    }
+                }
+            }
+            hmatrix_destroy(mat);
+            printf(".");
+        }
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < MATRIX_NUM; i++)
+        hstring_destroy(&x[i]);
+    config_set_string(&cfg, "measures.kern_spectrum.norm", "none");
+
+    return err;
+}
+
+/**
+ * Test the skipping of disjoint strings using signatures
+ * @return error flag
+ */
+int test_signature()
+{
+    char *measures[] = { "kern_spectrum", NULL };
+    char *norms[] = { "none", "l2", NULL };
+    int err;
+
+    printf("Testing signatures of spectrum kernel ");
+
+    config_set_string(&cfg, "measures.granularity", "bytes");
+    config_set_int(&cfg, "measures.kern_spectrum.length", 2);
+    err = check_signature(measures, "measures.kern_spectrum.norm", norms);
+    printf(" done.\n");
+
+    config_set_string(&cfg, "measures.kern_spectrum.norm", "none");
+    return err;
+}
+
 /**
  * Main test function
  */
@@ -118,6 +209,8 @@ int main(int argc, char **argv)
     vcache_init();
 
     err |= test_compare();
+    err |= test_matrix();
+    err |= test_signature();
 
     vcache_destroy();
 
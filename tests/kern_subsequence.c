@@ -19,6 +19,7 @@
 
 /* Global variables */
 int verbose = 0;
+int log_line = 0;
 config_t cfg;
 
 #define LAM (0.5)
@@ -14,12 +14,23 @@
 #include "hconfig.h"
 #include "util.h"
 #include "measures.h"
+#include "hmatrix.h"
 #include "tests.h"
 
 /* Global variables */
 int verbose = 0;
+int log_line = 0;
 config_t cfg;
 
+/* Number of strings for matrix tests */
+#define MATRIX_NUM      100
+
+/* Similarity coefficients */
+char *coefs[] = {
+    "sim_braun", "sim_dice", "sim_jaccard", "sim_kulczynski",
+    "sim_otsuka", "sim_simpson", "sim_sokal", NULL
+};
+
 /*
  * Structure for testing string kernels/distances
  */
@@ -87,6 +98,140 @@ int test_compare()
     return err;
 }
 
+/**
+ * Create random strings for the matrix tests
+ * @param x Array of strings
+ */
+static void strings_create(hstring_t *x)
+{
+    int i, j, k;
+    char buf[64];
+
+    srand(4711);
+    for (i = 0; i < MATRIX_NUM; i++) {
+        for (j = 0, k = rand() % 30; j < k; j++)
+            buf[j] = "abcdefgh"[rand() % 8];
+        buf[k] = 0;
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+    }
+}
+
+/**
+ * Test the computation of a full matrix using posting lists
+ * @return error flag
+ */
+int test_matrix()
+{
+    char *modes[] = { "bin", "cnt", NULL };
+    char *ranges[][2] = { {"", ""}, {"0:40", "30:100"}, {NULL} };
+    int i, j, k, l, m, err = FALSE;
+    hstring_t x[MATRIX_NUM];
+    hmatrix_t *mat;
+    char buf[64];
+
+    printf("Testing coefficient matrices ");
+    strings_create(x);
+
+    for (l = 0; modes[l] && !err; l++) {
+        config_set_string(&cfg, "measures.sim_coefficient.matching",
+                          modes[l]);
+        for (m = 0; coefs[m] && !err; m++) {
+            measure_config(coefs[m]);
+
+            for (k = 0; ranges[k][0] && !err; k++) {
+                mat = hmatrix_init(x, MATRIX_NUM);
+                /* Ranges are modified during parsing */
+                hmatrix_col_range(mat, strcpy(buf, ranges[k][0]));
+                hmatrix_row_range(mat, strcpy(buf, ranges[k][1]));
+                hmatrix_alloc(mat);
+
+                if (!measure_compare_all(mat, x)) {
+                    printf("Error: no matrix computed\n");
+                    err = TRUE;
+                }
+
+                for (i = mat->col.start; i < mat->col.end && !err; i++) {
+                    for (j = mat->row.start; j < mat->row.end && !err;
+                         j++) {
+                        float d = measure_compare(x[i], x[j]);
+                        float e = hmatrix_get(mat, i, j);
+                        if (!(d == e || (isnan(d) && isnan(e)))) {
+                            printf("Error %s: %f != %f\n", coefs[m], e, d);
+                            err = TRUE;
+                        }
+                    }
+                }
+                hmatrix_destroy(mat);
+            }
+            printf(".");
+        }
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < MATRIX_NUM; i++)
+        hstring_destroy(&x[i]);
+
+    return err;
+}
+
+/**
+ * Configure a variant of the sweep test
+ * @param k Index of variant
+ * @return false, as no variant is complemented
+ */
+static int sweep_variant(int k)
+{
+    measure_config(coefs[k]);
+    return FALSE;
+}
+
+/**
+ * Test a sweep over all coefficients against the direct computation
+ * @return error flag
+ */
+int test_sweep()
+{
+    char *modes[] = { "bin", "cnt", NULL };
+    int i, l, err = FALSE;
+    hstring_t x[MATRIX_NUM];
+
+    printf("Testing sweep of coefficients ");
+    strings_create(x);
+
+    for (l = 0; modes[l] && !err; l++) {
+        config_set_string(&cfg, "measures.sim_coefficient.matching",
+                          modes[l]);
+        err |= check_sweep("sim_jaccard", "coef=braun; coef=dice; "
+                           "coef=jaccard; coef=kulczynski; coef=otsuka; "
+                           "coef=simpson; coef=sim_sokal", 7,
+                           sweep_variant, x, MATRIX_NUM, 0);
+    }
+    printf(" done.\n");
+
+    for (i = 0; i < MATRIX_NUM; i++)
+        hstring_destroy(&x[i]);
+
+    return err;
+}
+
+/**
+ * Test the skipping of disjoint strings using signatures
+ * @return error flag
+ */
+int test_signature()
+{
+    char *modes[] = { "bin", "cnt", NULL };
+    int err;
+
+    printf("Testing signatures of coefficients ");
+    err = check_signature(coefs, "measures.sim_coefficient.matching",
+                          modes);
+    printf(" done.\n");
+
+    return err;
+}
+
 /**
  * Main test function
  */
@@ -98,6 +243,9 @@ int main(int argc, char **argv)
     config_check(&cfg);
 
     err |= test_compare();
+    err |= test_matrix();
+    err |= test_sweep();
+    err |= test_signature();
 
     config_destroy(&cfg);
     return err;
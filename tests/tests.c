@@ -0,0 +1,148 @@
+/*
+ * Harry - A Tool for Measuring String Similarity
+ * Copyright (C) 2013-2015 Konrad Rieck (konrad@mlsec.org)
+ * --
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 3 of the License, or (at your
+ * option) any later version.  This program is distributed without any
+ * warranty. See the GNU General Public License for more details.
+ */
+
+#include "config.h"
+#include "common.h"
+#include "util.h"
+#include "measures.h"
+#include "hmatrix.h"
+#include "sweep.h"
+#include "tests.h"
+
+/* External variables */
+extern config_t cfg;
+
+/* Number of strings for signature tests */
+#define SIG_NUM         50
+
+/**
+ * Check the variants of a sweep against the direct computation. The
+ * sweep is computed in one pass with the configured measure and each
+ * variant is compared with the measure configured by a callback.
+ * @param measure Name of measure
+ * @param sweep Variants of sweep
+ * @param num Number of variants
+ * @param variant Callback configuring a variant, returns true if the
+ *        variant is the complement of the measure
+ * @param x Array of strings
+ * @param n Number of strings
+ * @param tol Tolerance of values
+ * @return error flag
+ */
+int check_sweep(char *measure, char *sweep, int num, int (*variant) (int),
+                hstring_t *x, int n, double tol)
+{
+    int i, j, k, c, err = FALSE;
+    hmatrix_t *mat, var;
+
+    config_set_string(&cfg, "measures.sweep", sweep);
+    measure_config(measure);
+
+    mat = hmatrix_init(x, n);
+    hmatrix_alloc(mat);
+    if (sweep_init(measure) != num) {
+        printf("Error parsing sweep\n");
+        err = TRUE;
+        goto out;
+    }
+    sweep_compute(mat, x);
+
+    for (k = 0; k < num && !err; k++) {
+        var = *mat;
+        var.values = sweep_apply(mat, k);
+        c = variant(k);
+
+        for (i = 0; i < n && !err; i++) {
+            for (j = i; j < n && !err; j++) {
+                float d = measure_compare(x[i], x[j]);
+                float e = hmatrix_get(&var, i, j);
+                if (c)
+                    d = 1 - d;
+                if (!(fabs(d - e) <= tol || (isnan(d) && isnan(e)))) {
+                    printf("Error %s: %f != %f\n", sweep_desc(k), e, d);
+                    err = TRUE;
+                }
+            }
+        }
+        free(var.values);
+        printf(".");
+    }
+    sweep_destroy();
+
+  out:
+    hmatrix_destroy(mat);
+    config_set_string(&cfg, "measures.sweep", "");
+    return err;
+}
+
+/**
+ * Check the skipping of disjoint strings using signatures. Random short
+ * strings are preprocessed with and without signatures and the values of
+ * each measure are compared for all values of a parameter, including the
+ * batch interface.
+ * @param measures Names of measures (NULL terminated)
+ * @param param Parameter of measures
+ * @param values Values of parameter (NULL terminated)
+ * @return error flag
+ */
+int check_signature(char **measures, char *param, char **values)
+{
+    int i, j, k, l, m, err = FALSE;
+    hstring_t x[SIG_NUM], z[SIG_NUM];
+    float out[SIG_NUM];
+    char buf[64];
+
+    /* Strings x are preprocessed with and z without signatures */
+    config_set_int(&cfg, "measures.signature", 64);
+    measure_config(measures[0]);
+    srand(4711);
+    for (i = 0; i < SIG_NUM; i++) {
+        for (j = 0, k = rand() % 8; j < k; j++)
+            buf[j] = 'a' + rand() % 26;
+        buf[k] = 0;
+        x[i] = hstring_init(x[i], buf);
+        x[i] = hstring_preproc(x[i]);
+        z[i] = hstring_init(z[i], buf);
+    }
+    config_set_int(&cfg, "measures.signature", 0);
+    measure_config(measures[0]);
+    for (i = 0; i < SIG_NUM; i++)
+        z[i] = hstring_preproc(z[i]);
+
+    for (l = 0; values[l] && !err; l++) {
+        config_set_string(&cfg, param, values[l]);
+        for (m = 0; measures[m] && !err; m++) {
+            measure_config(measures[m]);
+
+            for (i = 0; i < SIG_NUM && !err; i++) {
+                measure_compare_batch(x[i], x, SIG_NUM, out);
+                for (j = 0; j < SIG_NUM && !err; j++) {
+                    float d = measure_compare(z[i], z[j]);
+                    float e = measure_compare(x[i], x[j]);
+                    if (!(d == e || (isnan(d) && isnan(e))) ||
+                        !(d == out[j] || (isnan(d) && isnan(out[j])))) {
+                        printf("Error %s (%s): %f != %f\n", measures[m],
+                               values[l], e, d);
+                        err = TRUE;
+                    }
+                }
+            }
+            printf(".");
+        }
+    }
+
+    for (i = 0; i < SIG_NUM; i++) {
+        hstring_destroy(&x[i]);
+        hstring_destroy(&z[i]);
+    }
+
+    return err;
+}
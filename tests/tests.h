@@ -12,6 +12,8 @@
 #ifndef TESTS_H
 #define TESTS_H
 
+#include "hstring.h"
+
 /* Macros for faking a configuration */
 #define config_set_string(c,x,s) \
       config_setting_set_string(config_lookup(c,x),s)
@@ -19,5 +21,12 @@
       config_setting_set_int(config_lookup(c,x),s)
 #define config_set_float(c,x,s) \
       config_setting_set_float(config_lookup(c,x),s)
+#define config_set_bool(c,x,s) \
+      config_setting_set_bool(config_lookup(c,x),s)
+
+/* Shared checks of measures */
+int check_sweep(char *, char *, int, int (*)(int), hstring_t *, int,
+                double);
+int check_signature(char **, char *, char **);
 
 #endif /* TESTS_H */
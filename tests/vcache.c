@@ -18,6 +18,7 @@
 
 /* Global variables */
 int verbose = 1;
+int log_line = 0;
 config_t cfg;
 
 /** 